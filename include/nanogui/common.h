@@ -178,6 +178,7 @@ class ColorWheel;
 class ColorPicker;
 class ComboBox;
 class GLFramebuffer;
+class GLRenderTexture;
 class GLShader;
 class GridLayout;
 class GroupLayout;
@@ -190,14 +191,18 @@ class Popup;
 class PopupButton;
 class ProgressBar;
 class Screen;
+class SdfFont;
+class SdfTextRenderer;
 class Serializer;
 class Slider;
 class StackedWidget;
 class TabHeader;
 class TabWidget;
 class TextBox;
+class TextureManager;
 class Theme;
 class ToolButton;
+class VideoView;
 class VScrollPanel;
 class Widget;
 class Window;
@@ -279,6 +284,9 @@ extern NANOGUI_EXPORT void chdir_to_bundle_parent();
  */
 extern NANOGUI_EXPORT std::array<char, 8> utf8(int c);
 
+/// Return the paths of all PNG images in a directory
+extern NANOGUI_EXPORT std::vector<std::string> listImageDirectory(const std::string &path);
+
 /// Load a directory of PNG images and upload them to the GPU (suitable for use with ImagePanel)
 extern NANOGUI_EXPORT std::vector<std::pair<int, std::string>>
     loadImageDirectory(NVGcontext *ctx, const std::string &path);
@@ -16,11 +16,96 @@
 #include <nanogui/textbox.h>
 #include <sstream>
 #include <deque>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <regex>
+#include <unordered_map>
 
 NAMESPACE_BEGIN(nanogui)
 
 class Console;
 
+NAMESPACE_BEGIN(detail)
+
+/// Scrollback storage, shared between a console and its background search jobs
+struct ConsoleHistory {
+    std::mutex mutex;
+    std::vector<std::string> lines;
+
+    /* Optional trigram index: maps three lowercase characters to the
+       (ascending) list of lines containing them */
+    bool indexed = false;
+    size_t indexedLines = 0;
+    std::unordered_map<uint32_t, std::vector<int>> trigrams;
+};
+
+/// State of a search job that scans the lines [begin, end) of the history
+struct ConsoleSearch {
+    std::string pattern;
+    std::regex regex;
+    bool useRegex = false;
+    bool caseSensitive = false;
+    int begin = 0, end = 0;
+
+    std::atomic<bool> cancelled { false };
+    std::atomic<bool> finished { false };
+
+    /* Matches found by the worker which were not yet picked up by the console */
+    std::mutex mutex;
+    std::vector<int> pending;
+};
+
+NAMESPACE_END(detail)
+
+/**
+ * \brief A command submitted on the console's command line
+ *
+ * Instances are handed to \ref ConsoleInterpreter::execute() on a worker
+ * thread. Output written via \ref print() is streamed back to the console,
+ * which appends it to the scrollback on the UI thread.
+ */
+class NANOGUI_EXPORT ConsoleCommand {
+    friend class Console;
+public:
+    ConsoleCommand(const std::string &command) : mCommand(command) { }
+
+    /// Return the command line as entered by the user
+    const std::string &command() const { return mCommand; }
+
+    /// Write a line of output to the console (may be called from any thread)
+    void print(const std::string &text);
+
+    /// Return whether the user cancelled the command (long-running commands should check this regularly)
+    bool cancelled() const { return mCancelled; }
+
+    /// Return whether the command has finished executing
+    bool finished() const { return mFinished; }
+
+protected:
+    std::string mCommand;
+    std::atomic<bool> mCancelled { false };
+    std::atomic<bool> mFinished { false };
+    std::mutex mMutex;
+    std::string mOutput;
+};
+
+/**
+ * \brief Interface for command interpreters attached to a \ref Console
+ *
+ * \ref execute() runs on the shared \ref ThreadPool so that slow commands
+ * never block rendering. Implementations must not touch widgets or NanoVG
+ * state from there; all output goes through \ref ConsoleCommand::print().
+ */
+class NANOGUI_EXPORT ConsoleInterpreter : public Object {
+public:
+    /// Execute a command (invoked on a worker thread)
+    virtual void execute(ConsoleCommand &command) = 0;
+
+protected:
+    virtual ~ConsoleInterpreter() { }
+};
+
 class Caret {
 public:
     Caret(Console *console) :
@@ -100,8 +185,83 @@ public:
     //                                const NVGglyphPosition *glyphs, int size);
     //bool Console::focusEvent(bool focused);
     void drawCursor(NVGcontext* ctx, Vector2i origin);
+
+    /// Append text to the scrollback (it is split into separate lines at '\n')
+    void append(const std::string &text);
+
+    /// Return the number of lines in the scrollback
+    int lineCount() const;
+
+    /**
+     * \brief Search the scrollback for a substring or regular expression
+     *
+     * The search runs on the shared \ref ThreadPool and processes the
+     * history in chunks; matches show up incrementally via \ref searchMatches()
+     * and the search callback. Lines appended while a search is active are
+     * matched as well. Returns \c false if \c pattern is not a valid
+     * regular expression.
+     */
+    bool search(const std::string &pattern, bool regex = false,
+                bool caseSensitive = false);
+
+    /// Cancel the current search and remove all highlights
+    void clearSearch();
+
+    /// Return whether a search is currently active
+    bool searchActive() const { return (bool) mSearch; }
+
+    /// Return the (ascending) indices of all history lines found so far
+    const std::vector<int> &searchMatches() const { return mSearchMatches; }
+
+    /// Return whether only matching lines are shown
+    bool filter() const { return mFilter; }
+    /// Show only lines matching the current search
+    void setFilter(bool filter);
+
+    /// Return whether the trigram index is maintained
+    bool indexed() const { return mHistory->indexed; }
+    /**
+     * \brief Maintain a trigram index over the history
+     *
+     * The index is built lazily by the next search and extended as lines
+     * are appended. Substring queries with at least three characters then
+     * only need to verify the candidate lines, which makes repeated searches
+     * over a large static history almost free. Regular expressions always
+     * scan the full history.
+     */
+    void setIndexed(bool indexed);
+
+    /// Set a callback that is invoked when new matches arrive (number of matches, search finished?)
+    std::function<void(int, bool)> searchCallback() const { return mSearchCallback; }
+    void setSearchCallback(const std::function<void(int, bool)> &callback) { mSearchCallback = callback; }
+
+    /// Return the interpreter that executes commands entered on the command line
+    ConsoleInterpreter *interpreter() { return mInterpreter; }
+    /// Set the interpreter that executes commands entered on the command line
+    void setInterpreter(ConsoleInterpreter *interpreter) { mInterpreter = interpreter; }
+
+    /// Run a command in the background as if it was entered on the command line
+    void execute(const std::string &command);
+
+    /// Return whether a command is currently running
+    bool commandPending() const { return (bool) mPendingCommand; }
+
+    /// Ask the currently running command to stop
+    void cancelCommand();
+
     friend class Caret; 
 protected:
+    virtual ~Console();
+
+    /// Append output of the running command and check whether it finished
+    void updateCommand();
+    /// Position the view so that the last line and the command line are visible
+    void scrollToBottom(NVGcontext *ctx, float linew);
+
+    /// Pick up matches from the background search and schedule a search of newly appended lines
+    void updateSearch();
+    void launchSearch(int begin, int end);
+    void refreshBuffer();
 
     bool mCommitted;
     float mScroll;
@@ -118,8 +278,10 @@ struct BufferRow{
 };
 
     std::deque<std::string>  mBuffer;
+    // history line shown in each buffer row (-1 for the command line)
+    std::deque<int> mBufferLine;
     //std::deque<BufferRow>  mBuffer;
-    std::vector<std::string> mHistory;
+    std::shared_ptr<detail::ConsoleHistory> mHistory;
     std::vector<std::string> mCommand;
     std::vector<std::string> mCommandHistory;
 
@@ -141,6 +303,17 @@ struct BufferRow{
     Vector2i mMouseDragPos;
     
     int mMouseDownModifier;
+
+    std::shared_ptr<detail::ConsoleSearch> mSearch;
+    std::vector<int> mSearchMatches;
+    std::function<void(int, bool)> mSearchCallback;
+    bool mSearchDone;
+    bool mFilter;
+
+    ref<ConsoleInterpreter> mInterpreter;
+    std::shared_ptr<ConsoleCommand> mPendingCommand;
+    // keep the command line in view when new lines are appended
+    bool mFollow;
 };
 
 NAMESPACE_END(nanogui)
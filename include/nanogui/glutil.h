@@ -14,6 +14,8 @@
 #include <nanogui/opengl.h>
 #include <Eigen/Geometry>
 #include <map>
+#include <memory>
+#include <unordered_map>
 
 namespace half_float { class half; }
 
@@ -31,6 +33,7 @@ template <> struct type_traits<double> { enum { type = GL_DOUBLE, integral = 0 }
 template <> struct type_traits<float> { enum { type = GL_FLOAT, integral = 0 }; };
 template <> struct type_traits<half_float::half> { enum { type = GL_HALF_FLOAT, integral = 0 }; };
 template <typename T> struct serialization_helper;
+struct PendingProgram;
 NAMESPACE_END(detail)
 
 using Eigen::Quaternionf;
@@ -49,13 +52,53 @@ public:
     /// Create an unitialized OpenGL shader
     GLShader()
         : mVertexShader(0), mFragmentShader(0), mGeometryShader(0),
-          mProgramShader(0), mVertexArrayObject(0) { }
+          mProgramShader(0), mVertexArrayObject(0), mLoadedFromCache(false),
+          mSharedProgram(false) { }
 
     /// Initialize the shader using the specified source strings
     bool init(const std::string &name, const std::string &vertex_str,
               const std::string &fragment_str,
               const std::string &geometry_str = "");
 
+    /**
+     * \brief Start compiling the shader without waiting for the result
+     *
+     * All stages are submitted and the program is linked right away, but
+     * errors are only reported once compilation finishes: \ref ready() (or
+     * \ref bind()) then throws like \ref init() instead of returning
+     * \c true, and the shader is left without a program. Initializing
+     * many shaders this way before polling any of them lets the driver
+     * compile them in parallel (see \ref parallelCompileSupported()), while
+     * the application keeps drawing, e.g. a loading indicator. \ref bind()
+     * waits for compilation to finish. Returns \c false if the vertex or
+     * fragment source is empty.
+     */
+    bool initAsync(const std::string &name, const std::string &vertex_str,
+                   const std::string &fragment_str,
+                   const std::string &geometry_str = "");
+
+    /**
+     * \brief Return whether a shader started by \ref initAsync() can be used
+     *
+     * Without KHR_parallel_shader_compile, this waits for the compiler.
+     * Throws \c std::runtime_error if compilation or linking failed.
+     */
+    bool ready();
+
+    /// Return whether the driver compiles shaders in the background (KHR_parallel_shader_compile)
+    static bool parallelCompileSupported();
+
+    /**
+     * \brief Initialize the shader with the program of another one instead
+     * of compiling it again
+     *
+     * Attribute buffers are separate, but uniform values are program state
+     * and thus shared, so they need to be set before every draw call. The
+     * other shader must be fully initialized and outlive this one, whose
+     * \ref free() leaves the program alone. See \ref Screen::sharedShader().
+     */
+    void initShared(const GLShader &other);
+
     /// Initialize the shader using the specified files on disk
     bool initFromFiles(const std::string &name,
                        const std::string &vertex_fname,
@@ -65,6 +108,22 @@ public:
     /// Return the name of the shader
     const std::string &name() const { return mName; }
 
+    /**
+     * \brief Set a directory in which linked programs are cached across runs
+     * (empty: no caching, the default)
+     *
+     * The directory must exist. A program is stored under a hash of its
+     * sources (including definitions) and the vendor, renderer and version
+     * strings of the driver. \ref init() loads it from there instead of
+     * compiling the sources, which it falls back to if the driver does not
+     * support program binaries or rejects the cached one.
+     */
+    static void setBinaryCacheDirectory(const std::string &path);
+    static const std::string &binaryCacheDirectory();
+
+    /// Return whether the last \ref init() loaded the program from the binary cache
+    bool loadedFromCache() const { return mLoadedFromCache; }
+
     /// Set a preprocessor definition
     void define(const std::string &key, const std::string &value) { mDefinitions[key] = value; }
 
@@ -80,7 +139,29 @@ public:
     /// Return the handle of a uniform attribute (-1 if it does not exist)
     GLint uniform(const std::string &name, bool warn = true) const;
 
-    /// Upload an Eigen matrix as a vertex buffer object (refreshing it as needed)
+    /**
+     * \brief Location of a uniform, for updates that bypass the name lookup
+     *
+     * Setting an invalid handle (e.g. of a uniform that was optimized away)
+     * has no effect. Handles stay valid until the shader is initialized again.
+     */
+    struct UniformHandle {
+        explicit UniformHandle(GLint id = -1) : id(id) { }
+        bool valid() const { return id != -1; }
+        GLint id;
+    };
+
+    /// Return the handle of a uniform, to be passed to \ref setUniform() in every frame
+    UniformHandle uniformHandle(const std::string &name, bool warn = true) const {
+        return UniformHandle(uniform(name, warn));
+    }
+
+    /**
+     * \brief Upload an Eigen matrix as a vertex buffer object (refreshing it as needed)
+     *
+     * The storage of the buffer is reused as long as the data fits, and grows
+     * geometrically otherwise.
+     */
     template <typename Matrix> void uploadAttrib(const std::string &name, const Matrix &M, int version = -1) {
         uint32_t compSize = sizeof(typename Matrix::Scalar);
         GLuint glType = (GLuint) detail::type_traits<typename Matrix::Scalar>::type;
@@ -90,6 +171,40 @@ public:
                      glType, integral, (const uint8_t *) M.data(), version);
     }
 
+    /**
+     * \brief Overwrite the columns starting at \c offset of a previously
+     * uploaded attribute (e.g. to append vertices or to change a few of them)
+     *
+     * The attribute grows if the columns extend past its end, preserving its
+     * contents and the buffer object (so attributes shared with other shaders
+     * through \ref shareAttrib() see the new data). Creates the attribute if it does not exist and \c offset is 0.
+     */
+    template <typename Matrix> void uploadAttribRange(const std::string &name, uint32_t offset, const Matrix &M) {
+        uint32_t compSize = sizeof(typename Matrix::Scalar);
+        GLuint glType = (GLuint) detail::type_traits<typename Matrix::Scalar>::type;
+        bool integral = (bool) detail::type_traits<typename Matrix::Scalar>::integral;
+
+        uploadAttribRange(name, offset * (uint32_t) M.rows(), (uint32_t) M.size(), (int) M.rows(),
+                          compSize, glType, integral, (const uint8_t *) M.data());
+    }
+
+    /**
+     * \brief Upload an Eigen matrix that is rewritten in every frame
+     *
+     * Successive uploads are placed one after another in a ring buffer
+     * without waiting for draw calls that still read earlier ones. When the
+     * ring is full, its storage is orphaned, so the driver hands out fresh
+     * memory instead of synchronizing.
+     */
+    template <typename Matrix> void streamAttrib(const std::string &name, const Matrix &M) {
+        uint32_t compSize = sizeof(typename Matrix::Scalar);
+        GLuint glType = (GLuint) detail::type_traits<typename Matrix::Scalar>::type;
+        bool integral = (bool) detail::type_traits<typename Matrix::Scalar>::integral;
+
+        streamAttrib(name, (uint32_t) M.size(), (int) M.rows(), compSize,
+                     glType, integral, (const uint8_t *) M.data());
+    }
+
     /// Download a vertex buffer object into an Eigen matrix
     template <typename Matrix> void downloadAttrib(const std::string &name, Matrix &M) {
         uint32_t compSize = sizeof(typename Matrix::Scalar);
@@ -150,56 +265,62 @@ public:
 
     /// Initialize a uniform parameter with a 4x4 matrix (float)
     template <typename T>
-    void setUniform(const std::string &name, const Eigen::Matrix<T, 4, 4> &mat, bool warn = true) {
-        glUniformMatrix4fv(uniform(name, warn), 1, GL_FALSE, mat.template cast<float>().data());
+    void setUniform(UniformHandle handle, const Eigen::Matrix<T, 4, 4> &mat) {
+        glUniformMatrix4fv(handle.id, 1, GL_FALSE, mat.template cast<float>().data());
     }
 
     /// Initialize a uniform parameter with an integer value
     template <typename T, typename std::enable_if<detail::type_traits<T>::integral == 1, int>::type = 0>
-    void setUniform(const std::string &name, T value, bool warn = true) {
-        glUniform1i(uniform(name, warn), (int) value);
+    void setUniform(UniformHandle handle, T value) {
+        glUniform1i(handle.id, (int) value);
     }
 
     /// Initialize a uniform parameter with a floating point value
     template <typename T, typename std::enable_if<detail::type_traits<T>::integral == 0, int>::type = 0>
-    void setUniform(const std::string &name, T value, bool warn = true) {
-        glUniform1f(uniform(name, warn), (float) value);
+    void setUniform(UniformHandle handle, T value) {
+        glUniform1f(handle.id, (float) value);
     }
 
     /// Initialize a uniform parameter with a 2D vector (int)
     template <typename T, typename std::enable_if<detail::type_traits<T>::integral == 1, int>::type = 0>
-    void setUniform(const std::string &name, const Eigen::Matrix<T, 2, 1>  &v, bool warn = true) {
-        glUniform2i(uniform(name, warn), (int) v.x(), (int) v.y());
+    void setUniform(UniformHandle handle, const Eigen::Matrix<T, 2, 1>  &v) {
+        glUniform2i(handle.id, (int) v.x(), (int) v.y());
     }
 
     /// Initialize a uniform parameter with a 2D vector (float)
     template <typename T, typename std::enable_if<detail::type_traits<T>::integral == 0, int>::type = 0>
-    void setUniform(const std::string &name, const Eigen::Matrix<T, 2, 1>  &v, bool warn = true) {
-        glUniform2f(uniform(name, warn), (float) v.x(), (float) v.y());
+    void setUniform(UniformHandle handle, const Eigen::Matrix<T, 2, 1>  &v) {
+        glUniform2f(handle.id, (float) v.x(), (float) v.y());
     }
 
     /// Initialize a uniform parameter with a 3D vector (int)
     template <typename T, typename std::enable_if<detail::type_traits<T>::integral == 1, int>::type = 0>
-    void setUniform(const std::string &name, const Eigen::Matrix<T, 3, 1>  &v, bool warn = true) {
-        glUniform3i(uniform(name, warn), (int) v.x(), (int) v.y(), (int) v.z());
+    void setUniform(UniformHandle handle, const Eigen::Matrix<T, 3, 1>  &v) {
+        glUniform3i(handle.id, (int) v.x(), (int) v.y(), (int) v.z());
     }
 
     /// Initialize a uniform parameter with a 3D vector (float)
     template <typename T, typename std::enable_if<detail::type_traits<T>::integral == 0, int>::type = 0>
-    void setUniform(const std::string &name, const Eigen::Matrix<T, 3, 1>  &v, bool warn = true) {
-        glUniform3f(uniform(name, warn), (float) v.x(), (float) v.y(), (float) v.z());
+    void setUniform(UniformHandle handle, const Eigen::Matrix<T, 3, 1>  &v) {
+        glUniform3f(handle.id, (float) v.x(), (float) v.y(), (float) v.z());
     }
 
     /// Initialize a uniform parameter with a 4D vector (int)
     template <typename T, typename std::enable_if<detail::type_traits<T>::integral == 1, int>::type = 0>
-    void setUniform(const std::string &name, const Eigen::Matrix<T, 4, 1>  &v, bool warn = true) {
-        glUniform4i(uniform(name, warn), (int) v.x(), (int) v.y(), (int) v.z(), (int) v.w());
+    void setUniform(UniformHandle handle, const Eigen::Matrix<T, 4, 1>  &v) {
+        glUniform4i(handle.id, (int) v.x(), (int) v.y(), (int) v.z(), (int) v.w());
     }
 
     /// Initialize a uniform parameter with a 4D vector (float)
     template <typename T, typename std::enable_if<detail::type_traits<T>::integral == 0, int>::type = 0>
-    void setUniform(const std::string &name, const Eigen::Matrix<T, 4, 1>  &v, bool warn = true) {
-        glUniform4f(uniform(name, warn), (float) v.x(), (float) v.y(), (float) v.z(), (float) v.w());
+    void setUniform(UniformHandle handle, const Eigen::Matrix<T, 4, 1>  &v) {
+        glUniform4f(handle.id, (float) v.x(), (float) v.y(), (float) v.z(), (float) v.w());
+    }
+
+    /// Initialize a named uniform parameter (looked up in the table built by \ref init())
+    template <typename Value>
+    void setUniform(const std::string &name, const Value &value, bool warn = true) {
+        setUniform(uniformHandle(name, warn), value);
     }
 
     /// Initialize a uniform buffer with a uniform buffer object
@@ -218,6 +339,16 @@ protected:
                        const uint8_t *data, int version = -1);
     void downloadAttrib(const std::string &name, uint32_t size, int dim,
                        uint32_t compSize, GLuint glType, uint8_t *data);
+    void uploadAttribRange(const std::string &name, uint32_t offset, uint32_t size, int dim,
+                           uint32_t compSize, GLuint glType, bool integral,
+                           const uint8_t *data);
+    void streamAttrib(const std::string &name, uint32_t size, int dim,
+                      uint32_t compSize, GLuint glType, bool integral,
+                      const uint8_t *data);
+    /// Fill the location tables with the active attributes, uniforms and uniform blocks
+    void introspect();
+    /// Wait for a shader started by \ref initAsync() and check for errors
+    void finishInit();
 protected:
     struct Buffer {
         GLuint id;
@@ -226,15 +357,40 @@ protected:
         GLuint compSize;
         GLuint size;
         int version;
+        /// Size of the allocated storage (in bytes)
+        size_t capacity = 0;
+        /// Position of the current contents within the storage (in bytes)
+        size_t offset = 0;
+        /// Whether the storage is a ring written by \ref streamAttrib()
+        bool streaming = false;
+        /// Start of the free part of the ring (in bytes)
+        size_t head = 0;
     };
+
+    /// Look up the buffer of an attribute, creating it if necessary, and update its layout
+    Buffer &attribBuffer(const std::string &name, uint32_t size, int dim,
+                         uint32_t compSize, GLuint glType);
+    /// Point an attribute at the current contents of its buffer
+    void bindAttribBuffer(GLint attribID, const Buffer &buffer, bool integral);
+
     std::string mName;
     GLuint mVertexShader;
     GLuint mFragmentShader;
     GLuint mGeometryShader;
     GLuint mProgramShader;
     GLuint mVertexArrayObject;
+    bool mLoadedFromCache;
+    /// Whether \ref mProgramShader belongs to another shader (see \ref initShared())
+    bool mSharedProgram;
+    std::shared_ptr<detail::PendingProgram> mPending;
     std::map<std::string, Buffer> mBufferObjects;
     std::map<std::string, std::string> mDefinitions;
+    /* Locations found after linking; names that are requested but missing
+       are looked up once and stored as well (-1 if they do not exist) */
+    mutable std::unordered_map<std::string, GLint> mAttribs;
+    mutable std::unordered_map<std::string, GLint> mUniforms;
+    /// Index and current binding point of each uniform block
+    std::unordered_map<std::string, std::pair<GLuint, int>> mUniformBlocks;
 };
 
 //  ----------------------------------------------------
@@ -348,6 +504,53 @@ protected:
 
 //  ----------------------------------------------------
 
+/**
+ * \brief Color texture that a widget renders into with its own shader, and
+ * which is then composited by NanoVG
+ */
+class NANOGUI_EXPORT GLRenderTexture {
+public:
+    GLRenderTexture()
+        : mFramebuffer(0), mTexture(0), mSize(Vector2i::Zero()), mImage(0),
+          mPrevFramebuffer(0) { }
+
+    /**
+     * \brief (Re)allocate the texture and its NanoVG image if the size changed
+     *
+     * Returns \c true if this happened, in which case the contents are
+     * undefined. \c imageFlags are passed on to NanoVG (which never deletes
+     * the texture itself).
+     */
+    bool resize(NVGcontext *ctx, const Vector2i &size, int imageFlags);
+
+    /// Render into the texture, saving the framebuffer binding and viewport
+    void bind();
+
+    /// Restore the framebuffer binding and viewport saved by \ref bind()
+    void release();
+
+    /**
+     * \brief Release all associated resources
+     *
+     * The NanoVG image is deleted through \c ctx, which may be \c nullptr if
+     * the context was destroyed already (along with its images).
+     */
+    void free(NVGcontext *ctx);
+
+    /// Return the NanoVG image showing the texture (0 if not allocated)
+    int image() const { return mImage; }
+
+    /// Return the size of the texture in pixels
+    const Vector2i &size() const { return mSize; }
+protected:
+    GLuint mFramebuffer, mTexture;
+    Vector2i mSize;
+    int mImage;
+    GLint mPrevFramebuffer, mPrevViewport[4];
+};
+
+//  ----------------------------------------------------
+
 /// Arcball helper class to interactively rotate objects on-screen
 struct Arcball {
     Arcball(float speedFactor = 2.0f)
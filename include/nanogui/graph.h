@@ -12,11 +12,88 @@
 #pragma once
 
 #include <nanogui/widget.h>
+#include <nanogui/glutil.h>
+#include <atomic>
 
 NAMESPACE_BEGIN(nanogui)
 
+/**
+ * \brief Fixed-capacity stream of samples feeding a \ref Graph
+ *
+ * Samples are appended by a single producer thread using \ref push() or
+ * \ref pushBatch(), which never block or allocate. The UI thread calls
+ * \ref update() to copy only the samples that arrived since its last call
+ * into a window of the \ref capacity() most recent samples.
+ *
+ * The ring buffer holds twice the window capacity, so the producer may run
+ * ahead while the UI thread copies; samples overwritten during the copy are
+ * detected (as in a seqlock) and read again.
+ */
+class NANOGUI_EXPORT GraphStream : public Object {
+public:
+    /// Create a stream whose window holds the given number of samples
+    GraphStream(size_t capacity);
+
+    /// Return the number of samples in a full window
+    size_t capacity() const { return mCapacity; }
+
+    /// Append a sample (producer thread only)
+    void push(float sample) { pushBatch(&sample, 1); }
+
+    /// Append several samples at once (producer thread only)
+    void pushBatch(const float *samples, size_t count);
+
+    /// Return the total number of samples pushed so far
+    uint64_t written() const { return mWritten.load(std::memory_order_acquire); }
+
+    /**
+     * \brief Bring the window up to date (UI thread only)
+     *
+     * Returns \c true if new samples arrived since the last call.
+     */
+    bool update();
+
+    /// Return the total number of samples up to the end of the window (UI thread only)
+    uint64_t windowEnd() const { return mRead; }
+
+    /// Return the current window, oldest sample first (UI thread only)
+    Eigen::Map<const VectorXf> window() const {
+        return Eigen::Map<const VectorXf>(mMirror.data() + mWindowBegin, (Eigen::Index) mWindowSize);
+    }
+
+protected:
+    virtual ~GraphStream() { }
+
+protected:
+    size_t mCapacity;
+
+    /* Shared between the producer and the UI thread */
+    std::vector<std::atomic<float>> mRing;
+    uint64_t mMask;
+    std::atomic<uint64_t> mClaimed;
+    std::atomic<uint64_t> mWritten;
+
+    /* UI thread: the window, stored twice so that it is always contiguous */
+    std::vector<float> mMirror;
+    size_t mWindowBegin, mWindowSize;
+    uint64_t mRead;
+};
+
 class NANOGUI_EXPORT Graph : public Widget {
 public:
+    /**
+     * \brief How the values are reduced before drawing when there are more
+     * samples than pixel columns
+     */
+    enum class Decimation {
+        /// Draw every sample
+        None,
+        /// Keep the minimum and maximum sample of every pixel column
+        MinMax,
+        /// Largest-Triangle-Three-Buckets downsampling to two points per pixel column
+        LTTB
+    };
+
     Graph(Widget *parent, const std::string &caption = "Untitled");
 
     const std::string &caption() const { return mCaption; }
@@ -38,8 +115,38 @@ public:
     void setTextColor(const Color &textColor) { mTextColor = textColor; }
 
     const VectorXf &values() const { return mValues; }
-    VectorXf &values() { return mValues; }
-    void setValues(const VectorXf &values) { mValues = values; }
+    /**
+     * \brief Return the values for modification
+     *
+     * When the reference is kept to change the values later on, call
+     * \ref markValuesChanged() afterwards so that the cached curve is rebuilt.
+     */
+    VectorXf &values() { markValuesChanged(); return mValues; }
+    void setValues(const VectorXf &values) { mValues = values; markValuesChanged(); }
+    /// Notify the graph that \ref values() were modified in place
+    void markValuesChanged() { mDecimationDirty = mGpuDirty = true; }
+
+    /// Return the stream that provides the values (if any)
+    GraphStream *stream() { return mStream; }
+    /// Draw samples of a stream instead of \ref values() (\c nullptr to detach)
+    void setStream(GraphStream *stream) { mStream = stream; mDecimationDirty = mGpuDirty = true; }
+
+    Decimation decimation() const { return mDecimation; }
+    void setDecimation(Decimation decimation) { mDecimation = decimation; mDecimationDirty = true; }
+
+    /// Return whether the curve is drawn by a shader (see \ref setGpuRendering())
+    bool gpuRendering() const { return mGpuRendering; }
+    /**
+     * \brief Draw the curve using a shader instead of NanoVG paths
+     *
+     * All samples are kept in a vertex buffer that is only refreshed when the
+     * values change, and the shader maps them to pixels, so no tessellation
+     * happens on the CPU. With a \ref GraphStream, only the samples that
+     * arrived since the last frame are uploaded. The result is rendered into
+     * a texture that is composited by NanoVG. The program is shared by all
+     * graphs of a screen. Falls back to NanoVG if it cannot be created.
+     */
+    void setGpuRendering(bool gpuRendering) { mGpuRendering = gpuRendering; mGpuDirty = true; }
 
     virtual Vector2i preferredSize(NVGcontext *ctx) const override;
     virtual void draw(NVGcontext *ctx) override;
@@ -50,6 +157,30 @@ protected:
     std::string mCaption, mHeader, mFooter;
     Color mBackgroundColor, mForegroundColor, mTextColor;
     VectorXf mValues;
+
+protected:
+    virtual ~Graph();
+
+    void updateDecimation(const Eigen::Ref<const VectorXf> &values);
+    bool drawGpu(NVGcontext *ctx, const Eigen::Ref<const VectorXf> &values);
+    /// Draw the caption, header, footer and border
+    void drawLabels(NVGcontext *ctx);
+
+protected:
+    ref<GraphStream> mStream;
+    Decimation mDecimation;
+    bool mDecimationDirty;
+    int mDecimationWidth;
+    /// Cached decimated curve: sample position (0..1) and value
+    std::vector<Vector2f> mPoints;
+
+    bool mGpuRendering, mGpuFailed, mGpuDirty;
+    GLShader *mShader;
+    GLRenderTexture *mTarget;
+    /// Stream samples in the vertex buffer so far, first sample and number of samples drawn
+    uint64_t mGpuWritten;
+    int mGpuFirst, mGpuCount;
+    GLShader::UniformHandle mUniformFirst, mUniformCount, mUniformArea, mUniformColor;
 };
 
 NAMESPACE_END(nanogui)
@@ -0,0 +1,115 @@
+/*
+    nanogui/heatmap.h -- Widget that displays a matrix of floating point
+    values through a colormap
+
+    NanoGUI was developed by Wenzel Jakob <wenzel.jakob@epfl.ch>.
+    The widget drawing code is based on the NanoVG demo application
+    by Mikko Mononen.
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+
+#pragma once
+
+#include <nanogui/widget.h>
+#include <nanogui/glutil.h>
+
+NAMESPACE_BEGIN(nanogui)
+
+/**
+ * \brief Displays a matrix of values (spectrograms, sensor grids, ..) as a
+ * color-coded image
+ *
+ * The values are uploaded as-is into a single-channel floating point texture
+ * and mapped to colors by a fragment shader, so no per-pixel conversion
+ * happens on the CPU. Data is read directly from the caller's memory: rows
+ * must be contiguous, with an arbitrary stride between them. When only some
+ * rows change, \ref updateRows() uploads just that sub-rectangle.
+ *
+ * Uploads happen immediately, so the data methods must be called from the
+ * UI thread (while the OpenGL context of the screen is current). NaN values
+ * are drawn transparent.
+ */
+class NANOGUI_EXPORT Heatmap : public Widget {
+public:
+    /// Row-major matrix; the data of \ref MatrixRef is used without copying
+    typedef Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> Matrix;
+    typedef Eigen::Ref<const Matrix, 0, Eigen::OuterStride<>> MatrixRef;
+
+    enum class Colormap {
+        Viridis,
+        Inferno,
+        Grayscale,
+        Coolwarm
+    };
+
+    Heatmap(Widget *parent);
+
+    /// Return the number of columns and rows of the data
+    const Vector2i &dataSize() const { return mDataSize; }
+
+    /// Replace the data (a column-major matrix is converted to a row-major temporary)
+    void setData(const MatrixRef &data) {
+        setData(data.data(), (int) data.cols(), (int) data.rows(), (size_t) data.outerStride());
+    }
+
+    /// Replace the data; \c stride is the distance between rows in floats (0: \c width)
+    void setData(const float *data, int width, int height, size_t stride = 0);
+
+    /// Upload the given rows of the data, starting at row \c firstRow
+    void updateRows(const MatrixRef &rows, int firstRow) {
+        updateRows(rows.data(), firstRow, (int) rows.rows(), (size_t) rows.outerStride());
+    }
+
+    /// Upload \c rowCount rows starting at row \c firstRow; \c data points to the first of them
+    void updateRows(const float *data, int firstRow, int rowCount, size_t stride = 0);
+
+    /// Return the values mapped to the two ends of the colormap
+    const Vector2f &range() const { return mRange; }
+    /// Set the values mapped to the ends of the colormap, disabling automatic ranging
+    void setRange(const Vector2f &range) { mRange = range; mAutoRange = false; mDirty = true; }
+
+    /**
+     * \brief Whether the range follows the data: \ref setData() computes the
+     * extrema, and \ref updateRows() widens the range if necessary
+     */
+    bool autoRange() const { return mAutoRange; }
+    void setAutoRange(bool autoRange) { mAutoRange = autoRange; }
+
+    void setColormap(Colormap colormap);
+    /// Set a custom colormap, interpolating linearly between evenly spaced colors
+    void setColormap(const std::vector<Color> &colors);
+    const std::vector<Color> &colormap() const { return mColormap; }
+
+    /// Whether values are interpolated between the centers of the matrix cells
+    bool interpolation() const { return mInterpolation; }
+    void setInterpolation(bool interpolation) { mInterpolation = interpolation; mDirty = true; }
+
+    virtual Vector2i preferredSize(NVGcontext *ctx) const override;
+    virtual void draw(NVGcontext *ctx) override;
+
+protected:
+    virtual ~Heatmap();
+
+    void updateRange(const float *data, int width, int height, size_t stride, bool extend);
+    void uploadColormap();
+    bool initShader();
+
+protected:
+    Vector2i mDataSize;
+    Vector2f mRange;
+    bool mAutoRange, mInterpolation;
+    std::vector<Color> mColormap;
+    bool mColormapDirty;
+    /// Whether the composited image needs to be rendered again
+    bool mDirty;
+
+    bool mShaderFailed;
+    GLShader *mShader;
+    GLShader::UniformHandle mUniformData, mUniformColormap, mUniformRange;
+    uint32_t mDataTexture, mColormapTexture;
+    GLRenderTexture *mTarget;
+};
+
+NAMESPACE_END(nanogui)
@@ -0,0 +1,78 @@
+/*
+    nanogui/histogram.h -- Histogram widget that bins large sample arrays
+    using all worker threads
+
+    NanoGUI was developed by Wenzel Jakob <wenzel.jakob@epfl.ch>.
+    The widget drawing code is based on the NanoVG demo application
+    by Mikko Mononen.
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+
+#pragma once
+
+#include <nanogui/graph.h>
+
+NAMESPACE_BEGIN(nanogui)
+
+/**
+ * \brief Bar chart of the distribution of a set of samples
+ *
+ * Samples are binned in parallel: the calling thread and the workers of
+ * \ref ThreadPool::global() process chunks of the input into private
+ * histograms, which are merged at the end. The call returns once all
+ * samples are binned, and the samples are not retained, so \ref append()
+ * only needs to process the new samples.
+ *
+ * Samples outside of the range are counted in the first or last bin, and
+ * NaN values are ignored. The normalized bin counts are stored as the
+ * \ref Graph values, and the bars are drawn with the colors of the graph.
+ */
+class NANOGUI_EXPORT Histogram : public Graph {
+public:
+    Histogram(Widget *parent, const std::string &caption = "Untitled", int binCount = 64);
+
+    int binCount() const { return (int) mCounts.size(); }
+    /// Change the number of bins (clears the histogram)
+    void setBinCount(int binCount);
+
+    /// Return the range of values covered by the bins
+    const Vector2f &range() const { return mRange; }
+    /// Set the range covered by the bins, disabling automatic ranging (clears the histogram)
+    void setRange(const Vector2f &range);
+
+    /// Whether the first batch of samples after clearing determines the range
+    bool autoRange() const { return mAutoRange; }
+    void setAutoRange(bool autoRange) { mAutoRange = autoRange; }
+
+    /// Replace the histogram by one of the given samples
+    void setData(const float *data, size_t count) { clear(); append(data, count); }
+    void setData(const VectorXf &data) { setData(data.data(), (size_t) data.size()); }
+
+    /// Add samples to the histogram
+    void append(const float *data, size_t count);
+    void append(const VectorXf &data) { append(data.data(), (size_t) data.size()); }
+
+    /// Reset all bins to zero
+    void clear();
+
+    /// Return the number of samples in each bin
+    const std::vector<uint64_t> &counts() const { return mCounts; }
+
+    /// Return the total number of binned samples
+    uint64_t total() const { return mTotal; }
+
+    virtual void draw(NVGcontext *ctx) override;
+
+protected:
+    void updateValues();
+
+protected:
+    std::vector<uint64_t> mCounts;
+    uint64_t mTotal;
+    Vector2f mRange;
+    bool mAutoRange;
+};
+
+NAMESPACE_END(nanogui)
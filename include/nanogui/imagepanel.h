@@ -13,18 +13,53 @@
 #pragma once
 
 #include <nanogui/widget.h>
+#include <nanogui/texturemanager.h>
+#include <memory>
 
 NAMESPACE_BEGIN(nanogui)
 
+NAMESPACE_BEGIN(detail)
+struct ThumbnailQueue;
+NAMESPACE_END(detail)
+
 class NANOGUI_EXPORT ImagePanel : public Widget {
 public:
     typedef std::vector<std::pair<int, std::string>> Images;
+    typedef std::vector<std::pair<ref<TextureManager::Image>, std::string>> ManagedImages;
 public:
     ImagePanel(Widget *parent);
 
-    void setImages(const Images &data) { mImages = data; }
+    /// Show the given images (cancels a pending \ref loadDirectory())
+    void setImages(const Images &data);
     const Images& images() const { return mImages; }
 
+    /**
+     * \brief Show images of a \ref TextureManager (cancels a pending \ref loadDirectory())
+     *
+     * Only the handles of visible thumbnails are requested when drawing, so
+     * the manager may evict the others and loads them again on demand.
+     */
+    void setImages(const ManagedImages &images);
+
+    /**
+     * \brief Show thumbnails of all PNG images in a directory without
+     * blocking the UI thread
+     *
+     * The directory is scanned, and every image decoded and reduced to a
+     * square thumbnail, by jobs on \ref ThreadPool::global(). Thumbnails are
+     * uploaded while drawing, limited to \ref uploadBudget() seconds per
+     * frame, and a placeholder is shown for images that are not ready yet.
+     * Images that fail to load keep their placeholder.
+     */
+    void loadDirectory(const std::string &path);
+
+    /// Return whether \ref loadDirectory() is still in progress
+    bool loading() const { return (bool) mQueue; }
+
+    /// Maximum time spent on uploading thumbnails per frame (in seconds)
+    double uploadBudget() const { return mUploadBudget; }
+    void setUploadBudget(double uploadBudget) { mUploadBudget = uploadBudget; }
+
     std::function<void(int)> callback() const { return mCallback; }
     void setCallback(const std::function<void(int)> &callback) { mCallback = callback; }
 
@@ -33,10 +68,26 @@ public:
     virtual Vector2i preferredSize(NVGcontext *ctx) const override;
     virtual void draw(NVGcontext* ctx) override;
 protected:
+    virtual ~ImagePanel();
+
     Vector2i gridSize() const;
     int indexForPosition(const Vector2i &p) const;
+    /// Return the range [first, last) of grid rows that intersect the visible area
+    Vector2i visibleRows(NVGcontext *ctx, int rowCount) const;
+    void cancelLoading();
+    void uploadThumbnails(NVGcontext *ctx);
 protected:
     Images mImages;
+    /// Images set via \ref setImages(const ManagedImages &), whose handles are copied into \ref mImages
+    ManagedImages mManagedImages;
+    std::shared_ptr<detail::ThumbnailQueue> mQueue;
+    double mUploadBudget;
+    /// Textures of the thumbnails created by \ref loadDirectory()
+    std::vector<uint32_t> mTextures;
+    /// Thumbnails of a previous directory, released in the next \ref draw()
+    std::vector<int> mReleasedImages;
+    /// Size of each image (zero until it is first drawn)
+    std::vector<Vector2i> mImageSizes;
     std::function<void(int)> mCallback;
     int mThumbSize;
     int mSpacing;
@@ -13,9 +13,27 @@
 #pragma once
 
 #include <nanogui/widget.h>
+#include <nanogui/texturemanager.h>
+#include <memory>
 
 NAMESPACE_BEGIN(nanogui)
 
+NAMESPACE_BEGIN(detail)
+struct ImagePixels;
+struct InspectionState;
+NAMESPACE_END(detail)
+
+/**
+ * \brief Displays an image that was previously uploaded with NanoVG
+ *
+ * In inspection mode (see \ref setInspection()), the widget shows the values
+ * of the pixel under the cursor and per-channel statistics (minimum, maximum,
+ * mean and a histogram) of a region that is selected by dragging with the left
+ * mouse button; a click selects the whole image. This requires a CPU copy of
+ * the pixel values provided via \ref setPixels(), so the GPU is never read
+ * back. Statistics are computed by a job on \ref ThreadPool::global(), and
+ * intermediate results are shown while it proceeds.
+ */
 class NANOGUI_EXPORT ImageView : public Widget {
 public:
     enum class SizePolicy {
@@ -23,19 +41,100 @@ public:
        Expand
     };
 
+    /// Per-channel statistics of a region of the inspected pixels
+    struct Statistics {
+        /// Region in pixels: upper left corner (inclusive) and lower right corner (exclusive)
+        Vector4i region = Vector4i::Zero();
+        int channels = 0;
+        /// Number of processed pixels
+        uint64_t count = 0;
+        /// Fraction of the region that has been processed
+        float progress = 0.f;
+        /// Statistics of each channel (NaN values are ignored)
+        Vector4f min = Vector4f::Zero(), max = Vector4f::Zero(), mean = Vector4f::Zero();
+        /// Histogram over \ref histogramRange(): \c histogramBins() bins for each channel
+        std::vector<uint32_t> histogram;
+    };
+
     ImageView(Widget *parent, int image = 0, SizePolicy policy = SizePolicy::Fixed);
 
-    void setImage(int img)      { mImage = img; }
+    void setImage(int img)      { mImage = img; mManagedImage = nullptr; }
     int  image() const          { return mImage; }
 
+    /**
+     * \brief Show an image of a \ref TextureManager
+     *
+     * Its handle is requested whenever the widget is drawn, so the image is
+     * loaded again after it was evicted.
+     */
+    void setImage(TextureManager::Image *image) { mManagedImage = image; mImage = 0; }
+    TextureManager::Image *managedImage() { return mManagedImage; }
+
     void       setPolicy(SizePolicy policy) { mPolicy = policy; }
     SizePolicy policy() const { return mPolicy; }
 
+    /// Whether the pixel readout and region statistics are shown
+    bool inspection() const { return mInspection; }
+    void setInspection(bool inspection) { mInspection = inspection; }
+
+    /**
+     * \brief Provide the pixel values used for inspection
+     *
+     * The values are copied. Rows must be contiguous with interleaved
+     * channels (1 to 4), and \c stride is the distance between rows in
+     * floats (0: \c width * \c channels). The size should match the image.
+     * Throws \c std::invalid_argument for other channel counts.
+     */
+    void setPixels(const float *data, int width, int height, int channels, size_t stride = 0);
+
+    /// Provide 8-bit pixel values for inspection (mapped to [0, 1])
+    void setPixels(const uint8_t *data, int width, int height, int channels, size_t stride = 0);
+
+    /// Value range covered by the histogram (values outside are counted in the first or last bin)
+    const Vector2f &histogramRange() const { return mHistogramRange; }
+    void setHistogramRange(const Vector2f &range) { mHistogramRange = range; updateStatistics(); }
+
+    int histogramBins() const { return mHistogramBins; }
+    void setHistogramBins(int bins) { mHistogramBins = std::max(bins, 1); updateStatistics(); }
+
+    /// Select the region whose statistics are computed (in pixels; empty: the whole image)
+    void setRegion(const Vector4i &region);
+    const Vector4i &region() const { return mRegion; }
+
+    /// Return the most recent (possibly partial) statistics of the selected region
+    const Statistics &statistics() const { return mStatistics; }
+
+    virtual bool mouseButtonEvent(const Vector2i &p, int button, bool down, int modifiers) override;
+    virtual bool mouseDragEvent(const Vector2i &p, const Vector2i &rel, int button, int modifiers) override;
+    virtual bool mouseMotionEvent(const Vector2i &p, const Vector2i &rel, int button, int modifiers) override;
+    virtual bool mouseEnterEvent(const Vector2i &p, bool enter) override;
+
     virtual Vector2i preferredSize(NVGcontext *ctx) const override;
     virtual void draw(NVGcontext* ctx) override;
+protected:
+    virtual ~ImageView();
+
+    /// Convert a position (in parent coordinates) into a pixel position
+    Vector2i pixelForPosition(const Vector2i &p) const;
+    /// Start computing the statistics of the selected region
+    void updateStatistics();
+    void drawInspection(NVGcontext *ctx);
 protected:
     int mImage;
+    ref<TextureManager::Image> mManagedImage;
     SizePolicy mPolicy;
+    /// Size at which the image was last drawn
+    Vector2i mDrawnSize;
+
+    bool mInspection;
+    std::shared_ptr<const detail::ImagePixels> mPixels;
+    std::shared_ptr<detail::InspectionState> mState;
+    Vector2f mHistogramRange;
+    int mHistogramBins;
+    Vector4i mRegion;
+    Statistics mStatistics;
+    Vector2i mMousePos, mDragStart;
+    bool mMouseInside, mSelecting;
 };
 
 NAMESPACE_END(nanogui)
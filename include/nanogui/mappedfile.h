@@ -0,0 +1,55 @@
+/*
+    nanogui/mappedfile.h -- Memory-mapped files for widgets that display
+    data sets larger than the available memory
+
+    NanoGUI was developed by Wenzel Jakob <wenzel.jakob@epfl.ch>.
+    The widget drawing code is based on the NanoVG demo application
+    by Mikko Mononen.
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+
+#pragma once
+
+#include <nanogui/common.h>
+#include <string>
+
+NAMESPACE_BEGIN(nanogui)
+NAMESPACE_BEGIN(detail)
+
+/// Read-only mapping of an existing file, or writable mapping of a newly created one
+class NANOGUI_EXPORT MappedFile {
+public:
+    /**
+     * Map \c filename for reading, or create it with the given size and map
+     * it for writing if \c createSize is nonzero. Throws \c std::runtime_error
+     * on failure.
+     */
+    MappedFile(const std::string &filename, uint64_t createSize = 0);
+    ~MappedFile();
+
+    uint8_t *data() const { return mData; }
+    uint64_t size() const { return mSize; }
+
+    /// Write modified pages back to the file
+    void flush();
+
+protected:
+    void close();
+
+protected:
+#if defined(_WIN32)
+    void *mFile, *mMapping;
+#else
+    int mFile;
+#endif
+    uint8_t *mData;
+    uint64_t mSize;
+};
+
+/// Query the size and modification time of a file (returns \c false if it does not exist)
+extern NANOGUI_EXPORT bool fileInfo(const std::string &filename, uint64_t &size, int64_t &timestamp);
+
+NAMESPACE_END(detail)
+NAMESPACE_END(nanogui)
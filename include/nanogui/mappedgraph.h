@@ -0,0 +1,128 @@
+/*
+    nanogui/mappedgraph.h -- Zoomable graph of memory-mapped sample files
+    that are too large to be loaded into memory
+
+    NanoGUI was developed by Wenzel Jakob <wenzel.jakob@epfl.ch>.
+    The widget drawing code is based on the NanoVG demo application
+    by Mikko Mononen.
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+
+#pragma once
+
+#include <nanogui/graph.h>
+#include <memory>
+
+NAMESPACE_BEGIN(nanogui)
+
+NAMESPACE_BEGIN(detail)
+class MappedFile;
+struct PyramidBuild;
+NAMESPACE_END(detail)
+
+/**
+ * \brief Memory-mapped file of 32-bit floating point samples
+ *
+ * To display arbitrary ranges of the file at the resolution of the screen,
+ * a pyramid of per-block minima and maxima is built on a background thread
+ * (levels of 64, 512, 4096, ... samples per block) and stored next to the
+ * sample file with the suffix ".pyramid". Later instances reuse it as long
+ * as the size and modification time of the sample file are unchanged.
+ * Queries only touch the pyramid level matching the requested density.
+ */
+class NANOGUI_EXPORT MappedSeries : public Object {
+public:
+    /// Map the given sample file (throws \c std::runtime_error on failure)
+    MappedSeries(const std::string &filename);
+
+    /// Return the name of the sample file
+    const std::string &filename() const { return mFilename; }
+
+    /// Return the number of samples
+    uint64_t size() const { return mSize; }
+
+    /// Return whether the pyramid is available
+    bool ready() const { return (bool) mPyramid; }
+
+    /// Return the progress of building the pyramid (between 0 and 1)
+    float progress() const;
+
+    /// Return the smallest and largest sample (only valid once the pyramid is ready)
+    Vector2f valueRange() const;
+
+    /**
+     * \brief Pick up the pyramid once it has been built (UI thread only)
+     *
+     * Returns \c true when the pyramid became available during this call.
+     */
+    bool update();
+
+    /**
+     * \brief Compute the minimum and maximum of the samples covered by each
+     * of \c columns equally sized intervals of the range [\c begin, \c end)
+     *
+     * The results are written to \c out as interleaved (min, max) pairs.
+     * Before the pyramid is ready, large ranges are approximated using a
+     * subset of the samples.
+     */
+    void envelope(double begin, double end, int columns, float *out) const;
+
+protected:
+    virtual ~MappedSeries();
+
+    /// Map an existing pyramid file (returns \c false if it is missing or stale)
+    bool loadPyramid();
+
+    /// Return the (min, max) pairs of a pyramid level
+    const float *level(int index) const;
+
+protected:
+    std::string mFilename;
+    std::unique_ptr<detail::MappedFile> mData;
+    std::unique_ptr<detail::MappedFile> mPyramid;
+    std::shared_ptr<detail::PyramidBuild> mBuild;
+    uint64_t mSize;
+    int64_t mTimestamp;
+};
+
+/**
+ * \brief \ref Graph that displays a \ref MappedSeries
+ *
+ * The mouse wheel zooms around the cursor, and dragging pans the view. The
+ * values of the graph are recomputed from the series whenever the visible
+ * range or the width of the widget changes.
+ */
+class NANOGUI_EXPORT MappedGraph : public Graph {
+public:
+    MappedGraph(Widget *parent, const std::string &caption = "Untitled");
+
+    MappedSeries *series() { return mSeries; }
+    void setSeries(MappedSeries *series);
+
+    /// Return the visible range of samples
+    Eigen::Vector2d view() const { return Eigen::Vector2d(mViewBegin, mViewEnd); }
+    /// Set the visible range of samples (clamped to the series)
+    void setView(double begin, double end);
+
+    /// Return the range of values mapped to the bottom and top of the graph (empty: automatic)
+    const Vector2f &valueRange() const { return mValueRange; }
+    void setValueRange(const Vector2f &valueRange) { mValueRange = valueRange; mViewDirty = true; }
+
+    virtual bool mouseDragEvent(const Vector2i &p, const Vector2i &rel, int button, int modifiers) override;
+    virtual bool scrollEvent(const Vector2i &p, const Vector2f &rel) override;
+    virtual void draw(NVGcontext *ctx) override;
+
+protected:
+    void updateValues();
+
+protected:
+    ref<MappedSeries> mSeries;
+    double mViewBegin, mViewEnd;
+    Vector2f mValueRange;
+    bool mViewDirty;
+    int mViewWidth;
+};
+
+NAMESPACE_END(nanogui)
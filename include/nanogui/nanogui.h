@@ -14,6 +14,7 @@
 #include <nanogui/common.h>
 #include <nanogui/widget.h>
 #include <nanogui/screen.h>
+#include <nanogui/texturemanager.h>
 #include <nanogui/theme.h>
 #include <nanogui/window.h>
 #include <nanogui/layout.h>
@@ -28,12 +29,20 @@
 #include <nanogui/entypo.h>
 #include <nanogui/messagedialog.h>
 #include <nanogui/textbox.h>
+#include <nanogui/texteditor.h>
 #include <nanogui/slider.h>
 #include <nanogui/imagepanel.h>
 #include <nanogui/imageview.h>
+#include <nanogui/tiledimageview.h>
+#include <nanogui/videoview.h>
+#include <nanogui/heatmap.h>
 #include <nanogui/vscrollpanel.h>
 #include <nanogui/colorwheel.h>
 #include <nanogui/graph.h>
+#include <nanogui/mappedgraph.h>
+#include <nanogui/plot.h>
+#include <nanogui/histogram.h>
+#include <nanogui/sparklinegrid.h>
 #include <nanogui/formhelper.h>
 #include <nanogui/stackedwidget.h>
 #include <nanogui/tabheader.h>
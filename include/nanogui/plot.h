@@ -0,0 +1,125 @@
+/*
+    nanogui/plot.h -- Plot widget for several data series with axes,
+    zooming and panning
+
+    NanoGUI was developed by Wenzel Jakob <wenzel.jakob@epfl.ch>.
+    The widget drawing code is based on the NanoVG demo application
+    by Mikko Mononen.
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+
+#pragma once
+
+#include <nanogui/widget.h>
+
+NAMESPACE_BEGIN(nanogui)
+
+/**
+ * \brief Plot of one or more named data series
+ *
+ * The axes are ranged automatically to fit all visible series, unless the
+ * user zooms (mouse wheel) or pans (dragging); a right click returns to the
+ * automatic range. Hovering shows the values of all series at the cursor.
+ *
+ * The data range of every series is computed once when it is set, and tick
+ * labels are only reformatted when the visible range changes.
+ */
+class NANOGUI_EXPORT Plot : public Widget {
+public:
+    struct Series {
+        std::string name;
+        /// Horizontal coordinates (empty: the sample index is used)
+        VectorXf x;
+        VectorXf y;
+        Color color;
+        bool visible;
+        /// Bounding box of the data (min x, min y, max x, max y)
+        Vector4f bounds;
+        /// Whether \ref x is in ascending order
+        bool sorted;
+    };
+
+    Plot(Widget *parent, const std::string &caption = "");
+
+    const std::string &caption() const { return mCaption; }
+    void setCaption(const std::string &caption) { mCaption = caption; }
+
+    const Color &backgroundColor() const { return mBackgroundColor; }
+    void setBackgroundColor(const Color &backgroundColor) { mBackgroundColor = backgroundColor; }
+
+    const Color &gridColor() const { return mGridColor; }
+    void setGridColor(const Color &gridColor) { mGridColor = gridColor; }
+
+    const Color &textColor() const { return mTextColor; }
+    void setTextColor(const Color &textColor) { mTextColor = textColor; }
+
+    /// Add a series plotted against the sample index, returning its index
+    int addSeries(const std::string &name, const VectorXf &y, const Color &color = Color(0, 0));
+    /// Add a series with explicit horizontal coordinates, returning its index
+    int addSeries(const std::string &name, const VectorXf &x, const VectorXf &y,
+                  const Color &color = Color(0, 0));
+
+    int seriesCount() const { return (int) mSeries.size(); }
+    const Series &series(int index) const { return mSeries[index]; }
+
+    /// Replace the values of a series (\c x may be empty)
+    void setSeriesValues(int index, const VectorXf &x, const VectorXf &y);
+    void setSeriesValues(int index, const VectorXf &y) { setSeriesValues(index, VectorXf(), y); }
+    void setSeriesVisible(int index, bool visible) { mSeries[index].visible = visible; mRangeDirty = true; }
+    void removeSeries(int index);
+    void clearSeries() { mSeries.clear(); mRangeDirty = true; }
+
+    /// Return the visible range as (min x, min y, max x, max y)
+    const Vector4f &view() const { return mView; }
+    /// Set the visible range, disabling automatic ranging
+    void setView(const Vector4f &view);
+    /// Return to the automatic range that fits all visible series
+    void resetView() { mAutoRange = true; mRangeDirty = true; }
+    bool autoRange() const { return mAutoRange; }
+
+    virtual bool mouseButtonEvent(const Vector2i &p, int button, bool down, int modifiers) override;
+    virtual bool mouseMotionEvent(const Vector2i &p, const Vector2i &rel, int button, int modifiers) override;
+    virtual bool mouseDragEvent(const Vector2i &p, const Vector2i &rel, int button, int modifiers) override;
+    virtual bool mouseEnterEvent(const Vector2i &p, bool enter) override;
+    virtual bool scrollEvent(const Vector2i &p, const Vector2f &rel) override;
+
+    virtual Vector2i preferredSize(NVGcontext *ctx) const override;
+    virtual void draw(NVGcontext *ctx) override;
+
+    virtual void save(Serializer &s) const override;
+    virtual bool load(Serializer &s) override;
+
+protected:
+    /// Tick positions and their formatted labels along one axis
+    struct Axis {
+        float min = 0, max = 0;
+        int pixels = 0;
+        std::vector<float> ticks;
+        std::vector<std::string> labels;
+        float labelWidth = 0;
+    };
+
+    void updateBounds(Series &series);
+    void updateRange();
+    void updateAxis(NVGcontext *ctx, Axis &axis, float min, float max, int pixels, int spacing);
+    void drawSeries(NVGcontext *ctx, const Series &series, const Vector2f &origin, const Vector2f &scale);
+    void drawReadout(NVGcontext *ctx, const Vector2f &origin, const Vector2f &scale);
+
+    /// Return the plot area (upper left corner and size, relative to the parent)
+    Vector4f plotArea() const;
+
+protected:
+    std::string mCaption;
+    Color mBackgroundColor, mGridColor, mTextColor;
+    std::vector<Series> mSeries;
+    Vector4f mView;
+    bool mAutoRange, mRangeDirty;
+    Axis mAxes[2];
+    float mMarginLeft;
+    bool mHover;
+    Vector2i mMousePos;
+};
+
+NAMESPACE_END(nanogui)
@@ -14,6 +14,7 @@
 #pragma once
 
 #include <nanogui/widget.h>
+#include <map>
 
 NAMESPACE_BEGIN(nanogui)
 
@@ -107,6 +108,9 @@ public:
     /// Draw the window contents -- put your OpenGL draw calls here
     virtual void drawContents() { /* To be overridden */ }
 
+    /// Draw the widgets, flushing distance field text after every top-level widget (see \ref Theme::mSdfText)
+    virtual void draw(NVGcontext *ctx) override;
+
     /// Handle a file drop event
     virtual bool dropEvent(const std::vector<std::string> & /* filenames */) { return false; /* To be overridden */ }
 
@@ -128,6 +132,27 @@ public:
     /// Return a pointer to the underlying nanoVG draw context
     NVGcontext *nvgContext() { return mNVGContext; }
 
+    /// Return the ratio between framebuffer and window coordinates (hi-dpi displays)
+    float pixelRatio() const { return mPixelRatio; }
+
+    /// Return the renderer that batches signed distance field text (see \ref Theme::mSdfText)
+    SdfTextRenderer *sdfText();
+
+    /// Return the cache of NanoVG images created in this screen's context
+    TextureManager *textureManager();
+
+    /**
+     * \brief Return a shader program used by many widgets of this screen
+     *
+     * The program is compiled from the given sources the first time its name
+     * is requested, and later requests return it without looking at the
+     * sources. Widgets draw with it via \ref GLShader::initShared(), so that
+     * it is compiled once per screen instead of once per widget. Returns
+     * \c nullptr if compilation failed, which is only reported once.
+     */
+    const GLShader *sharedShader(const std::string &name, const std::string &vertex,
+                                 const std::string &fragment, const std::string &geometry = "");
+
     void setShutdownGLFWOnDestruct(bool v) { mShutdownGLFWOnDestruct = v; }
     bool shutdownGLFWOnDestruct() { return mShutdownGLFWOnDestruct; }
 
@@ -192,6 +217,10 @@ protected:
     std::string mCaption;
     bool mShutdownGLFWOnDestruct;
     bool mFullscreen;
+    SdfTextRenderer *mSdfText = nullptr;
+    TextureManager *mTextureManager = nullptr;
+    /// Programs returned by \ref sharedShader() (\c nullptr if compilation failed)
+    std::map<std::string, GLShader *> mSharedShaders;
 };
 
 NAMESPACE_END(nanogui)
@@ -0,0 +1,151 @@
+/*
+    nanogui/sdftext.h -- Resolution-independent text rendering based on
+    signed distance field glyph atlases
+
+    NanoGUI was developed by Wenzel Jakob <wenzel.jakob@epfl.ch>.
+    The widget drawing code is based on the NanoVG demo application
+    by Mikko Mononen.
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+
+#pragma once
+
+#include <nanogui/object.h>
+#include <nanogui/glutil.h>
+#include <unordered_map>
+#include <vector>
+
+struct stbtt_fontinfo;
+
+NAMESPACE_BEGIN(nanogui)
+
+/**
+ * \brief Glyph atlas storing signed distance fields of a TrueType font
+ *
+ * Every glyph is rasterized exactly once at \ref baseSize() pixels and stored
+ * as a distance field, which is then used to render the glyph at any font size
+ * or pixel ratio. Glyphs are added to the atlas when they are first requested.
+ */
+class NANOGUI_EXPORT SdfFont : public Object {
+public:
+    struct Glyph {
+        /// Position and size of the glyph within the atlas (in texels)
+        int x, y, width, height;
+        /// Offset of the upper left corner relative to the pen position (at \ref baseSize())
+        float xoff, yoff;
+        /// Horizontal advance (at \ref baseSize())
+        float advance;
+    };
+
+    /**
+     * Create an atlas for the given TrueType font data, which must stay
+     * valid for the lifetime of the atlas. \c spread specifies the distance
+     * (in texels) that is covered by the distance field on each side of an edge.
+     */
+    SdfFont(const uint8_t *data, float baseSize = 48.f, int spread = 6);
+
+    /// Return the font size at which glyphs are rasterized
+    float baseSize() const { return mBaseSize; }
+
+    /// Return the distance covered by the distance field (in texels)
+    int spread() const { return mSpread; }
+
+    /// Return the ascender relative to the font size (as used by NanoVG)
+    float ascender() const { return mAscender; }
+
+    /// Return the descender relative to the font size (as used by NanoVG)
+    float descender() const { return mDescender; }
+
+    /// Return the size of the atlas texture
+    const Vector2i &atlasSize() const { return mAtlasSize; }
+
+    /// Look up a glyph, adding it to the atlas if necessary (\c nullptr if the atlas is full)
+    const Glyph *glyph(int codepoint);
+
+    /// Return the kerning adjustment between two codepoints (at \ref baseSize())
+    float kerning(int codepoint1, int codepoint2) const;
+
+    /// Compute the horizontal advance of a UTF-8 string at the given font size
+    float textWidth(const std::string &text, float size);
+
+    /// Bind the atlas texture to the active texture unit, uploading new glyphs first
+    void bindTexture();
+
+protected:
+    virtual ~SdfFont();
+
+    bool addGlyph(int codepoint, Glyph &glyph);
+
+protected:
+    stbtt_fontinfo *mFont;
+    float mBaseSize, mScale;
+    int mSpread;
+    float mAscender, mDescender;
+    std::unordered_map<int, Glyph> mGlyphs;
+    std::vector<uint8_t> mAtlas;
+    Vector2i mAtlasSize;
+    int mShelfX, mShelfY, mShelfHeight;
+    int mDirtyBegin, mDirtyEnd;
+    uint32_t mTexture;
+    Vector2i mTextureSize;
+};
+
+/**
+ * \brief Batches glyphs of \ref SdfFont atlases and draws them with a
+ * dedicated distance field shader
+ *
+ * Text is queued during widget drawing and rendered by \ref flush() once
+ * the NanoVG frame has ended. \ref Screen takes care of this when
+ * \ref Theme::mSdfText is enabled.
+ */
+class NANOGUI_EXPORT SdfTextRenderer {
+public:
+    SdfTextRenderer();
+    ~SdfTextRenderer();
+
+    /**
+     * \brief Queue a single line of text
+     *
+     * The position and alignment flags are interpreted like the parameters
+     * of \c nvgText(), including the current NanoVG transformation. Pixels
+     * outside of \c clip (upper left and lower right corner in screen
+     * coordinates) are discarded. Returns the horizontal advance.
+     */
+    float text(NVGcontext *ctx, SdfFont *font, float x, float y, float size,
+               int align, const Color &color, const std::string &text,
+               const Vector4f &clip);
+
+    /**
+     * \brief Queue a single glyph given by its codepoint (e.g. an icon)
+     *
+     * Like \ref text(), but without decoding or kerning a string.
+     */
+    float glyph(NVGcontext *ctx, SdfFont *font, int codepoint, float x, float y,
+                float size, int align, const Color &color, const Vector4f &clip);
+
+    /// Return whether text has been queued since the last flush
+    bool empty() const { return mBatches.empty(); }
+
+    /// Draw all queued text onto a framebuffer of the given size (in screen coordinates)
+    void flush(const Vector2i &size);
+
+protected:
+    struct Batch {
+        ref<SdfFont> font;
+        std::vector<float> positions, texcoords, colors, clips;
+    };
+
+    /// Return the batch of a font, creating it if necessary
+    Batch &batch(SdfFont *font);
+    void addQuad(Batch &batch, const float *xform, const SdfFont::Glyph &g, float x,
+                 float y, float scale, const Color &color, const Vector4f &clip);
+
+protected:
+    std::vector<Batch> mBatches;
+    GLShader *mShader;
+    GLShader::UniformHandle mUniformScreenSize, mUniformAtlas, mUniformAtlasSize;
+};
+
+NAMESPACE_END(nanogui)
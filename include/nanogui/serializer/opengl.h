@@ -41,11 +41,11 @@ struct serialization_helper<GLShader> {
 
                 if (item.first == "indices") {
                     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buf.id);
-                    glGetBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, totalSize,
+                    glGetBufferSubData(GL_ELEMENT_ARRAY_BUFFER, buf.offset, totalSize,
                                        temp.data());
                 } else {
                     glBindBuffer(GL_ARRAY_BUFFER, buf.id);
-                    glGetBufferSubData(GL_ARRAY_BUFFER, 0, totalSize, temp.data());
+                    glGetBufferSubData(GL_ARRAY_BUFFER, buf.offset, totalSize, temp.data());
                 }
                 s.set("data", temp);
                 s.pop();
@@ -88,6 +88,9 @@ struct serialization_helper<GLShader> {
                 s.pop();
 
                 size_t totalSize = (size_t) buf.size * (size_t) buf.compSize;
+                buf.capacity = totalSize;
+                buf.offset = 0;
+                buf.streaming = false;
                 if (key == "indices") {
                     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buf.id);
                     glBufferData(GL_ELEMENT_ARRAY_BUFFER, totalSize,
@@ -0,0 +1,107 @@
+/*
+    nanogui/sparklinegrid.h -- Grid of many small graphs that are drawn
+    with a constant number of draw calls
+
+    NanoGUI was developed by Wenzel Jakob <wenzel.jakob@epfl.ch>.
+    The widget drawing code is based on the NanoVG demo application
+    by Mikko Mononen.
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+
+#pragma once
+
+#include <nanogui/widget.h>
+#include <nanogui/glutil.h>
+
+NAMESPACE_BEGIN(nanogui)
+
+/**
+ * \brief Grid of captioned sparklines (small graphs without axes)
+ *
+ * This replaces large numbers of individual \ref Graph widgets. The samples
+ * of all sparklines are kept in a single vertex buffer and drawn by one
+ * \c glMultiDrawArrays() call into a texture, which is only rendered again
+ * when values or the layout change. Cell backgrounds and borders are
+ * submitted as one NanoVG path each, and all captions share the same font
+ * state (with \ref Theme::mSdfText, they end up in a single batch).
+ *
+ * Every sparkline is scaled to the range of its own values.
+ */
+class NANOGUI_EXPORT SparklineGrid : public Widget {
+public:
+    SparklineGrid(Widget *parent, int columns = 4);
+
+    int columns() const { return mColumns; }
+    void setColumns(int columns) { mColumns = std::max(columns, 1); mRenderDirty = true; }
+
+    const Vector2i &cellSize() const { return mCellSize; }
+    void setCellSize(const Vector2i &cellSize) { mCellSize = cellSize; mRenderDirty = true; }
+
+    int spacing() const { return mSpacing; }
+    void setSpacing(int spacing) { mSpacing = spacing; mRenderDirty = true; }
+
+    const Color &backgroundColor() const { return mBackgroundColor; }
+    void setBackgroundColor(const Color &backgroundColor) { mBackgroundColor = backgroundColor; }
+
+    const Color &foregroundColor() const { return mForegroundColor; }
+    void setForegroundColor(const Color &foregroundColor) { mForegroundColor = foregroundColor; mRenderDirty = true; }
+
+    const Color &textColor() const { return mTextColor; }
+    void setTextColor(const Color &textColor) { mTextColor = textColor; }
+
+    /// Append a sparkline, returning its index
+    int addSparkline(const std::string &caption, const VectorXf &values = VectorXf());
+
+    int count() const { return (int) mCells.size(); }
+    void clear() { mCells.clear(); mGeometryDirty = true; }
+
+    const std::string &caption(int index) const { return mCells[index].caption; }
+    void setCaption(int index, const std::string &caption) { mCells[index].caption = caption; }
+
+    const VectorXf &values(int index) const { return mCells[index].values; }
+    void setValues(int index, const VectorXf &values) { mCells[index].values = values; mGeometryDirty = true; }
+
+    virtual Vector2i preferredSize(NVGcontext *ctx) const override;
+    virtual void draw(NVGcontext *ctx) override;
+
+protected:
+    struct Cell {
+        std::string caption;
+        VectorXf values;
+    };
+
+    virtual ~SparklineGrid();
+
+    /// Return the upper left corner of a cell relative to the widget
+    Vector2f cellOrigin(int index) const {
+        return Vector2f((float) (index % mColumns), (float) (index / mColumns))
+            .cwiseProduct((mCellSize + Vector2i::Constant(mSpacing)).cast<float>());
+    }
+
+    void updateGeometry();
+    bool drawLinesGpu(NVGcontext *ctx);
+    void drawLines(NVGcontext *ctx);
+    void drawCaptions(NVGcontext *ctx);
+
+protected:
+    std::vector<Cell> mCells;
+    int mColumns;
+    Vector2i mCellSize;
+    int mSpacing;
+    Color mBackgroundColor, mForegroundColor, mTextColor;
+
+    /// Normalized samples of all cells: (position in the cell, value, cell index)
+    MatrixXf mGeometry;
+    std::vector<int> mFirst, mCount;
+    bool mGeometryDirty, mUploadDirty, mRenderDirty;
+
+    bool mGpuFailed;
+    GLShader *mShader;
+    GLShader::UniformHandle mUniformColumns, mUniformCellSize, mUniformSpacing,
+                            mUniformSize, mUniformColor;
+    GLRenderTexture *mTarget;
+};
+
+NAMESPACE_END(nanogui)
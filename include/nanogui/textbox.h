@@ -17,9 +17,47 @@
 #include <nanogui/compat.h>
 #include <nanogui/widget.h>
 #include <sstream>
+#include <regex>
+#include <cstdlib>
+#include <cerrno>
+#include <limits>
 
 NAMESPACE_BEGIN(nanogui)
 
+NAMESPACE_BEGIN(detail)
+/* Non-throwing conversion of text box contents into numbers. This relies on
+   the "C" numeric locale, which is selected by nanogui::init(). Integers that
+   do not fit into \c Scalar saturate instead of wrapping around */
+template <typename Scalar, typename std::enable_if<std::is_integral<Scalar>::value &&
+                                                   std::is_signed<Scalar>::value, int>::type = 0>
+Scalar parseNumber(const std::string &str) {
+    errno = 0;
+    long long value = std::strtoll(str.c_str(), nullptr, 10);
+    if (errno == ERANGE)
+        return value < 0 ? std::numeric_limits<Scalar>::min() : std::numeric_limits<Scalar>::max();
+    if (value < (long long) std::numeric_limits<Scalar>::min())
+        return std::numeric_limits<Scalar>::min();
+    if (value > (long long) std::numeric_limits<Scalar>::max())
+        return std::numeric_limits<Scalar>::max();
+    return (Scalar) value;
+}
+
+template <typename Scalar, typename std::enable_if<std::is_integral<Scalar>::value &&
+                                                   !std::is_signed<Scalar>::value, int>::type = 0>
+Scalar parseNumber(const std::string &str) {
+    errno = 0;
+    unsigned long long value = std::strtoull(str.c_str(), nullptr, 10);
+    if (errno == ERANGE || value > (unsigned long long) std::numeric_limits<Scalar>::max())
+        return std::numeric_limits<Scalar>::max();
+    return (Scalar) value;
+}
+
+template <typename Scalar, typename std::enable_if<std::is_floating_point<Scalar>::value, int>::type = 0>
+Scalar parseNumber(const std::string &str) {
+    return (Scalar) std::strtod(str.c_str(), nullptr);
+}
+NAMESPACE_END(detail)
+
 class NANOGUI_EXPORT TextBox : public Widget {
 public:
     enum class Alignment {
@@ -53,8 +91,19 @@ public:
 
     /// Return the underlying regular expression specifying valid formats
     const std::string &format() const { return mFormat; }
-    /// Specify a regular expression specifying valid formats
-    void setFormat(const std::string &format) { mFormat = format; }
+    /**
+     * \brief Specify a regular expression specifying valid formats
+     *
+     * The expression is compiled once here rather than on every keystroke.
+     * The integer and floating point formats used by \ref IntBox and
+     * \ref FloatBox are recognized and checked without a regular expression.
+     */
+    void setFormat(const std::string &format);
+
+    /// Return the custom validation function, if any
+    std::function<bool(const std::string& str)> validator() const { return mValidator; }
+    /// Specify a validation function which is used instead of the format regular expression
+    void setValidator(const std::function<bool(const std::string& str)> &validator) { mValidator = validator; }
 
     /// Set the \ref Theme used to draw this widget
     virtual void setTheme(Theme *theme) override;
@@ -90,6 +139,9 @@ protected:
     enum class SpinArea { None, Top, Bottom };
     SpinArea spinArea(const Vector2i & pos);
 
+    /// How \ref checkFormat validates input matching \ref mFormat
+    enum class FormatCheck { None, Regex, Integer, UnsignedInteger, Float };
+
 protected:
     bool mEditable;
     bool mSpinnable;
@@ -99,6 +151,9 @@ protected:
     Alignment mAlignment;
     std::string mUnits;
     std::string mFormat;
+    FormatCheck mFormatCheck;
+    std::regex mFormatRegex;
+    std::function<bool(const std::string& str)> mValidator;
     int mUnitsImage;
     std::function<bool(const std::string& str)> mCallback;
     bool mValidFormat;
@@ -125,10 +180,7 @@ public:
     }
 
     Scalar value() const {
-        std::istringstream iss(TextBox::value());
-        Scalar value = 0;
-        iss >> value;
-        return value;
+        return detail::parseNumber<Scalar>(TextBox::value());
     }
 
     void setValue(Scalar value) {
@@ -139,9 +191,7 @@ public:
     void setCallback(const std::function<void(Scalar)> &cb) {
         TextBox::setCallback(
             [cb, this](const std::string &str) {
-                std::istringstream iss(str);
-                Scalar value = 0;
-                iss >> value;
+                Scalar value = detail::parseNumber<Scalar>(str);
                 setValue(value);
                 cb(value);
                 return true;
@@ -231,7 +281,7 @@ public:
     void numberFormat(const std::string &format) { mNumberFormat = format; }
 
     Scalar value() const {
-        return (Scalar) std::stod(TextBox::value());
+        return detail::parseNumber<Scalar>(TextBox::value());
     }
 
     void setValue(Scalar value) {
@@ -243,7 +293,7 @@ public:
 
     void setCallback(const std::function<void(Scalar)> &cb) {
         TextBox::setCallback([cb, this](const std::string &str) {
-            Scalar scalar = (Scalar) std::stod(str);
+            Scalar scalar = detail::parseNumber<Scalar>(str);
             setValue(scalar);
             cb(scalar);
             return true;
@@ -0,0 +1,197 @@
+/*
+    nanogui/texteditor.h -- Multi-line text editor backed by a piece table
+
+    NanoGUI was developed by Wenzel Jakob <wenzel.jakob@epfl.ch>.
+    The widget drawing code is based on the NanoVG demo application
+    by Mikko Mononen.
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+
+#pragma once
+
+#include <nanogui/widget.h>
+#include <functional>
+
+NAMESPACE_BEGIN(nanogui)
+
+NAMESPACE_BEGIN(detail)
+
+/**
+ * \brief Piece table storing the contents of a \ref TextEditor
+ *
+ * The document is a sequence of pieces that reference either the original
+ * text or an append-only buffer of inserted text, so edits never move
+ * existing characters. Pieces are kept in a treap (randomized balanced
+ * binary tree) whose nodes are augmented with subtree lengths and newline
+ * counts. Edits, offset lookups and line lookups therefore take O(log n)
+ * time irrespective of the document size.
+ */
+class NANOGUI_EXPORT PieceTable {
+public:
+    /// Contiguous range of one of the two buffers (0: original, 1: added text)
+    struct Piece {
+        uint32_t buffer;
+        size_t start;
+        size_t length;
+    };
+
+    PieceTable() { reset(""); }
+
+    /// Replace the contents of the table (discarding all buffers)
+    void reset(const std::string &text);
+
+    /// Return the document length in bytes
+    size_t size() const { return mNodes[mRoot].totalLength; }
+
+    /// Return the number of lines (one more than the number of newlines)
+    size_t lineCount() const { return mNodes[mRoot].totalNewlines + 1; }
+
+    /// Return the offset of the first character of a line
+    size_t lineStart(size_t line) const;
+
+    /// Return the offset of the newline terminating a line (or \ref size() for the last line)
+    size_t lineEnd(size_t line) const;
+
+    /// Return the line containing the given offset
+    size_t lineOf(size_t offset) const;
+
+    /// Extract a range of the document
+    std::string text(size_t pos, size_t length) const;
+
+    /// Return the whole document
+    std::string str() const { return text(0, size()); }
+
+    /// Insert text, returning the piece of the added buffer that now holds it
+    Piece insert(size_t pos, const std::string &text);
+
+    /// Insert a sequence of previously removed pieces
+    void insert(size_t pos, const std::vector<Piece> &pieces);
+
+    /// Remove a range, returning the pieces that referenced it
+    std::vector<Piece> erase(size_t pos, size_t length);
+
+protected:
+    struct Node {
+        Piece piece;
+        size_t newlines;
+        size_t totalLength, totalNewlines;
+        uint32_t priority;
+        int left, right;
+    };
+
+    int newNode(const Piece &piece);
+    void freeNodes(int node, std::vector<Piece> *pieces);
+    void update(int node);
+    int merge(int left, int right);
+    void split(int node, size_t pos, int &left, int &right);
+    bool extendLast(int node, const Piece &piece);
+    size_t countNewlines(const Piece &piece) const;
+    void collect(int node, size_t begin, size_t end, std::string &out) const;
+
+protected:
+    std::string mBuffers[2];
+    /// Sorted offsets of all newlines within each buffer
+    std::vector<size_t> mNewlines[2];
+    /// Node storage (index 0 is the empty tree)
+    std::vector<Node> mNodes;
+    std::vector<int> mFreeNodes;
+    int mRoot;
+    uint32_t mSeed;
+};
+
+NAMESPACE_END(detail)
+
+/**
+ * \brief Multi-line text editor
+ *
+ * The text is stored in a \ref detail::PieceTable, and only the lines that
+ * are currently visible are laid out when drawing, so that even documents
+ * of several megabytes can be edited without stalls. Undo and redo are
+ * based on compact edit records that reference pieces of the table rather
+ * than copies of the text.
+ */
+class NANOGUI_EXPORT TextEditor : public Widget {
+public:
+    TextEditor(Widget *parent, const std::string &value = "");
+
+    /// Return the document (assembled from the piece table)
+    std::string value() const { return mBuffer.str(); }
+    /// Replace the document, clearing the undo history
+    void setValue(const std::string &value);
+
+    /// Return the underlying piece table
+    const detail::PieceTable &buffer() const { return mBuffer; }
+
+    bool editable() const { return mEditable; }
+    void setEditable(bool editable) { mEditable = editable; }
+
+    /// Return the cursor position (byte offset)
+    size_t cursor() const { return mCursor; }
+    /// Move the cursor and clear the selection
+    void setCursor(size_t cursor);
+
+    /// Return the selected range as (begin, end); empty if nothing is selected
+    std::pair<size_t, size_t> selection() const {
+        return std::make_pair(std::min(mCursor, mAnchor), std::max(mCursor, mAnchor));
+    }
+
+    bool canUndo() const { return !mUndo.empty(); }
+    bool canRedo() const { return !mRedo.empty(); }
+    void undo();
+    void redo();
+
+    /// Set the callback that is invoked after every modification of the document
+    std::function<void()> callback() const { return mCallback; }
+    void setCallback(const std::function<void()> &callback) { mCallback = callback; }
+
+    virtual bool mouseButtonEvent(const Vector2i &p, int button, bool down, int modifiers) override;
+    virtual bool mouseDragEvent(const Vector2i &p, const Vector2i &rel, int button, int modifiers) override;
+    virtual bool scrollEvent(const Vector2i &p, const Vector2f &rel) override;
+    virtual bool keyboardEvent(int key, int scancode, int action, int modifiers) override;
+    virtual bool keyboardCharacterEvent(unsigned int codepoint) override;
+
+    virtual Vector2i preferredSize(NVGcontext *ctx) const override;
+    virtual void draw(NVGcontext* ctx) override;
+    virtual void save(Serializer &s) const override;
+    virtual bool load(Serializer &s) override;
+
+protected:
+    /// Edit record: a range of the document that was inserted or removed
+    struct Edit {
+        bool insert;
+        size_t pos, length;
+        std::vector<detail::PieceTable::Piece> pieces;
+    };
+
+    void insertText(const std::string &text);
+    void eraseRange(size_t begin, size_t end);
+    bool deleteSelection();
+    void copySelection();
+    void pasteFromClipboard();
+    void moveCursor(size_t pos, bool select);
+    void changed();
+
+    size_t prevChar(size_t pos) const;
+    size_t nextChar(size_t pos) const;
+    size_t column(size_t pos) const;
+    size_t offsetAtColumn(size_t line, size_t column) const;
+    float lineHeight() const { return fontSize() * 1.3f; }
+    size_t offsetAt(NVGcontext *ctx, const Vector2i &p, float textX, float textY);
+
+protected:
+    detail::PieceTable mBuffer;
+    bool mEditable;
+    size_t mCursor, mAnchor;
+    size_t mPreferredColumn;
+    std::vector<Edit> mUndo, mRedo;
+    float mScrollX, mScrollY;
+    bool mScrollToCursor;
+    Vector2i mMouseDownPos;
+    Vector2i mMouseDragPos;
+    int mMouseDownModifier;
+    std::function<void()> mCallback;
+};
+
+NAMESPACE_END(nanogui)
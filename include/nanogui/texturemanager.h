@@ -0,0 +1,182 @@
+/*
+    nanogui/texturemanager.h -- Per-screen cache of NanoVG images with a
+    GPU memory budget
+
+    NanoGUI was developed by Wenzel Jakob <wenzel.jakob@epfl.ch>.
+    The widget drawing code is based on the NanoVG demo application
+    by Mikko Mononen.
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+
+#pragma once
+
+#include <nanogui/object.h>
+#include <functional>
+#include <list>
+#include <unordered_map>
+
+NAMESPACE_BEGIN(nanogui)
+
+/**
+ * \brief Cache of NanoVG images that keeps their texture memory within a budget
+ *
+ * Every image is created from a source (a file, data in memory, or a custom
+ * loader) and identified by a key, so that loading the same source twice
+ * returns the same \ref Image. When the textures take up more than
+ * \ref budget() bytes, the least recently used images are evicted from the
+ * GPU. An image that is still referenced is transparently loaded again the
+ * next time its \ref Image::handle() is requested, while unreferenced images
+ * are forgotten entirely. Images drawn in the current frame and persistent
+ * images are never evicted.
+ *
+ * Each \ref Screen owns one instance (see \ref Screen::textureManager()).
+ * All methods must be called on the UI thread.
+ *
+ * \ref ImageView and \ref ImagePanel accept images directly and request
+ * their handles whenever they draw them. A raw handle that is stored
+ * elsewhere (e.g. passed to \ref ImageView::setImage(int)) is only safe if
+ * the image is made persistent, since it is otherwise invalidated on eviction.
+ */
+class NANOGUI_EXPORT TextureManager {
+public:
+    /// Create a NanoVG image in the given context (returns 0 on failure)
+    typedef std::function<int(NVGcontext *)> Loader;
+
+    /// Reference counted handle of a managed image
+    class NANOGUI_EXPORT Image : public Object {
+        friend class TextureManager;
+    public:
+        /// Return the key identifying the source of the image
+        const std::string &key() const { return mKey; }
+
+        /**
+         * \brief Return the NanoVG image, loading it first if it is not
+         * resident (0 if loading failed or the manager no longer exists)
+         *
+         * The image is marked as used in the current frame, which protects
+         * it from eviction until the next frame begins. Note that the handle
+         * may change after the image was evicted.
+         */
+        int handle();
+
+        /// Return whether the image is currently loaded on the GPU
+        bool resident() const { return mHandle != 0; }
+
+        /// Return whether loading the image failed
+        bool failed() const { return mFailed; }
+
+        /// Return the size of the image in pixels (zero until it was first loaded)
+        const Vector2i &size() const { return mSize; }
+
+        /// Return the estimated texture memory of the image (in bytes)
+        size_t bytes() const { return mBytes; }
+
+        /// Return whether the image is exempt from eviction
+        bool persistent() const { return mPersistent; }
+        void setPersistent(bool persistent) { mPersistent = persistent; }
+
+    protected:
+        Image(TextureManager *manager, const std::string &key, const Loader &loader, int flags);
+        virtual ~Image();
+
+    protected:
+        TextureManager *mManager;
+        std::string mKey;
+        Loader mLoader;
+        int mFlags;
+        int mHandle = 0;
+        Vector2i mSize = Vector2i::Zero();
+        size_t mBytes = 0;
+        bool mPersistent = false;
+        bool mFailed = false;
+        /// Last frame in which the image was drawn
+        uint64_t mFrame = 0;
+        /// Position in the recency list of the manager
+        std::list<Image *>::iterator mPosition;
+    };
+
+    /// Summary of the images held by a manager
+    struct Statistics {
+        /// Number of known images (resident or not)
+        size_t images = 0;
+        /// Number of images on the GPU and their texture memory (in bytes)
+        size_t residentImages = 0, residentBytes = 0;
+        /// Total number of textures created and evicted so far
+        size_t loads = 0, evictions = 0;
+    };
+
+    /// Create a manager for images of the given context with a budget (in bytes)
+    TextureManager(NVGcontext *ctx, size_t budget = 256 * 1024 * 1024);
+
+    /// Delete all textures; remaining \ref Image handles become empty
+    ~TextureManager();
+
+    TextureManager(const TextureManager &) = delete;
+    TextureManager &operator=(const TextureManager &) = delete;
+
+    NVGcontext *context() const { return mContext; }
+
+    /// Return the amount of texture memory that the images may occupy (in bytes)
+    size_t budget() const { return mBudget; }
+    /// Set the budget, evicting images if it is exceeded
+    void setBudget(size_t budget) { mBudget = budget; enforceBudget(); }
+
+    /**
+     * \brief Return the image with the given key, registering it with the
+     * given loader if it is not known yet
+     *
+     * \c flags are the NanoVG image flags passed to the loader, which are
+     * used to estimate the texture memory (mipmaps add a third).
+     * The texture is created when \ref Image::handle() is first called.
+     */
+    ref<Image> image(const std::string &key, const Loader &loader, int flags = 0);
+
+    /// Return the image stored in the given file
+    ref<Image> load(const std::string &filename, int flags = 0);
+
+    /**
+     * \brief Return the image encoded in memory (e.g. by bin2c), identified
+     * by \c name. The data must stay valid while the manager exists.
+     */
+    ref<Image> loadMemory(const std::string &name, const uint8_t *data, size_t size, int flags = 0);
+
+    /// Return the texture memory of the resident images (in bytes)
+    size_t residentBytes() const { return mResidentBytes; }
+
+    /// Return statistics about the managed images
+    Statistics statistics() const;
+
+    /// Start a new frame; images drawn in previous frames become candidates for eviction
+    void beginFrame() { mFrame++; }
+
+    /// Evict least recently used images until the budget is met
+    void enforceBudget();
+
+    /// Evict all resident images that are not persistent or in use in this frame
+    void trim();
+
+protected:
+    /// Create the texture of an image (called by \ref Image::handle())
+    void createTexture(Image *image);
+    /// Delete the texture of an image, forgetting the image if it is unreferenced
+    void evict(Image *image);
+    /// Evict least recently used images until at most \c bytes are resident
+    void evictUntil(size_t bytes);
+    /// Forget unreferenced images that are not resident (e.g. failed ones)
+    void sweep();
+
+protected:
+    NVGcontext *mContext;
+    size_t mBudget;
+    size_t mResidentBytes = 0;
+    size_t mLoads = 0, mEvictions = 0;
+    uint64_t mFrame = 1;
+    size_t mSweepThreshold = 64;
+    std::unordered_map<std::string, ref<Image>> mImages;
+    /// Resident images, most recently used first
+    std::list<Image *> mRecent;
+};
+
+NAMESPACE_END(nanogui)
@@ -15,17 +15,61 @@
 
 #include <nanogui/common.h>
 #include <nanogui/object.h>
+#include <nanogui/sdftext.h>
 
 NAMESPACE_BEGIN(nanogui)
 
 class NANOGUI_EXPORT Theme : public Object {
 public:
+    /**
+     * \brief Glyphs that should be rasterized ahead of time
+     *
+     * Every combination of font, size and codepoint range is rendered once
+     * into the NanoVG glyph atlas, so that the first frame using a given
+     * font size does not stall on rasterization and texture uploads.
+     */
+    struct GlyphPrewarm {
+        std::vector<std::string> fonts;
+        std::vector<float> sizes;
+        /// Inclusive ranges of UTF-32 codepoints
+        std::vector<std::pair<int, int>> ranges;
+    };
+
     Theme(NVGcontext *ctx);
 
+    /// Return the glyph prewarm specification
+    const GlyphPrewarm &glyphPrewarm() const { return mGlyphPrewarm; }
+
+    /// Set the glyph prewarm specification (processed during subsequent frames)
+    void setGlyphPrewarm(const GlyphPrewarm &prewarm);
+
+    /// Return whether some glyphs of the prewarm specification have not been rasterized yet
+    bool glyphPrewarmPending() const { return mPrewarmFont < mGlyphPrewarm.fonts.size(); }
+
+    /**
+     * \brief Rasterize pending glyphs of the prewarm specification
+     *
+     * Must be called between \c nvgBeginFrame() and \c nvgEndFrame(); stops
+     * after \c budget seconds so that prewarming is spread over several
+     * frames. \ref Screen invokes this automatically with \ref mGlyphPrewarmBudget.
+     * Returns \c true once all glyphs have been rasterized.
+     */
+    bool prewarmGlyphs(NVGcontext *ctx, double budget);
+
+    /**
+     * \brief Return the signed distance field atlas of a font ("sans",
+     * "sans-bold" or "icons"), or \c nullptr for other fonts
+     *
+     * The atlases are created on first use.
+     */
+    SdfFont *sdfFont(const std::string &face);
+
     /* Fonts */
     int mFontNormal;
     int mFontBold;
     int mFontIcons;
+    /// Render text of supported widgets from signed distance field atlases
+    bool mSdfText;
 
     /* Spacing-related parameters */
     int mStandardFontSize;
@@ -42,6 +86,8 @@ public:
     int mTabControlWidth;
     int mTabButtonHorizontalPadding;
     int mTabButtonVerticalPadding;
+    /// Time in seconds per frame that may be spent on glyph prewarming
+    double mGlyphPrewarmBudget;
 
     /* Generic colors */
     Color mDropShadow;
@@ -77,6 +123,12 @@ public:
     Color mWindowPopupTransparent;
 protected:
     virtual ~Theme() { };
+
+protected:
+    GlyphPrewarm mGlyphPrewarm;
+    size_t mPrewarmFont, mPrewarmSize, mPrewarmRange;
+    int mPrewarmCodepoint;
+    ref<SdfFont> mSdfFontNormal, mSdfFontBold, mSdfFontIcons;
 };
 
 NAMESPACE_END(nanogui)
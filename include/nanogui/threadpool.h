@@ -0,0 +1,67 @@
+/*
+    nanogui/threadpool.h -- Simple pool of worker threads for running
+    background jobs outside of the UI thread
+
+    NanoGUI was developed by Wenzel Jakob <wenzel.jakob@epfl.ch>.
+    The widget drawing code is based on the NanoVG demo application
+    by Mikko Mononen.
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+
+#pragma once
+
+#include <nanogui/common.h>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+
+NAMESPACE_BEGIN(nanogui)
+
+/**
+ * \brief Fixed-size pool of worker threads
+ *
+ * Widgets use this to move expensive work (searching, decoding, binning, ..)
+ * off the UI thread. Jobs must not touch NanoVG or OpenGL state; they should
+ * publish their results into a mutex-protected staging area that the widget
+ * drains in its \c draw() method. Call \ref ThreadPool::wakeup() once results
+ * are ready so that the main loop redraws without waiting for the refresh timer.
+ */
+class NANOGUI_EXPORT ThreadPool {
+public:
+    /// Create a pool with the given number of threads (0: one per hardware thread)
+    ThreadPool(size_t threadCount = 0);
+
+    /// Wait for all running jobs to finish and release the worker threads
+    ~ThreadPool();
+
+    /// Append a job to the queue
+    void enqueue(const std::function<void()> &job);
+
+    /// Return the number of worker threads
+    size_t size() const { return mThreads.size(); }
+
+    /// Return the number of jobs that have not been picked up by a worker yet
+    size_t pending() const;
+
+    /// Shared pool used by the built-in widgets
+    static ThreadPool &global();
+
+    /// Wake up the main loop so that results of a finished job are drawn
+    static void wakeup();
+
+protected:
+    void worker();
+
+protected:
+    std::vector<std::thread> mThreads;
+    std::deque<std::function<void()>> mJobs;
+    mutable std::mutex mMutex;
+    std::condition_variable mCond;
+    bool mShutdown;
+};
+
+NAMESPACE_END(nanogui)
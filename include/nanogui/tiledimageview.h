@@ -0,0 +1,257 @@
+/*
+    nanogui/tiledimageview.h -- Zoomable view of images that are too large
+    to be loaded into memory, streamed as tiles of a resolution pyramid
+
+    NanoGUI was developed by Wenzel Jakob <wenzel.jakob@epfl.ch>.
+    The widget drawing code is based on the NanoVG demo application
+    by Mikko Mononen.
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+
+#pragma once
+
+#include <nanogui/widget.h>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+
+NAMESPACE_BEGIN(nanogui)
+
+NAMESPACE_BEGIN(detail)
+class MappedFile;
+struct TilePyramidBuild;
+struct TileRequests;
+NAMESPACE_END(detail)
+
+/**
+ * \brief Source of square RGBA tiles of an image at multiple resolutions
+ *
+ * Level 0 is the full resolution image, and every further level halves the
+ * width and height (rounding up) until the image fits into a single tile.
+ * The tile at (x, y) of level \c l covers the pixels starting at
+ * (x, y) * tileSize() of that level.
+ */
+class NANOGUI_EXPORT TileSource : public Object {
+public:
+    /// Return the size of the full resolution image
+    const Vector2i &size() const { return mSize; }
+
+    /// Return the width and height of a tile
+    int tileSize() const { return mTileSize; }
+
+    /// Return the number of levels
+    int levelCount() const { return mLevelCount; }
+
+    /// Return the size of the image at the given level
+    Vector2i levelSize(int level) const {
+        return Vector2i(((mSize.x() - 1) >> level) + 1, ((mSize.y() - 1) >> level) + 1);
+    }
+
+    /// Return the number of tiles in each direction at the given level
+    Vector2i tileCount(int level) const {
+        return (levelSize(level).array() + mTileSize - 1) / mTileSize;
+    }
+
+    /// Return whether the tiles of a level can be read (e.g. while it is still being generated)
+    virtual bool levelReady(int /* level */) const { return true; }
+
+    /// Return the progress of preparing the levels that are not ready yet (between 0 and 1)
+    virtual float progress() const { return 1.f; }
+
+    /// Return whether preparing the levels failed, so that the levels that are not ready never will be
+    virtual bool failed() const { return false; }
+
+    /// Pick up work that was completed in the background (UI thread only); returns \c true if levels became ready
+    virtual bool update() { return false; }
+
+    /**
+     * \brief Decode a tile into \c tileSize() x \c tileSize() RGBA pixels
+     * (8 bit per channel) at \c rgba
+     *
+     * This is called concurrently by multiple worker threads. Pixels past the
+     * edge of the image may be left undefined. Returns \c false on failure.
+     */
+    virtual bool readTile(int level, int x, int y, uint8_t *rgba) const = 0;
+
+protected:
+    TileSource(const Vector2i &size, int tileSize);
+
+protected:
+    Vector2i mSize;
+    int mTileSize;
+    int mLevelCount;
+};
+
+/**
+ * \brief \ref TileSource for a memory-mapped file of raw RGBA pixels
+ *
+ * The file contains the rows of the image one after another, with 8 bit per
+ * channel. Full resolution tiles are copied directly out of the mapping. The
+ * coarser levels are built on a background thread (2x2 box filter) and stored
+ * next to the image file with the suffix ".tiles". Later instances reuse them
+ * as long as the size and modification time of the image file are unchanged.
+ * If the file cannot be written, only the full resolution is available
+ * (see \ref failed()).
+ */
+class NANOGUI_EXPORT RawTileSource : public TileSource {
+public:
+    /// Map the given image file (throws \c std::runtime_error on failure)
+    RawTileSource(const std::string &filename, const Vector2i &size, int tileSize = 256);
+
+    /// Return the name of the image file
+    const std::string &filename() const { return mFilename; }
+
+    virtual bool levelReady(int level) const override { return level == 0 || (bool) mPyramid; }
+    virtual float progress() const override;
+    virtual bool failed() const override { return mFailed; }
+    virtual bool update() override;
+    virtual bool readTile(int level, int x, int y, uint8_t *rgba) const override;
+
+protected:
+    virtual ~RawTileSource();
+
+    /// Map an existing pyramid file (returns \c false if it is missing or stale)
+    bool loadPyramid();
+
+protected:
+    std::string mFilename;
+    std::unique_ptr<detail::MappedFile> mData;
+    std::unique_ptr<detail::MappedFile> mPyramid;
+    std::shared_ptr<detail::TilePyramidBuild> mBuild;
+    int64_t mTimestamp;
+    /// Whether the pyramid could not be built (e.g. in a read-only directory)
+    bool mFailed;
+};
+
+/**
+ * \brief Zoomable and pannable view of a \ref TileSource
+ *
+ * Only the tiles covering the widget are loaded, from the level that matches
+ * the current magnification. Tiles are decoded by jobs on
+ * \ref ThreadPool::global() (closest to the center of the view first) and
+ * uploaded while drawing, limited to \ref uploadBudget() seconds per frame.
+ * Until a tile arrives, the matching part of a coarser tile is shown. At most
+ * \ref cacheSize() tiles are kept on the GPU, evicting the least recently used.
+ *
+ * The mouse wheel zooms smoothly around the cursor, and dragging pans the
+ * view. At high magnification, pixels are drawn without interpolation and
+ * separated by a grid.
+ */
+class NANOGUI_EXPORT TiledImageView : public Widget {
+public:
+    TiledImageView(Widget *parent);
+
+    TileSource *source() { return mSource; }
+    /// Show a different image, fitting it into the widget
+    void setSource(TileSource *source);
+
+    /// Return the magnification (screen pixels per image pixel)
+    double scale() const { return mScale; }
+    /// Set the magnification, keeping the image position under \c pivot (relative to the widget) fixed
+    void setScale(double scale, const Vector2f &pivot);
+
+    /// Return the image position shown at the upper left corner of the widget
+    const Eigen::Vector2d &offset() const { return mOffset; }
+    void setOffset(const Eigen::Vector2d &offset);
+
+    /// Show the whole image, centered in the widget
+    void fit();
+
+    /// Convert a position relative to the widget into image coordinates
+    Eigen::Vector2d imageCoordinate(const Vector2f &position) const {
+        return mOffset + position.cast<double>() / mScale;
+    }
+
+    /// Convert image coordinates into a position relative to the widget
+    Vector2f positionForCoordinate(const Eigen::Vector2d &coordinate) const {
+        return ((coordinate - mOffset) * mScale).cast<float>();
+    }
+
+    /// Magnification at which the pixel grid appears (0: never)
+    double gridThreshold() const { return mGridThreshold; }
+    void setGridThreshold(double gridThreshold) { mGridThreshold = gridThreshold; }
+
+    const Color &gridColor() const { return mGridColor; }
+    void setGridColor(const Color &gridColor) { mGridColor = gridColor; }
+
+    /// Maximum number of tiles kept on the GPU
+    int cacheSize() const { return mCacheSize; }
+    void setCacheSize(int cacheSize) { mCacheSize = std::max(cacheSize, 1); }
+
+    /// Maximum time spent on uploading tiles per frame (in seconds)
+    double uploadBudget() const { return mUploadBudget; }
+    void setUploadBudget(double uploadBudget) { mUploadBudget = uploadBudget; }
+
+    virtual bool mouseDragEvent(const Vector2i &p, const Vector2i &rel, int button, int modifiers) override;
+    virtual bool scrollEvent(const Vector2i &p, const Vector2f &rel) override;
+    virtual void draw(NVGcontext *ctx) override;
+
+protected:
+    struct Tile {
+        uint64_t key;
+        uint32_t texture;
+        int image;
+        bool nearest;
+        /// Last frame in which the tile was drawn or requested
+        uint64_t frame;
+    };
+
+    virtual ~TiledImageView();
+
+    static uint64_t tileKey(int level, int x, int y) {
+        return ((uint64_t) level << 56) | ((uint64_t) x << 28) | (uint64_t) y;
+    }
+
+    /// Return the range [x0, x1) x [y0, y1) of tiles of a level that cover the widget
+    Vector4i visibleTiles(int level) const;
+
+    /// Return the level matching the current magnification (-1: none can be drawn yet)
+    int drawLevel();
+
+    /// Look up a cached tile, marking it as used in this frame
+    Tile *findTile(uint64_t key);
+
+    /// Draw the area of tile (level, x, y) using a cached tile of the same or a coarser level
+    void drawTile(NVGcontext *ctx, Tile &tile, int tileLevel, int tileX, int tileY,
+                  int level, int x, int y);
+    void drawGrid(NVGcontext *ctx);
+
+    /// Return the magnification at which the whole image fits into the widget
+    double fitScale() const;
+    /// Change the magnification without affecting the zoom animation
+    void applyScale(double scale, const Vector2f &pivot);
+    void animateZoom();
+    void requestTiles(const std::vector<uint64_t> &missing);
+    void uploadTiles(NVGcontext *ctx);
+    void evictTiles(NVGcontext *ctx);
+    void releaseTiles();
+
+protected:
+    ref<TileSource> mSource;
+    double mScale;
+    Eigen::Vector2d mOffset;
+    bool mFitPending;
+
+    /// Target of the zoom animation
+    double mZoomTarget;
+    Vector2f mZoomPivot;
+    double mZoomTime;
+
+    double mGridThreshold;
+    Color mGridColor;
+    int mCacheSize;
+    double mUploadBudget;
+
+    /// Cached tiles, most recently used first
+    std::list<Tile> mTiles;
+    std::unordered_map<uint64_t, std::list<Tile>::iterator> mTileIndex;
+    std::unordered_set<uint64_t> mFailedTiles;
+    std::shared_ptr<detail::TileRequests> mRequests;
+    std::vector<int> mReleasedImages;
+    uint64_t mFrame;
+};
+
+NAMESPACE_END(nanogui)
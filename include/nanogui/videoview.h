@@ -0,0 +1,190 @@
+/*
+    nanogui/videoview.h -- Widget that shows a stream of video frames
+    produced by another thread
+
+    NanoGUI was developed by Wenzel Jakob <wenzel.jakob@epfl.ch>.
+    The widget drawing code is based on the NanoVG demo application
+    by Mikko Mononen.
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+
+#pragma once
+
+#include <nanogui/widget.h>
+#include <nanogui/glutil.h>
+#include <mutex>
+
+NAMESPACE_BEGIN(nanogui)
+
+/// A video frame whose planes are stored one after another without padding
+struct NANOGUI_EXPORT VideoFrame {
+    enum class Format {
+        /// 8 bit luma plane followed by quarter-size Cb and Cr planes
+        I420,
+        /// 8 bit luma plane followed by a quarter-size plane of interleaved Cb/Cr pairs
+        NV12,
+        /// Interleaved 8 bit RGB
+        RGB,
+        /// Interleaved 8 bit RGBA
+        RGBA
+    };
+
+    Format format = Format::RGBA;
+    Vector2i size = Vector2i::Zero();
+    /// Presentation time (in seconds, defined by the producer)
+    double timestamp = 0;
+    std::vector<uint8_t> data;
+
+    /// Return the number of planes of a format
+    static int planeCount(Format format);
+    /// Return the number of 8 bit components per pixel of a plane
+    static int planeChannels(Format format, int plane);
+    /// Return the width and height of a plane
+    static Vector2i planeSize(Format format, const Vector2i &size, int plane);
+    /// Return the number of bytes occupied by a frame
+    static size_t frameBytes(Format format, const Vector2i &size);
+
+    /// Return the position of a plane within \ref data
+    size_t planeOffset(int plane) const;
+    uint8_t *plane(int plane) { return data.data() + planeOffset(plane); }
+    const uint8_t *plane(int plane) const { return data.data() + planeOffset(plane); }
+};
+
+/**
+ * \brief Hands the most recent video frame from a producer thread to the UI
+ *
+ * Three frames are kept: one that the producer fills, the latest complete
+ * frame, and the one being displayed. Submitting a frame replaces the
+ * latest one, so frames that arrive faster than they are drawn are dropped
+ * rather than queued, and neither side ever waits for the other (the lock
+ * only protects swapping indices). Buffers are recycled, so no allocations
+ * take place once the frame size is stable.
+ */
+class NANOGUI_EXPORT VideoFrameBuffer : public Object {
+public:
+    VideoFrameBuffer();
+
+    /**
+     * \brief Return the frame to be filled next (producer thread only)
+     *
+     * The frame stays owned by the producer until \ref submit() is called.
+     */
+    VideoFrame &acquire(VideoFrame::Format format, const Vector2i &size, double timestamp = 0);
+
+    /// Publish the acquired frame, dropping the previous one if it was not displayed yet
+    void submit();
+
+    /**
+     * \brief Copy a frame into the buffer and publish it
+     *
+     * \c planes and \c strides (in bytes) describe each plane of the frame;
+     * a stride of 0 stands for tightly packed rows.
+     */
+    void push(VideoFrame::Format format, const Vector2i &size, const uint8_t *const *planes,
+              const int *strides = nullptr, double timestamp = 0);
+
+    /**
+     * \brief Return the latest frame if it was submitted since the last call,
+     * and \c nullptr otherwise (consumer thread only)
+     *
+     * The frame stays valid until the next call.
+     */
+    const VideoFrame *consume();
+
+    /// Return the number of frames submitted so far
+    size_t submittedFrames() const { std::lock_guard<std::mutex> guard(mMutex); return mSubmitted; }
+    /// Return the number of frames that were replaced before being consumed
+    size_t droppedFrames() const { std::lock_guard<std::mutex> guard(mMutex); return mDropped; }
+
+protected:
+    virtual ~VideoFrameBuffer() { }
+
+protected:
+    VideoFrame mFrames[3];
+    /// Frame being filled, latest complete frame, frame being displayed
+    int mBack, mReady, mFront;
+    bool mFresh;
+    size_t mSubmitted, mDropped;
+    mutable std::mutex mMutex;
+};
+
+/**
+ * \brief Displays live video frames, scaled to fit and centered
+ *
+ * Frames are submitted from any thread via \ref frames() (which can be kept
+ * by the producer), and only the most recent one is shown. Its planes are
+ * streamed to the GPU through an orphaned pixel buffer object, and YCbCr
+ * frames are converted to RGB by a fragment shader into a texture that is
+ * then drawn by NanoVG. Nothing is uploaded or converted while no new frames
+ * arrive.
+ */
+class NANOGUI_EXPORT VideoView : public Widget {
+public:
+    /// Matrix used to convert YCbCr to RGB
+    enum class ColorSpace {
+        BT601,
+        BT709
+    };
+
+    VideoView(Widget *parent);
+
+    /// Return the buffer through which producers submit frames
+    VideoFrameBuffer *frames() { return mFrames; }
+
+    /// Convenience function, see \ref VideoFrameBuffer::push()
+    void pushFrame(VideoFrame::Format format, const Vector2i &size, const uint8_t *const *planes,
+                   const int *strides = nullptr, double timestamp = 0) {
+        mFrames->push(format, size, planes, strides, timestamp);
+    }
+
+    ColorSpace colorSpace() const { return mColorSpace; }
+    void setColorSpace(ColorSpace colorSpace) { mColorSpace = colorSpace; mConvertDirty = true; }
+
+    /// Return whether YCbCr values use the full 0..255 range (instead of 16..235/240)
+    bool fullRange() const { return mFullRange; }
+    void setFullRange(bool fullRange) { mFullRange = fullRange; mConvertDirty = true; }
+
+    const Color &backgroundColor() const { return mBackgroundColor; }
+    void setBackgroundColor(const Color &backgroundColor) { mBackgroundColor = backgroundColor; }
+
+    /// Return the size of the displayed frame (zero until the first frame arrives)
+    const Vector2i &frameSize() const { return mTextureSize; }
+
+    /// Return the timestamp of the displayed frame
+    double frameTimestamp() const { return mTimestamp; }
+
+    virtual Vector2i preferredSize(NVGcontext *ctx) const override;
+    virtual void draw(NVGcontext *ctx) override;
+
+protected:
+    virtual ~VideoView();
+
+    bool initShader();
+    /// Stream the planes of a frame into the plane textures
+    void uploadFrame(NVGcontext *ctx, const VideoFrame &frame);
+    /// Convert the plane textures into the RGBA texture drawn by NanoVG
+    void convertFrame();
+    /// Return the affine YCbCr to RGB transformation for the current settings
+    Matrix4f conversionMatrix() const;
+
+protected:
+    ref<VideoFrameBuffer> mFrames;
+    ColorSpace mColorSpace;
+    bool mFullRange;
+    Color mBackgroundColor;
+    double mTimestamp;
+
+    bool mGpuFailed;
+    bool mConvertDirty;
+    GLShader *mShader;
+    GLShader::UniformHandle mUniformFormat, mUniformConversion, mUniformPlanes[3];
+    uint32_t mPlaneTextures[3];
+    uint32_t mPixelBuffer;
+    GLRenderTexture *mTarget;
+    VideoFrame::Format mTextureFormat;
+    Vector2i mTextureSize;
+};
+
+NAMESPACE_END(nanogui)
@@ -159,6 +159,9 @@ public:
     // Walk up the hierarchy and return the parent window
     Window *window();
 
+    /// Walk up the hierarchy and return the parent screen (\c nullptr if not attached to one)
+    Screen *screen();
+
     /// Associate this widget with an ID value (optional)
     void setId(const std::string &id) { mId = id; }
     /// Return the ID value associated with this widget, if any
@@ -242,6 +245,26 @@ protected:
     /// Free all resources used by the widget and any children
     virtual ~Widget();
 
+    /// Return the area not clipped by any parent widget (upper left and lower right corner in screen coordinates)
+    Vector4f visibleArea() const;
+
+    /**
+     * \brief Draw an icon of the "icons" font (see entypo.h), interpreting the
+     * position and alignment like \c nvgText()
+     *
+     * With \ref Theme::mSdfText, the glyph is taken from the icon atlas of the
+     * theme and drawn as a textured quad together with all text of the frame.
+     * Otherwise, it is drawn through NanoVG, which changes the current font
+     * face, size, alignment and fill color; that path only avoids the font
+     * lookup by name and the repeated UTF-8 encoding of the icon, so batching
+     * the glyphs requires SDF text. Returns the horizontal advance.
+     */
+    float drawIcon(NVGcontext *ctx, int icon, float x, float y, float size,
+                   int align, const Color &color);
+
+    /// Return the horizontal advance of an icon drawn by \ref drawIcon()
+    float iconWidth(NVGcontext *ctx, int icon, float size);
+
 protected:
     Widget *mParent;
     ref<Theme> mTheme;
@@ -822,6 +822,8 @@ static const char *__doc_nanogui_Graph_load = R"doc()doc";
 
 static const char *__doc_nanogui_Graph_mBackgroundColor = R"doc()doc";
 
+static const char *__doc_nanogui_Graph_markValuesChanged = R"doc(Notify the graph that values() were modified in place)doc";
+
 static const char *__doc_nanogui_Graph_mCaption = R"doc()doc";
 
 static const char *__doc_nanogui_Graph_mFooter = R"doc()doc";
@@ -658,14 +658,15 @@ PYBIND11_PLUGIN(nanogui) {
     py::class_<ImagePanel, ref<ImagePanel>, PyImagePanel>(m, "ImagePanel", widget, D(ImagePanel))
         .def(py::init<Widget *>(), py::arg("parent"), D(ImagePanel, ImagePanel))
         .def("images", &ImagePanel::images, D(ImagePanel, images))
-        .def("setImages", &ImagePanel::setImages, D(ImagePanel, setImages))
+        .def("setImages", (void (ImagePanel::*)(const ImagePanel::Images &)) &ImagePanel::setImages,
+             D(ImagePanel, setImages))
         .def("callback", &ImagePanel::callback, D(ImagePanel, callback))
         .def("setCallback", &ImagePanel::setCallback, D(ImagePanel, setCallback));
 
     py::class_<ImageView, ref<ImageView>, PyImageView> imageview(m, "ImageView", widget, D(ImageView));
     imageview
         .def("image", &ImageView::image, D(ImageView, image))
-        .def("setImage", &ImageView::setImage, D(ImageView, setImage))
+        .def("setImage", (void (ImageView::*)(int)) &ImageView::setImage, D(ImageView, setImage))
         .def("policy", &ImageView::policy, D(ImageView, policy))
         .def("setPolicy", &ImageView::setPolicy, D(ImageView, setPolicy));
 
@@ -795,7 +796,8 @@ PYBIND11_PLUGIN(nanogui) {
         .def("textColor", &Graph::textColor, D(Graph, textColor))
         .def("setTextColor", &Graph::setTextColor, D(Graph, setTextColor))
         .def("values", (VectorXf &(Graph::*)(void)) &Graph::values, D(Graph, values))
-        .def("setValues", &Graph::setValues, D(Graph, setValues));
+        .def("setValues", &Graph::setValues, D(Graph, setValues))
+        .def("markValuesChanged", &Graph::markValuesChanged, D(Graph, markValuesChanged));
 
     py::class_<StackedWidget, ref<StackedWidget>, PyStackedWidget>(m, "StackedWidget", widget, D(StackedWidget))
         .def(py::init<Widget *>())
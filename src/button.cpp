@@ -159,20 +159,16 @@ void Button::draw(NVGcontext *ctx) {
 
     Vector2f center = mPos.cast<float>() + mSize.cast<float>() * 0.5f;
     Vector2f textPos(center.x() - tw * 0.5f, center.y() - 1);
-    NVGcolor textColor =
+    Color textColor =
         mTextColor.w() == 0 ? mTheme->mTextColor : mTextColor;
     if (!mEnabled)
         textColor = mTheme->mDisabledTextColor;
 
     if (mIcon) {
-        auto icon = utf8(mIcon);
-
         float iw, ih = fontSize;
         if (nvgIsFontIcon(mIcon)) {
             ih *= 1.5f;
-            nvgFontSize(ctx, ih);
-            nvgFontFace(ctx, "icons");
-            iw = nvgTextBounds(ctx, 0, 0, icon.data(), nullptr, nullptr);
+            iw = iconWidth(ctx, mIcon, ih);
         } else {
             int w, h;
             ih *= 0.9f;
@@ -181,8 +177,6 @@ void Button::draw(NVGcontext *ctx) {
         }
         if (mCaption != "")
             iw += mSize.y() * 0.15f;
-        nvgFillColor(ctx, textColor);
-        nvgTextAlign(ctx, NVG_ALIGN_LEFT | NVG_ALIGN_MIDDLE);
         Vector2f iconPos = center;
         iconPos.y() -= 1;
 
@@ -199,7 +193,8 @@ void Button::draw(NVGcontext *ctx) {
         }
 
         if (nvgIsFontIcon(mIcon)) {
-            nvgText(ctx, iconPos.x(), iconPos.y()+1, icon.data(), nullptr);
+            drawIcon(ctx, mIcon, iconPos.x(), iconPos.y()+1, ih,
+                     NVG_ALIGN_LEFT | NVG_ALIGN_MIDDLE, textColor);
         } else {
             NVGpaint imgPaint = nvgImagePattern(ctx,
                     iconPos.x(), iconPos.y() - ih/2, iw, ih, 0, mIcon, mEnabled ? 0.5f : 0.25f);
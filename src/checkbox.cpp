@@ -78,14 +78,10 @@ void CheckBox::draw(NVGcontext *ctx) {
     nvgFill(ctx);
 
     if (mChecked) {
-        nvgFontSize(ctx, 1.8 * mSize.y());
-        nvgFontFace(ctx, "icons");
-        nvgFillColor(ctx, mEnabled ? mTheme->mIconColor
-                                   : mTheme->mDisabledTextColor);
-        nvgTextAlign(ctx, NVG_ALIGN_CENTER | NVG_ALIGN_MIDDLE);
-        nvgText(ctx, mPos.x() + mSize.y() * 0.5f + 1,
-                mPos.y() + mSize.y() * 0.5f, utf8(ENTYPO_ICON_CHECK).data(),
-                nullptr);
+        drawIcon(ctx, ENTYPO_ICON_CHECK, mPos.x() + mSize.y() * 0.5f + 1,
+                 mPos.y() + mSize.y() * 0.5f, 1.8f * mSize.y(),
+                 NVG_ALIGN_CENTER | NVG_ALIGN_MIDDLE,
+                 mEnabled ? mTheme->mIconColor : mTheme->mDisabledTextColor);
     }
 }
 
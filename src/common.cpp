@@ -10,6 +10,7 @@
 */
 
 #include <nanogui/screen.h>
+#include <nanogui/texturemanager.h>
 
 #if defined(_WIN32)
 #include <windows.h>
@@ -142,20 +143,35 @@ std::array<char, 8> utf8(int c) {
 }
 
 int __nanogui_get_image(NVGcontext *ctx, const std::string &name, uint8_t *data, uint32_t size) {
-    static std::map<std::string, int> iconCache;
-    auto it = iconCache.find(name);
+    /* Icons of a screen are kept by its texture manager and released
+       together with the context. They are persistent, since the returned
+       handle would become invalid if the image was ever evicted. */
+    for (auto kv : __nanogui_screens) {
+        if (kv.second->nvgContext() != ctx)
+            continue;
+        ref<TextureManager::Image> image = kv.second->textureManager()->loadMemory(name, data, size);
+        image->setPersistent(true);
+        int iconID = image->handle();
+        if (iconID == 0)
+            throw std::runtime_error("Unable to load resource data.");
+        return iconID;
+    }
+
+    /* Image handles are only valid within the context that created them */
+    static std::map<std::pair<NVGcontext *, std::string>, int> iconCache;
+    auto key = std::make_pair(ctx, name);
+    auto it = iconCache.find(key);
     if (it != iconCache.end())
         return it->second;
     int iconID = nvgCreateImageMem(ctx, 0, data, size);
     if (iconID == 0)
         throw std::runtime_error("Unable to load resource data.");
-    iconCache[name] = iconID;
+    iconCache[key] = iconID;
     return iconID;
 }
 
-std::vector<std::pair<int, std::string>>
-loadImageDirectory(NVGcontext *ctx, const std::string &path) {
-    std::vector<std::pair<int, std::string> > result;
+std::vector<std::string> listImageDirectory(const std::string &path) {
+    std::vector<std::string> result;
 #if !defined(_WIN32)
     DIR *dp = opendir(path.c_str());
     if (!dp)
@@ -174,12 +190,7 @@ loadImageDirectory(NVGcontext *ctx, const std::string &path) {
 #endif
         if (strstr(fname, "png") == nullptr)
             continue;
-        std::string fullName = path + "/" + std::string(fname);
-        int img = nvgCreateImage(ctx, fullName.c_str(), 0);
-        if (img == 0)
-            throw std::runtime_error("Could not open image data!");
-        result.push_back(
-            std::make_pair(img, fullName.substr(0, fullName.length() - 4)));
+        result.push_back(path + "/" + std::string(fname));
 #if !defined(_WIN32)
     }
     closedir(dp);
@@ -190,6 +201,19 @@ loadImageDirectory(NVGcontext *ctx, const std::string &path) {
     return result;
 }
 
+std::vector<std::pair<int, std::string>>
+loadImageDirectory(NVGcontext *ctx, const std::string &path) {
+    std::vector<std::pair<int, std::string> > result;
+    for (const std::string &fullName : listImageDirectory(path)) {
+        int img = nvgCreateImage(ctx, fullName.c_str(), 0);
+        if (img == 0)
+            throw std::runtime_error("Could not open image data!");
+        result.push_back(
+            std::make_pair(img, fullName.substr(0, fullName.length() - 4)));
+    }
+    return result;
+}
+
 #if !defined(__APPLE__)
 std::string file_dialog(const std::vector<std::pair<std::string, std::string>> &filetypes, bool save) {
 #define FILE_DIALOG_MAX_BUFFER 1024
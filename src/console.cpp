@@ -15,6 +15,7 @@
 #include <nanogui/console.h>
 #include <nanogui/opengl.h>
 #include <nanogui/theme.h>
+#include <nanogui/threadpool.h>
 #include <nanogui/serializer/core.h>
 #include <regex>
 #include <nanogui_resources.h>
@@ -23,6 +24,139 @@
 
 NAMESPACE_BEGIN(nanogui)
 
+/* Number of history lines processed per lock acquisition in search jobs */
+static const int searchChunkSize = 4096;
+
+static inline uint32_t trigram(const char *s) {
+    return (uint32_t) (uint8_t) std::tolower((uint8_t) s[0]) |
+           ((uint32_t) (uint8_t) std::tolower((uint8_t) s[1]) << 8) |
+           ((uint32_t) (uint8_t) std::tolower((uint8_t) s[2]) << 16);
+}
+
+static bool matchLine(const detail::ConsoleSearch &search, const std::string &line) {
+    if (search.useRegex)
+        return std::regex_search(line, search.regex);
+    if (search.caseSensitive)
+        return line.find(search.pattern) != std::string::npos;
+    return std::search(line.begin(), line.end(),
+                       search.pattern.begin(), search.pattern.end(),
+                       [](char a, char b) {
+                           return std::tolower((uint8_t) a) == std::tolower((uint8_t) b);
+                       }) != line.end();
+}
+
+/* Extend the trigram index to cover the entire history (chunk by chunk, so
+   that the UI thread can keep appending lines in the meantime) */
+static void extendIndex(detail::ConsoleHistory &history, const detail::ConsoleSearch &search) {
+    while (!search.cancelled) {
+        std::lock_guard<std::mutex> guard(history.mutex);
+        size_t end = std::min(history.lines.size(), history.indexedLines + searchChunkSize);
+        if (history.indexedLines == end)
+            return;
+        for (size_t i = history.indexedLines; i < end; ++i) {
+            const std::string &line = history.lines[i];
+            for (size_t j = 0; j + 3 <= line.size(); ++j) {
+                std::vector<int> &posting = history.trigrams[trigram(&line[j])];
+                if (posting.empty() || posting.back() != (int) i)
+                    posting.push_back((int) i);
+            }
+        }
+        history.indexedLines = end;
+    }
+}
+
+/* Hand matches over to the console and wake up the UI thread */
+static void reportMatches(detail::ConsoleSearch &search, std::vector<int> &matches) {
+    if (matches.empty())
+        return;
+    {
+        std::lock_guard<std::mutex> guard(search.mutex);
+        search.pending.insert(search.pending.end(), matches.begin(), matches.end());
+    }
+    matches.clear();
+    ThreadPool::wakeup();
+}
+
+static void runSearch(detail::ConsoleHistory &history, detail::ConsoleSearch &search) {
+    std::vector<int> matches;
+
+    if (!search.useRegex && history.indexed && search.pattern.size() >= 3) {
+        extendIndex(history, search);
+        if (search.cancelled)
+            return;
+
+        /* The posting lists grow while lines are appended, so intersect them
+           under the lock, but verify the candidates without holding it for
+           longer than a chunk. Lines are never removed, so the ids stay valid. */
+        std::vector<int> candidates;
+        {
+            std::lock_guard<std::mutex> guard(history.mutex);
+
+            /* Collect the posting lists of all trigrams in the pattern */
+            std::vector<const std::vector<int> *> postings;
+            for (size_t j = 0; j + 3 <= search.pattern.size(); ++j) {
+                auto it = history.trigrams.find(trigram(&search.pattern[j]));
+                if (it == history.trigrams.end())
+                    return; /* A trigram that occurs nowhere -- no matches */
+                postings.push_back(&it->second);
+            }
+            std::sort(postings.begin(), postings.end(),
+                      [](const std::vector<int> *a, const std::vector<int> *b) {
+                          return a->size() < b->size();
+                      });
+
+            /* Intersect, starting with the shortest list */
+            candidates.assign(
+                std::lower_bound(postings[0]->begin(), postings[0]->end(), search.begin),
+                std::lower_bound(postings[0]->begin(), postings[0]->end(), search.end));
+            std::vector<int> temp;
+            for (size_t k = 1; k < postings.size() && !candidates.empty(); ++k) {
+                temp.clear();
+                std::set_intersection(candidates.begin(), candidates.end(),
+                                      postings[k]->begin(), postings[k]->end(),
+                                      std::back_inserter(temp));
+                candidates.swap(temp);
+            }
+        }
+
+        for (size_t chunk = 0; chunk < candidates.size() && !search.cancelled;
+             chunk += searchChunkSize) {
+            size_t end = std::min(candidates.size(), chunk + searchChunkSize);
+            {
+                std::lock_guard<std::mutex> guard(history.mutex);
+                for (size_t i = chunk; i < end; ++i) {
+                    if (matchLine(search, history.lines[candidates[i]]))
+                        matches.push_back(candidates[i]);
+                }
+            }
+            reportMatches(search, matches);
+        }
+        return;
+    }
+
+    for (int chunk = search.begin; chunk < search.end && !search.cancelled;
+         chunk += searchChunkSize) {
+        int end = std::min(search.end, chunk + searchChunkSize);
+        {
+            std::lock_guard<std::mutex> guard(history.mutex);
+            for (int i = chunk; i < end; ++i) {
+                if (matchLine(search, history.lines[i]))
+                    matches.push_back(i);
+            }
+        }
+        reportMatches(search, matches);
+    }
+}
+
+void ConsoleCommand::print(const std::string &text) {
+    {
+        std::lock_guard<std::mutex> guard(mMutex);
+        mOutput += text;
+        mOutput += '\n';
+    }
+    ThreadPool::wakeup();
+}
+
 Console::Console(Widget *parent):
     Widget(parent),
     mCommitted(true),
@@ -33,8 +167,13 @@ Console::Console(Widget *parent):
       mMousePos(Vector2i(-1,-1)),
       mMouseDownPos(Vector2i(-1,-1)),
       mMouseDragPos(Vector2i(-1,-1)),
-      mMouseDownModifier(0)
+      mMouseDownModifier(0),
+      mSearchDone(false),
+      mFilter(false),
+      mFollow(false)
 {
+    mHistory = std::make_shared<detail::ConsoleHistory>();
+
     //mText = {"The very first entry","Entry 0", "Entry 1", "Entry 2",
     //    "Entry 3","Entry 4","Entry 5","Entry 6",
     //    "Entry 7 On a clear sunny day, the sky above us looks bright blue. "
@@ -42,7 +181,7 @@ Console::Console(Widget *parent):
     //    "Entry 8","Entry 9", "Entry 10", "The very last entry"};
     for(int i=0;i<5;++i){
 
-        mHistory.push_back("text string "+std::to_string(i+1)+" of 100: " 
+        mHistory->lines.push_back("text string "+std::to_string(i+1)+" of 100: " 
         + "On a clear sunny day, the sky above us looks bright blue. " +
             "In the evening, the sunset puts on a brilliant show of reds, pinks and oranges.End.");
     }
@@ -56,6 +195,12 @@ Console::Console(Widget *parent):
     std::cout << "mPos = " << mPos.x() << "," << mPos.y() << std::endl;
 }
 
+Console::~Console() {
+    if (mSearch)
+        mSearch->cancelled = true;
+    cancelCommand();
+}
+
 //void Console::performLayout(NVGcontext *ctx) {
 //    Widget::performLayout(ctx);
 //}
@@ -94,6 +239,9 @@ void Console::draw(NVGcontext* ctx){
     //setSize(Vector2i(mSize.x(), nrows*lineh)); // this code does not work. It
     //changes size each frame. Move from draw into one time function.
     
+    updateSearch();
+    updateCommand();
+
     // init console output 
     if(mInit) {
         initBuffer(ctx, linew);
@@ -102,15 +250,29 @@ void Console::draw(NVGcontext* ctx){
     //typedef std::deque<std::string> Buffer_t;
 
     //temp solution: when buffer is not full. Move this to updateFunction.
-    for(auto it = mBuffer.begin();it!=mBuffer.end();++it) {
+    for(size_t row = 0; row < mBuffer.size(); ++row) {
+        auto it = mBuffer.begin() + row;
+        bool match = !mFilter && mBufferLine[row] >= 0 &&
+            std::binary_search(mSearchMatches.begin(), mSearchMatches.end(),
+                               mBufferLine[row]);
 
         nvgBeginPath(ctx);
-        nvgFillColor(ctx, nvgRGBA(255,255,255,16));
+        nvgFillColor(ctx, match ? nvgRGBA(255,192,0,48) : nvgRGBA(255,255,255,16));
         nvgRect(ctx, x, y, linew, lineh);
         nvgFill(ctx);
 
         nvgFillColor(ctx, nvgRGBA(255,255,255,255));
         nvgText(ctx, x, y, it->c_str(), nullptr);
+
+        if (mBufferLine[row] < 0 && mPendingCommand) {
+            // pending indicator on the command line
+            static const char *spinner[] = { "|", "/", "-", "\\" };
+            int frame = (int) (glfwGetTime() * 8) % 4;
+            nvgFillColor(ctx, nvgRGBA(255, 192, 0, 255));
+            nvgTextAlign(ctx, NVG_ALIGN_RIGHT|NVG_ALIGN_TOP);
+            nvgText(ctx, x + linew - 4, y, spinner[frame], nullptr);
+            nvgTextAlign(ctx, NVG_ALIGN_LEFT|NVG_ALIGN_TOP);
+        }
         
         y += lineh;
     }
@@ -389,6 +551,9 @@ bool Console::mouseButtonEvent(const Vector2i &p, int button,
 
 void Console::initBuffer(NVGcontext * ctx, float linew) {
 
+    if (mFollow)
+        scrollToBottom(ctx, linew);
+
     int currPart = mTopPart;
     int currRow  = mTopRow;
     int currSubrow = mTopSubrow;
@@ -399,22 +564,31 @@ void Console::initBuffer(NVGcontext * ctx, float linew) {
     
     //std::cout << "mNumRows = " << mNumRows << std::endl; 
     
+    // when filtering, only the lines found by the current search are shown
+    bool filtered = mFilter && mSearch;
+    std::lock_guard<std::mutex> guard(mHistory->mutex);
+    const std::vector<std::string> &lines = mHistory->lines;
+    int viewSize = filtered ? (int) mSearchMatches.size() : (int) lines.size();
+
     int i=0;
-    for(;i<mNumRows && currRow<(int)mHistory.size();) {
+    for(;i<mNumRows && currRow<viewSize;) {
         if(currPart) { // if history part
+            int line = filtered ? mSearchMatches[currRow] : currRow;
             if(currSubrow < 0) {
                 //BufferRow bRow(mHistory[currRow], currRow;
-                mBuffer.emplace_back(mHistory[currRow]);
+                mBuffer.emplace_back(lines[line]);
+                mBufferLine.push_back(line);
                 ++i;
             }
             else {
-                const char *text = mHistory[currRow].c_str();
+                const char *text = lines[line].c_str();
                 int nsplits = nvgTextBreakLines(ctx, text, nullptr, linew, rows, maxrows);
                 
                 while(i<mNumRows && currSubrow < nsplits) {
                     NVGtextRow *subrow = &rows[currSubrow];
                     std::string temp(subrow->start, subrow->end);
                     mBuffer.emplace_back(temp);
+                    mBufferLine.push_back(line);
                     ++i;
                     ++currSubrow;
                 }
@@ -425,11 +599,218 @@ void Console::initBuffer(NVGcontext * ctx, float linew) {
     }
     
     if(i<mNumRows){
-        if (mCommand[0] == "")
-            mBuffer.emplace_back("$");
+        mBuffer.emplace_back("$ " + mCommand[0]);
+        mBufferLine.push_back(-1);
     }
 }
 
+void Console::scrollToBottom(NVGcontext *ctx, float linew) {
+    const int maxrows = 128;
+    NVGtextRow rows[maxrows];
+
+    bool filtered = mFilter && mSearch;
+    std::lock_guard<std::mutex> guard(mHistory->mutex);
+    const std::vector<std::string> &lines = mHistory->lines;
+    int line = filtered ? (int) mSearchMatches.size() : (int) lines.size();
+
+    // walk backwards until the view is full, keeping one row for the command line
+    int available = std::max(0, mNumRows - 1), nrows = 0;
+    while (line > 0 && nrows < available) {
+        --line;
+        const char *text = lines[filtered ? mSearchMatches[line] : line].c_str();
+        nrows += nvgTextBreakLines(ctx, text, nullptr, linew, rows, maxrows);
+    }
+    mTopRow = line;
+    mTopSubrow = std::max(0, nrows - available);
+}
+
+void Console::refreshBuffer() {
+    mBuffer.clear();
+    mBufferLine.clear();
+    mInit = true;
+}
+
+void Console::append(const std::string &text) {
+    {
+        std::lock_guard<std::mutex> guard(mHistory->mutex);
+        size_t start = 0;
+        while (true) {
+            size_t end = text.find('\n', start);
+            mHistory->lines.push_back(text.substr(start, end - start));
+            if (end == std::string::npos)
+                break;
+            start = end + 1;
+        }
+    }
+    refreshBuffer();
+}
+
+int Console::lineCount() const {
+    std::lock_guard<std::mutex> guard(mHistory->mutex);
+    return (int) mHistory->lines.size();
+}
+
+bool Console::search(const std::string &pattern, bool regex, bool caseSensitive) {
+    std::regex re;
+    if (regex) {
+        try {
+            auto flags = std::regex::ECMAScript | std::regex::optimize;
+            if (!caseSensitive)
+                flags |= std::regex::icase;
+            re = std::regex(pattern, flags);
+        } catch (const std::regex_error &) {
+            return false;
+        }
+    }
+
+    clearSearch();
+    if (pattern.empty())
+        return true;
+
+    mSearch = std::make_shared<detail::ConsoleSearch>();
+    mSearch->pattern = pattern;
+    mSearch->regex = re;
+    mSearch->useRegex = regex;
+    mSearch->caseSensitive = caseSensitive;
+    mSearchDone = false;
+    launchSearch(0, lineCount());
+    return true;
+}
+
+void Console::clearSearch() {
+    if (mSearch) {
+        mSearch->cancelled = true;
+        mSearch = nullptr;
+    }
+    mSearchMatches.clear();
+    refreshBuffer();
+}
+
+void Console::setFilter(bool filter) {
+    if (mFilter != filter) {
+        mFilter = filter;
+        refreshBuffer();
+    }
+}
+
+void Console::setIndexed(bool indexed) {
+    std::lock_guard<std::mutex> guard(mHistory->mutex);
+    mHistory->indexed = indexed;
+    if (!indexed) {
+        mHistory->trigrams.clear();
+        mHistory->indexedLines = 0;
+    }
+}
+
+void Console::launchSearch(int begin, int end) {
+    /* Each job gets its own state, so that a cancelled job which is still
+       running cannot interfere with its successor */
+    auto prev = mSearch;
+    auto job = std::make_shared<detail::ConsoleSearch>();
+    job->pattern = prev->pattern;
+    job->regex = prev->regex;
+    job->useRegex = prev->useRegex;
+    job->caseSensitive = prev->caseSensitive;
+    job->begin = begin;
+    job->end = end;
+    mSearch = job;
+
+    auto history = mHistory;
+    ThreadPool::global().enqueue([history, job] {
+        runSearch(*history, *job);
+        job->finished = true;
+        ThreadPool::wakeup();
+    });
+}
+
+void Console::execute(const std::string &command) {
+    append("$ " + command);
+    mCommandHistory.push_back(command);
+    mFollow = true;
+
+    if (!mInterpreter) {
+        append("No interpreter attached to this console.");
+        return;
+    }
+    if (mPendingCommand) {
+        append("Another command is still running.");
+        return;
+    }
+
+    auto cmd = std::make_shared<ConsoleCommand>(command);
+    ref<ConsoleInterpreter> interpreter = mInterpreter;
+    mPendingCommand = cmd;
+
+    ThreadPool::global().enqueue([cmd, interpreter]() mutable {
+        try {
+            interpreter->execute(*cmd);
+        } catch (const std::exception &e) {
+            cmd->print(std::string("Error: ") + e.what());
+        }
+        cmd->mFinished = true;
+        ThreadPool::wakeup();
+    });
+}
+
+void Console::cancelCommand() {
+    if (mPendingCommand)
+        mPendingCommand->mCancelled = true;
+}
+
+void Console::updateCommand() {
+    if (!mPendingCommand)
+        return;
+
+    bool finished = mPendingCommand->mFinished;
+    std::string output;
+    {
+        std::lock_guard<std::mutex> guard(mPendingCommand->mMutex);
+        output.swap(mPendingCommand->mOutput);
+    }
+
+    if (!output.empty()) {
+        output.pop_back(); // trailing newline
+        append(output);
+    }
+
+    if (finished) {
+        if (mPendingCommand->mCancelled)
+            append("Cancelled.");
+        mPendingCommand = nullptr;
+        refreshBuffer();
+    }
+}
+
+void Console::updateSearch() {
+    if (!mSearch)
+        return;
+
+    /* Read the flag first: everything published before it was set is
+       guaranteed to be in the pending list below */
+    bool finished = mSearch->finished;
+    std::vector<int> matches;
+    {
+        std::lock_guard<std::mutex> guard(mSearch->mutex);
+        matches.swap(mSearch->pending);
+    }
+
+    if (!matches.empty()) {
+        mSearchMatches.insert(mSearchMatches.end(), matches.begin(), matches.end());
+        if (mFilter)
+            refreshBuffer();
+    }
+
+    if (finished && lineCount() > mSearch->end) {
+        /* Lines were appended in the meantime -- search them as well */
+        launchSearch(mSearch->end, lineCount());
+        finished = false;
+    }
+
+    if (mSearchCallback && (!matches.empty() || (finished && !mSearchDone)))
+        mSearchCallback((int) mSearchMatches.size(), finished);
+    mSearchDone = finished;
+}
+
 bool Console::scrollEvent(const Vector2i &/* p */, const Vector2f &rel) {
     float scrollAmount = rel.y() * (mSize.y() / 20.0f);
     scrollAmount = rel.y()*5;
@@ -441,6 +822,17 @@ bool Console::scrollEvent(const Vector2i &/* p */, const Vector2f &rel) {
     //std::cout << "Scroll amount = " << scrollAmount << std::endl;
     mScroll = scrollAmount;
 
+    int viewSize = (mFilter && mSearch) ? (int) mSearchMatches.size() : lineCount();
+    bool atBottom = !mBufferLine.empty() && mBufferLine.back() < 0;
+    if (rel.y() < 0 && atBottom) {
+        mFollow = true;
+    } else {
+        mFollow = false;
+        mTopRow = std::max(0, std::min(viewSize - 1, mTopRow - (int) std::round(scrollAmount)));
+        mTopSubrow = 0;
+    }
+    refreshBuffer();
+
     return true;
 }
 
@@ -505,9 +897,19 @@ bool Console::keyboardEvent(int key, int /* scancode */, int action, int modifie
 //                    if (mCursorPos < (int) mValueTemp.length())
 //                        mValueTemp.erase(mValueTemp.begin() + mCursorPos);
 //                }
+            } else if (key == GLFW_KEY_BACKSPACE) {
+                if (!mCommand[0].empty()) {
+                    mCommand[0].pop_back();
+                    refreshBuffer();
+                }
+            } else if (key == GLFW_KEY_ESCAPE) {
+                cancelCommand();
             } else if (key == GLFW_KEY_ENTER) {
-                if (!mCommitted)
-                    focusEvent(false);
+                if (!mPendingCommand && !mCommand[0].empty()) {
+                    std::string command = mCommand[0];
+                    mCommand[0].clear();
+                    execute(command);
+                }
 //            } else if (key == GLFW_KEY_A && modifiers == SYSTEM_COMMAND_MOD) {
 //                mCursorPos = (int) mValueTemp.length();
 //                mSelectionPos = 0;
@@ -534,6 +936,10 @@ bool Console::keyboardCharacterEvent(unsigned int codepoint) {
         std::ostringstream convert;
         convert << (char) codepoint;
 
+        mCommand[0] += convert.str();
+        mFollow = true;
+        refreshBuffer();
+
 //        deleteSelection();
 //        mValueTemp.insert(mCursorPos, convert.str());
 //        mCursorPos++;
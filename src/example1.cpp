@@ -228,6 +228,7 @@ public:
         for (int i = 0; i < 100; ++i)
             func[i] = 0.5f * (0.5f * std::sin(i / 10.f) +
                               0.5f * std::cos(i / 23.f) + 1);
+        graph->markValuesChanged();
 
         // Dummy tab used to represent the last tab button.
         tabWidget->createTab("+");
@@ -251,6 +252,7 @@ public:
                     funcDyn[i] = 0.5f *
                         std::abs((0.5f * std::sin(i / 10.f + counter) +
                                   0.5f * std::cos(i / 23.f + 1 + counter)));
+                graphDyn->markValuesChanged();
                 ++counter;
                 // We must invoke perform layout from the screen instance to keep everything in order.
                 // This is essential when creating tabs dynamically.
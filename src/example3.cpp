@@ -39,6 +39,8 @@
 #include <nanogui/glutil.h>
 #include <iostream>
 #include <string>
+#include <thread>
+#include <chrono>
 
 using std::cout;
 using std::cerr;
@@ -46,6 +48,26 @@ using std::endl;
 using std::string;
 using std::to_string;
 
+/// Example interpreter: echoes its input, "count N" prints N lines slowly
+class ExampleInterpreter : public nanogui::ConsoleInterpreter {
+public:
+    virtual void execute(nanogui::ConsoleCommand &command) override {
+        std::istringstream iss(command.command());
+        std::string name;
+        iss >> name;
+        if (name == "count") {
+            int n = 10;
+            iss >> n;
+            for (int i = 0; i < n && !command.cancelled(); ++i) {
+                command.print("count " + std::to_string(i + 1) + "/" + std::to_string(n));
+                std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            }
+        } else {
+            command.print(command.command());
+        }
+    }
+};
+
 class ExampleApplication : public nanogui::Screen {
 public:
     ExampleApplication() : nanogui::Screen(Eigen::Vector2i(1024, 768), "NanoGUI Test") {
@@ -63,6 +85,28 @@ public:
         window->setLayout(new GroupLayout());
         Console *console = new Console(window);
         console->setFixedSize({300, 550});
+        for (int i = 0; i < 100000; ++i)
+            console->append("log line " + std::to_string(i) + ": status " +
+                            (i % 97 == 0 ? "error" : "ok"));
+
+        Widget *tools = new Widget(window);
+        tools->setLayout(new BoxLayout(Orientation::Horizontal,
+                                       Alignment::Middle, 0, 6));
+        TextBox *searchBox = new TextBox(tools, "");
+        searchBox->setEditable(true);
+        searchBox->setFixedWidth(180);
+        searchBox->setAlignment(TextBox::Alignment::Left);
+        searchBox->setCallback([console](const std::string &pattern) {
+            return console->search(pattern);
+        });
+        CheckBox *filterBox = new CheckBox(tools, "Filter");
+        filterBox->setCallback([console](bool filter) { console->setFilter(filter); });
+        console->setIndexed(true);
+        console->setInterpreter(new ExampleInterpreter());
+        console->setSearchCallback([](int matches, bool finished) {
+            if (finished)
+                cout << "Search finished: " << matches << " matches" << endl;
+        });
  
         //TextArea *textarea = new TextArea(window);
         //textarea->setFixedSize({300, 150});
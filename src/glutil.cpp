@@ -12,35 +12,51 @@
 #include <nanogui/glutil.h>
 #include <iostream>
 #include <fstream>
+#include <cstdio>
+#include <cstring>
 
-NAMESPACE_BEGIN(nanogui)
+#define NANOVG_GL3
+#include <nanovg_gl.h>
 
-static GLuint createShader_helper(GLint type, const std::string &name,
-                                  const std::string &defines,
-                                  std::string shader_string) {
-    if (shader_string.empty())
-        return (GLuint) 0;
+NAMESPACE_BEGIN(nanogui)
 
-    if (!defines.empty()) {
-        if (shader_string.length() > 8 && shader_string.substr(0, 8) == "#version") {
-            std::istringstream iss(shader_string);
-            std::ostringstream oss;
-            std::string line;
-            std::getline(iss, line);
+/// Insert the preprocessor definitions after the #version line of a shader
+static std::string addDefines_helper(const std::string &defines, std::string shader_string) {
+    if (shader_string.empty() || defines.empty())
+        return shader_string;
+
+    if (shader_string.length() > 8 && shader_string.substr(0, 8) == "#version") {
+        std::istringstream iss(shader_string);
+        std::ostringstream oss;
+        std::string line;
+        std::getline(iss, line);
+        oss << line << std::endl;
+        oss << defines;
+        while (std::getline(iss, line))
             oss << line << std::endl;
-            oss << defines;
-            while (std::getline(iss, line))
-                oss << line << std::endl;
-            shader_string = oss.str();
-        } else {
-            shader_string = defines + shader_string;
-        }
+        return oss.str();
+    } else {
+        return defines + shader_string;
     }
+}
+
+/// Submit a shader to the compiler without waiting for the result
+static GLuint compileShader_helper(GLint type, const std::string &shader_string) {
+    if (shader_string.empty())
+        return (GLuint) 0;
 
     GLuint id = glCreateShader(type);
     const char *shader_string_const = shader_string.c_str();
     glShaderSource(id, 1, &shader_string_const, nullptr);
     glCompileShader(id);
+    return id;
+}
+
+/// Wait until a shader is compiled, reporting errors
+static void checkShader_helper(GLuint id, GLint type, const std::string &name,
+                               const std::string &shader_string) {
+    if (!id)
+        return;
 
     GLint status;
     glGetShaderiv(id, GL_COMPILE_STATUS, &status);
@@ -60,8 +76,181 @@ static GLuint createShader_helper(GLint type, const std::string &name,
         std::cerr << "Error: " << std::endl << buffer << std::endl;
         throw std::runtime_error("Shader compilation failed!");
     }
+}
 
-    return id;
+NAMESPACE_BEGIN(detail)
+
+#if defined(_WIN32)
+#  define NANOGUI_GLAPIENTRY __stdcall
+#else
+#  define NANOGUI_GLAPIENTRY
+#endif
+
+#if !defined(GL_PROGRAM_BINARY_RETRIEVABLE_HINT)
+#  define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#  define GL_PROGRAM_BINARY_LENGTH 0x8741
+#  define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+
+/**
+ * Entry points of OpenGL 4.1 / ARB_get_program_binary. They are resolved
+ * at run time, since the GL headers (and glad) only cover OpenGL 3.3.
+ */
+struct ProgramBinaryApi {
+    typedef void (NANOGUI_GLAPIENTRY *GetProgramBinary)(GLuint, GLsizei, GLsizei *, GLenum *, void *);
+    typedef void (NANOGUI_GLAPIENTRY *ProgramBinary)(GLuint, GLenum, const void *, GLsizei);
+    typedef void (NANOGUI_GLAPIENTRY *ProgramParameteri)(GLuint, GLenum, GLint);
+
+    GetProgramBinary getProgramBinary = nullptr;
+    ProgramBinary programBinary = nullptr;
+    ProgramParameteri programParameteri = nullptr;
+
+    /// Return the entry points, or \c nullptr if the driver cannot store programs
+    static const ProgramBinaryApi *get() {
+        static ProgramBinaryApi api;
+        static bool initialized = false;
+        if (!initialized) {
+            initialized = true;
+            GLint formats = 0;
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+            while (glGetError() != GL_NO_ERROR)
+                ;
+            if (formats > 0) {
+                api.getProgramBinary = (GetProgramBinary) glfwGetProcAddress("glGetProgramBinary");
+                api.programBinary = (ProgramBinary) glfwGetProcAddress("glProgramBinary");
+                api.programParameteri = (ProgramParameteri) glfwGetProcAddress("glProgramParameteri");
+            }
+        }
+        return api.getProgramBinary && api.programBinary ? &api : nullptr;
+    }
+};
+
+#if !defined(GL_COMPLETION_STATUS_KHR)
+#  define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+/// Return whether the driver supports KHR/ARB_parallel_shader_compile, enabling it on first use
+static bool parallelCompileSupported() {
+    typedef void (NANOGUI_GLAPIENTRY *MaxShaderCompilerThreads)(GLuint);
+    static bool initialized = false, supported = false;
+    if (!initialized) {
+        initialized = true;
+        MaxShaderCompilerThreads maxThreads = nullptr;
+        if (glfwExtensionSupported("GL_KHR_parallel_shader_compile"))
+            maxThreads = (MaxShaderCompilerThreads) glfwGetProcAddress("glMaxShaderCompilerThreadsKHR");
+        else if (glfwExtensionSupported("GL_ARB_parallel_shader_compile"))
+            maxThreads = (MaxShaderCompilerThreads) glfwGetProcAddress("glMaxShaderCompilerThreadsARB");
+        if (maxThreads) {
+            /* Let the driver use as many compiler threads as it likes */
+            maxThreads(0xFFFFFFFFu);
+            supported = true;
+        }
+    }
+    return supported;
+}
+
+/// State of a program between \ref GLShader::initAsync() and the end of its compilation
+struct PendingProgram {
+    std::string sources[3];
+    const ProgramBinaryApi *binaryApi = nullptr;
+    std::string binaryFile;
+};
+
+static std::string &binaryCacheDirectory() {
+    static std::string path;
+    return path;
+}
+
+/// Hash the sources of a program together with the driver that will compile them (64 bit FNV-1a)
+static std::string programBinaryKey(const std::string *sources, int count) {
+    uint64_t hash = 14695981039346656037ull;
+    auto add = [&hash](const char *str) {
+        for (; str && *str; ++str)
+            hash = (hash ^ (uint8_t) *str) * 1099511628211ull;
+        hash = (hash ^ 0xff) * 1099511628211ull; /* Separator */
+    };
+    add((const char *) glGetString(GL_VENDOR));
+    add((const char *) glGetString(GL_RENDERER));
+    add((const char *) glGetString(GL_VERSION));
+    for (int i = 0; i < count; ++i)
+        add(sources[i].c_str());
+
+    char key[17];
+    snprintf(key, sizeof(key), "%016llx", (unsigned long long) hash);
+    return key;
+}
+
+static const char programBinaryMagic[4] = { 'N', 'G', 'P', 'B' };
+
+/// Create a program from a cached binary (returns 0 if it is missing or was rejected by the driver)
+static GLuint loadProgramBinary(const ProgramBinaryApi *api, const std::string &filename) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file)
+        return 0;
+    std::vector<char> data((std::istreambuf_iterator<char>(file)),
+                           std::istreambuf_iterator<char>());
+    size_t header = sizeof(programBinaryMagic) + sizeof(uint32_t);
+    if (data.size() <= header || memcmp(data.data(), programBinaryMagic, sizeof(programBinaryMagic)) != 0)
+        return 0;
+    uint32_t format;
+    memcpy(&format, data.data() + sizeof(programBinaryMagic), sizeof(uint32_t));
+
+    GLuint program = glCreateProgram();
+    api->programBinary(program, (GLenum) format, data.data() + header,
+                       (GLsizei) (data.size() - header));
+
+    /* Drivers reject binaries of other versions, even if the renderer string did not change */
+    GLint status = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if (status != GL_TRUE) {
+        glDeleteProgram(program);
+        while (glGetError() != GL_NO_ERROR)
+            ;
+        return 0;
+    }
+    return program;
+}
+
+static void storeProgramBinary(const ProgramBinaryApi *api, GLuint program,
+                               const std::string &filename) {
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+    std::vector<char> binary((size_t) length);
+    GLenum format = 0;
+    api->getProgramBinary(program, length, &length, &format, binary.data());
+    if (length <= 0)
+        return;
+
+    /* Write to a temporary file first, so that concurrently started
+       applications never read a partial binary */
+    std::string temp = filename + ".tmp";
+    {
+        std::ofstream file(temp, std::ios::binary);
+        uint32_t format32 = (uint32_t) format;
+        file.write(programBinaryMagic, sizeof(programBinaryMagic));
+        file.write((const char *) &format32, sizeof(uint32_t));
+        file.write(binary.data(), length);
+        if (!file)
+            return;
+    }
+    std::remove(filename.c_str());
+    std::rename(temp.c_str(), filename.c_str());
+}
+
+NAMESPACE_END(detail)
+
+void GLShader::setBinaryCacheDirectory(const std::string &path) {
+    detail::binaryCacheDirectory() = path;
+}
+
+const std::string &GLShader::binaryCacheDirectory() {
+    return detail::binaryCacheDirectory();
+}
+
+bool GLShader::parallelCompileSupported() {
+    return detail::parallelCompileSupported();
 }
 
 bool GLShader::initFromFiles(
@@ -87,24 +276,70 @@ bool GLShader::init(const std::string &name,
                     const std::string &vertex_str,
                     const std::string &fragment_str,
                     const std::string &geometry_str) {
+    if (!initAsync(name, vertex_str, fragment_str, geometry_str))
+        return false;
+    finishInit();
+    return true;
+}
+
+void GLShader::initShared(const GLShader &other) {
+    if (other.mPending || !other.mProgramShader)
+        throw std::runtime_error("initShared(" + other.mName + "): shader is not initialized!");
+
+    glGenVertexArrays(1, &mVertexArrayObject);
+    mName = other.mName;
+    mProgramShader = other.mProgramShader;
+    mSharedProgram = true;
+    mLoadedFromCache = other.mLoadedFromCache;
+    mPending.reset();
+    mAttribs = other.mAttribs;
+    mUniforms = other.mUniforms;
+    mUniformBlocks = other.mUniformBlocks;
+}
+
+bool GLShader::initAsync(const std::string &name,
+                         const std::string &vertex_str,
+                         const std::string &fragment_str,
+                         const std::string &geometry_str) {
     std::string defines;
     for (auto def : mDefinitions)
         defines += std::string("#define ") + def.first + std::string(" ") + def.second + "\n";
 
+    std::shared_ptr<detail::PendingProgram> pending = std::make_shared<detail::PendingProgram>();
+    pending->sources[0] = addDefines_helper(defines, vertex_str);
+    pending->sources[1] = addDefines_helper(defines, fragment_str);
+    pending->sources[2] = addDefines_helper(defines, geometry_str);
+
     glGenVertexArrays(1, &mVertexArrayObject);
     mName = name;
-    mVertexShader =
-        createShader_helper(GL_VERTEX_SHADER, name, defines, vertex_str);
-    mGeometryShader =
-        createShader_helper(GL_GEOMETRY_SHADER, name, defines, geometry_str);
-    mFragmentShader =
-        createShader_helper(GL_FRAGMENT_SHADER, name, defines, fragment_str);
-
-    if (!mVertexShader || !mFragmentShader)
-        return false;
-    if (!geometry_str.empty() && !mGeometryShader)
+    mLoadedFromCache = false;
+    mSharedProgram = false;
+    mPending.reset();
+
+    if (vertex_str.empty() || fragment_str.empty())
         return false;
 
+    if (!binaryCacheDirectory().empty())
+        pending->binaryApi = detail::ProgramBinaryApi::get();
+    if (pending->binaryApi) {
+        pending->binaryFile = binaryCacheDirectory() + "/" +
+                              detail::programBinaryKey(pending->sources, 3) + ".glbin";
+        mProgramShader = detail::loadProgramBinary(pending->binaryApi, pending->binaryFile);
+        if (mProgramShader) {
+            mLoadedFromCache = true;
+            introspect();
+            return true;
+        }
+    }
+
+    /* Submit everything before asking for any status, which would wait for
+       the compiler. With KHR_parallel_shader_compile, the driver compiles
+       and links on its own threads in the meantime. */
+    detail::parallelCompileSupported();
+    mVertexShader = compileShader_helper(GL_VERTEX_SHADER, pending->sources[0]);
+    mGeometryShader = compileShader_helper(GL_GEOMETRY_SHADER, pending->sources[2]);
+    mFragmentShader = compileShader_helper(GL_FRAGMENT_SHADER, pending->sources[1]);
+
     mProgramShader = glCreateProgram();
 
     glAttachShader(mProgramShader, mVertexShader);
@@ -113,7 +348,49 @@ bool GLShader::init(const std::string &name,
     if (mGeometryShader)
         glAttachShader(mProgramShader, mGeometryShader);
 
+    if (pending->binaryApi && pending->binaryApi->programParameteri)
+        pending->binaryApi->programParameteri(mProgramShader, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
     glLinkProgram(mProgramShader);
+    mPending = pending;
+    return true;
+}
+
+bool GLShader::ready() {
+    if (!mPending)
+        return true;
+    if (detail::parallelCompileSupported()) {
+        GLint done = GL_FALSE;
+        glGetProgramiv(mProgramShader, GL_COMPLETION_STATUS_KHR, &done);
+        if (done != GL_TRUE)
+            return false;
+    }
+    finishInit();
+    return true;
+}
+
+void GLShader::finishInit() {
+    if (!mPending)
+        return;
+    std::shared_ptr<detail::PendingProgram> pending = std::move(mPending);
+
+    /* Don't leave a broken program behind that could be bound later on */
+    auto discard = [this]() {
+        glDeleteProgram(mProgramShader);
+        glDeleteShader(mVertexShader);
+        glDeleteShader(mFragmentShader);
+        glDeleteShader(mGeometryShader);
+        mProgramShader = mVertexShader = mFragmentShader = mGeometryShader = 0;
+    };
+
+    try {
+        checkShader_helper(mVertexShader, GL_VERTEX_SHADER, mName, pending->sources[0]);
+        checkShader_helper(mGeometryShader, GL_GEOMETRY_SHADER, mName, pending->sources[2]);
+        checkShader_helper(mFragmentShader, GL_FRAGMENT_SHADER, mName, pending->sources[1]);
+    } catch (...) {
+        discard();
+        throw;
+    }
 
     GLint status;
     glGetProgramiv(mProgramShader, GL_LINK_STATUS, &status);
@@ -122,42 +399,140 @@ bool GLShader::init(const std::string &name,
         char buffer[512];
         glGetProgramInfoLog(mProgramShader, 512, nullptr, buffer);
         std::cerr << "Linker error (" << mName << "): " << std::endl << buffer << std::endl;
-        mProgramShader = 0;
+        discard();
         throw std::runtime_error("Shader linking failed!");
     }
 
-    return true;
+    if (pending->binaryApi)
+        detail::storeProgramBinary(pending->binaryApi, mProgramShader, pending->binaryFile);
+
+    introspect();
+}
+
+void GLShader::introspect() {
+    mAttribs.clear();
+    mUniforms.clear();
+    mUniformBlocks.clear();
+
+    GLint count = 0, maxLength = 0;
+    std::vector<char> buffer;
+    auto nameBuffer = [&](GLenum lengthParameter) {
+        glGetProgramiv(mProgramShader, lengthParameter, &maxLength);
+        buffer.resize((size_t) std::max(maxLength, 1) + 1);
+    };
+
+    nameBuffer(GL_ACTIVE_ATTRIBUTE_MAX_LENGTH);
+    glGetProgramiv(mProgramShader, GL_ACTIVE_ATTRIBUTES, &count);
+    for (GLint i = 0; i < count; ++i) {
+        GLint size;
+        GLenum type;
+        glGetActiveAttrib(mProgramShader, (GLuint) i, (GLsizei) buffer.size(), nullptr,
+                          &size, &type, buffer.data());
+        mAttribs[buffer.data()] = glGetAttribLocation(mProgramShader, buffer.data());
+    }
+
+    nameBuffer(GL_ACTIVE_UNIFORM_MAX_LENGTH);
+    glGetProgramiv(mProgramShader, GL_ACTIVE_UNIFORMS, &count);
+    for (GLint i = 0; i < count; ++i) {
+        GLint size;
+        GLenum type;
+        glGetActiveUniform(mProgramShader, (GLuint) i, (GLsizei) buffer.size(), nullptr,
+                           &size, &type, buffer.data());
+        std::string name(buffer.data());
+        GLint id = glGetUniformLocation(mProgramShader, name.c_str());
+        if (id == -1)
+            continue; /* Member of a uniform block */
+        mUniforms[name] = id;
+        /* Arrays are reported as "name[0]", but are usually set via "name" */
+        if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0)
+            mUniforms[name.substr(0, name.size() - 3)] = id;
+    }
+
+    nameBuffer(GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH);
+    glGetProgramiv(mProgramShader, GL_ACTIVE_UNIFORM_BLOCKS, &count);
+    for (GLint i = 0; i < count; ++i) {
+        GLint binding = 0;
+        glGetActiveUniformBlockName(mProgramShader, (GLuint) i, (GLsizei) buffer.size(),
+                                    nullptr, buffer.data());
+        glGetActiveUniformBlockiv(mProgramShader, (GLuint) i, GL_UNIFORM_BLOCK_BINDING, &binding);
+        mUniformBlocks[buffer.data()] = std::make_pair((GLuint) i, (int) binding);
+    }
 }
 
 void GLShader::bind() {
+    if (mPending)
+        finishInit();
     glUseProgram(mProgramShader);
     glBindVertexArray(mVertexArrayObject);
 }
 
 GLint GLShader::attrib(const std::string &name, bool warn) const {
-    GLint id = glGetAttribLocation(mProgramShader, name.c_str());
+    auto it = mAttribs.find(name);
+    if (it == mAttribs.end())
+        it = mAttribs.emplace(name, glGetAttribLocation(mProgramShader, name.c_str())).first;
+    GLint id = it->second;
     if (id == -1 && warn)
         std::cerr << mName << ": warning: did not find attrib " << name << std::endl;
     return id;
 }
 
 void GLShader::setUniform(const std::string &name, const GLUniformBuffer &buf, bool warn) {
-    GLuint blockIndex = glGetUniformBlockIndex(mProgramShader, name.c_str());
+    auto it = mUniformBlocks.find(name);
+    if (it == mUniformBlocks.end()) {
+        GLuint blockIndex = glGetUniformBlockIndex(mProgramShader, name.c_str());
+        it = mUniformBlocks.emplace(name, std::make_pair(blockIndex, -1)).first;
+    }
+    GLuint blockIndex = it->second.first;
     if (blockIndex == GL_INVALID_INDEX) {
         if (warn)
             std::cerr << mName << ": warning: did not find uniform buffer " << name << std::endl;
         return;
     }
-    glUniformBlockBinding(mProgramShader, blockIndex, buf.getBindingPoint());
+    /* The binding is program state, so it only needs to be set when it
+       changes (unless other shaders may have changed it as well) */
+    if (mSharedProgram || it->second.second != buf.getBindingPoint()) {
+        glUniformBlockBinding(mProgramShader, blockIndex, buf.getBindingPoint());
+        it->second.second = buf.getBindingPoint();
+    }
 }
 
 GLint GLShader::uniform(const std::string &name, bool warn) const {
-    GLint id = glGetUniformLocation(mProgramShader, name.c_str());
+    auto it = mUniforms.find(name);
+    if (it == mUniforms.end())
+        it = mUniforms.emplace(name, glGetUniformLocation(mProgramShader, name.c_str())).first;
+    GLint id = it->second;
     if (id == -1 && warn)
         std::cerr << mName << ": warning: did not find uniform " << name << std::endl;
     return id;
 }
 
+GLShader::Buffer &GLShader::attribBuffer(const std::string &name, uint32_t size, int dim,
+                                         uint32_t compSize, GLuint glType) {
+    auto it = mBufferObjects.find(name);
+    if (it == mBufferObjects.end()) {
+        Buffer buffer;
+        glGenBuffers(1, &buffer.id);
+        buffer.version = -1;
+        it = mBufferObjects.emplace(name, buffer).first;
+    }
+    Buffer &buffer = it->second;
+    buffer.glType = glType;
+    buffer.dim = dim;
+    buffer.compSize = compSize;
+    buffer.size = size;
+    return buffer;
+}
+
+void GLShader::bindAttribBuffer(GLint attribID, const Buffer &buffer, bool integral) {
+    if (buffer.size == 0) {
+        glDisableVertexAttribArray(attribID);
+    } else {
+        glEnableVertexAttribArray(attribID);
+        glVertexAttribPointer(attribID, buffer.dim, buffer.glType, integral, 0,
+                              (const void *) buffer.offset);
+    }
+}
+
 void GLShader::uploadAttrib(const std::string &name, uint32_t size, int dim,
                             uint32_t compSize, GLuint glType, bool integral,
                             const uint8_t *data, int version) {
@@ -168,40 +543,137 @@ void GLShader::uploadAttrib(const std::string &name, uint32_t size, int dim,
             return;
     }
 
-    GLuint bufferID;
+    Buffer &buffer = attribBuffer(name, size, dim, compSize, glType);
+    buffer.version = version;
+    buffer.streaming = false;
+    buffer.offset = 0;
+    size_t totalSize = (size_t) size * (size_t) compSize;
+    GLenum target = name == "indices" ? GL_ELEMENT_ARRAY_BUFFER : GL_ARRAY_BUFFER;
+
+    /* Keep the storage if the data fits. Growing by at least half avoids
+       a reallocation on every upload of data that grows steadily. */
+    glBindBuffer(target, buffer.id);
+    if (totalSize > buffer.capacity) {
+        size_t capacity = buffer.capacity == 0
+            ? totalSize : std::max(totalSize, buffer.capacity + buffer.capacity / 2);
+        glBufferData(target, capacity, nullptr, GL_DYNAMIC_DRAW);
+        buffer.capacity = capacity;
+    }
+    if (totalSize > 0)
+        glBufferSubData(target, 0, totalSize, data);
+
+    if (target == GL_ARRAY_BUFFER)
+        bindAttribBuffer(attribID, buffer, integral);
+}
+
+void GLShader::uploadAttribRange(const std::string &name, uint32_t offset, uint32_t size,
+                                 int dim, uint32_t compSize, GLuint glType, bool integral,
+                                 const uint8_t *data) {
     auto it = mBufferObjects.find(name);
-    if (it != mBufferObjects.end()) {
-        Buffer &buffer = it->second;
-        bufferID = it->second.id;
-        buffer.version = version;
-        buffer.size = size;
-        buffer.compSize = compSize;
-    } else {
-        glGenBuffers(1, &bufferID);
-        Buffer buffer;
-        buffer.id = bufferID;
-        buffer.glType = glType;
-        buffer.dim = dim;
-        buffer.compSize = compSize;
-        buffer.size = size;
-        buffer.version = version;
-        mBufferObjects[name] = buffer;
+    if (it == mBufferObjects.end()) {
+        if (offset != 0)
+            throw std::runtime_error("uploadAttribRange(" + mName + ", " + name + ") : buffer not found!");
+        uploadAttrib(name, size, dim, compSize, glType, integral, data);
+        return;
+    }
+    Buffer &buffer = it->second;
+    if (buffer.dim != (GLuint) dim || buffer.glType != glType || buffer.compSize != compSize)
+        throw std::runtime_error("uploadAttribRange(" + mName + ", " + name + ") : layout mismatch!");
+    if (buffer.streaming)
+        throw std::runtime_error("uploadAttribRange(" + mName + ", " + name + ") : buffer is streamed!");
+
+    int attribID = 0;
+    if (name != "indices") {
+        attribID = attrib(name);
+        if (attribID < 0)
+            return;
     }
+
+    GLenum target = name == "indices" ? GL_ELEMENT_ARRAY_BUFFER : GL_ARRAY_BUFFER;
+    size_t begin = (size_t) offset * compSize, end = begin + (size_t) size * compSize;
+
+    if (end > buffer.capacity) {
+        /* Reallocate the storage of the same buffer object, so that shaders
+           sharing it through shareAttrib() keep working. The contents that
+           are still needed are copied out to a temporary buffer and back */
+        size_t capacity = std::max(end, buffer.capacity + buffer.capacity / 2);
+        size_t used = std::min((size_t) buffer.size * compSize, begin);
+        GLuint tempID = 0;
+        if (used > 0) {
+            glGenBuffers(1, &tempID);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, tempID);
+            glBufferData(GL_COPY_WRITE_BUFFER, used, nullptr, GL_STREAM_COPY);
+            glBindBuffer(GL_COPY_READ_BUFFER, buffer.id);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, used);
+        }
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer.id);
+        glBufferData(GL_COPY_WRITE_BUFFER, capacity, nullptr, GL_DYNAMIC_DRAW);
+        if (used > 0) {
+            glBindBuffer(GL_COPY_READ_BUFFER, tempID);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, used);
+            glBindBuffer(GL_COPY_READ_BUFFER, 0);
+            glDeleteBuffers(1, &tempID);
+        }
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        buffer.capacity = capacity;
+    }
+
+    glBindBuffer(target, buffer.id);
+    if (end > begin)
+        glBufferSubData(target, begin, end - begin, data);
+    buffer.size = std::max(buffer.size, offset + size);
+    buffer.version = -1;
+
+    if (target == GL_ARRAY_BUFFER)
+        bindAttribBuffer(attribID, buffer, integral);
+}
+
+void GLShader::streamAttrib(const std::string &name, uint32_t size, int dim,
+                            uint32_t compSize, GLuint glType, bool integral,
+                            const uint8_t *data) {
+    int attribID = 0;
+    if (name != "indices") {
+        attribID = attrib(name);
+        if (attribID < 0)
+            return;
+    }
+
+    Buffer &buffer = attribBuffer(name, size, dim, compSize, glType);
+    buffer.version = -1;
     size_t totalSize = (size_t) size * (size_t) compSize;
+    /* Uploads start at multiples of 256 bytes, which satisfies the alignment of any attribute */
+    size_t slotSize = (totalSize + 255) & ~(size_t) 255;
+    GLenum target = name == "indices" ? GL_ELEMENT_ARRAY_BUFFER : GL_ARRAY_BUFFER;
+    glBindBuffer(target, buffer.id);
+
+    if (!buffer.streaming || slotSize * 2 > buffer.capacity) {
+        /* Room for several frames in flight */
+        buffer.capacity = std::max(slotSize * 4, (size_t) 65536);
+        glBufferData(target, buffer.capacity, nullptr, GL_STREAM_DRAW);
+        buffer.streaming = true;
+        buffer.head = 0;
+    } else if (buffer.head + slotSize > buffer.capacity) {
+        /* Orphan the full ring: draw calls that are still pending keep the old storage */
+        glBufferData(target, buffer.capacity, nullptr, GL_STREAM_DRAW);
+        buffer.head = 0;
+    }
 
-    if (name == "indices") {
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, bufferID);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, totalSize, data, GL_DYNAMIC_DRAW);
-    } else {
-        glBindBuffer(GL_ARRAY_BUFFER, bufferID);
-        glBufferData(GL_ARRAY_BUFFER, totalSize, data, GL_DYNAMIC_DRAW);
-        if (size == 0) {
-            glDisableVertexAttribArray(attribID);
+    buffer.offset = buffer.head;
+    buffer.head += slotSize;
+    if (totalSize > 0) {
+        /* Nothing pending reads this range, so the mapping needs no synchronization */
+        void *mapped = glMapBufferRange(target, buffer.offset, totalSize,
+            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+        if (mapped) {
+            memcpy(mapped, data, totalSize);
+            glUnmapBuffer(target);
         } else {
-            glEnableVertexAttribArray(attribID);
-            glVertexAttribPointer(attribID, dim, glType, integral, 0, 0);
+            glBufferSubData(target, buffer.offset, totalSize, data);
         }
     }
+
+    if (target == GL_ARRAY_BUFFER)
+        bindAttribBuffer(attribID, buffer, integral);
 }
 
 void GLShader::downloadAttrib(const std::string &name, uint32_t size, int /* dim */,
@@ -218,10 +690,10 @@ void GLShader::downloadAttrib(const std::string &name, uint32_t size, int /* dim
 
     if (name == "indices") {
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buf.id);
-        glGetBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, totalSize, data);
+        glGetBufferSubData(GL_ELEMENT_ARRAY_BUFFER, buf.offset, totalSize, data);
     } else {
         glBindBuffer(GL_ARRAY_BUFFER, buf.id);
-        glGetBufferSubData(GL_ARRAY_BUFFER, 0, totalSize, data);
+        glGetBufferSubData(GL_ARRAY_BUFFER, buf.offset, totalSize, data);
     }
 }
 
@@ -238,7 +710,8 @@ void GLShader::shareAttrib(const GLShader &otherShader, const std::string &name,
             return;
         glEnableVertexAttribArray(attribID);
         glBindBuffer(GL_ARRAY_BUFFER, buffer.id);
-        glVertexAttribPointer(attribID, buffer.dim, buffer.glType, buffer.compSize == 1 ? GL_TRUE : GL_FALSE, 0, 0);
+        glVertexAttribPointer(attribID, buffer.dim, buffer.glType, buffer.compSize == 1 ? GL_TRUE : GL_FALSE, 0,
+                              (const void *) buffer.offset);
     } else {
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer.id);
     }
@@ -268,6 +741,11 @@ void GLShader::drawIndexed(int type, uint32_t offset_, uint32_t count_) {
         case GL_LINES: offset *= 2; count *= 2; break;
     }
 
+    /* Streamed indices start somewhere inside their ring buffer */
+    auto it = mBufferObjects.find("indices");
+    if (it != mBufferObjects.end())
+        offset += it->second.offset / sizeof(uint32_t);
+
     glDrawElements(type, (GLsizei) count, GL_UNSIGNED_INT,
                    (const void *)(offset * sizeof(uint32_t)));
 }
@@ -286,10 +764,18 @@ void GLShader::free() {
     if (mVertexArrayObject)
         glDeleteVertexArrays(1, &mVertexArrayObject);
 
-    glDeleteProgram(mProgramShader); mProgramShader = 0;
-    glDeleteShader(mVertexShader);   mVertexShader = 0;
-    glDeleteShader(mFragmentShader); mFragmentShader = 0;
-    glDeleteShader(mGeometryShader); mGeometryShader = 0;
+    if (!mSharedProgram) {
+        glDeleteProgram(mProgramShader);
+        glDeleteShader(mVertexShader);
+        glDeleteShader(mFragmentShader);
+        glDeleteShader(mGeometryShader);
+    }
+    mProgramShader = mVertexShader = mFragmentShader = mGeometryShader = 0;
+    mSharedProgram = false;
+    mAttribs.clear();
+    mUniforms.clear();
+    mUniformBlocks.clear();
+    mPending.reset();
 }
 
 //  ----------------------------------------------------
@@ -431,6 +917,56 @@ void GLFramebuffer::downloadTGA(const std::string &filename) {
 
 //  ----------------------------------------------------
 
+bool GLRenderTexture::resize(NVGcontext *ctx, const Vector2i &size, int imageFlags) {
+    if (size == mSize && mImage)
+        return false;
+
+    if (!mTexture)
+        glGenTextures(1, &mTexture);
+    glBindTexture(GL_TEXTURE_2D, mTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, size.x(), size.y(), 0, GL_RGBA,
+                 GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    if (!mFramebuffer)
+        glGenFramebuffers(1, &mFramebuffer);
+
+    if (mImage)
+        nvgDeleteImage(ctx, mImage);
+    mImage = nvglCreateImageFromHandleGL3(ctx, mTexture, size.x(), size.y(),
+                                          imageFlags | NVG_IMAGE_NODELETE);
+    mSize = size;
+    return true;
+}
+
+void GLRenderTexture::bind() {
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &mPrevFramebuffer);
+    glGetIntegerv(GL_VIEWPORT, mPrevViewport);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, mFramebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, mTexture, 0);
+    glViewport(0, 0, mSize.x(), mSize.y());
+}
+
+void GLRenderTexture::release() {
+    glBindFramebuffer(GL_FRAMEBUFFER, (GLuint) mPrevFramebuffer);
+    glViewport(mPrevViewport[0], mPrevViewport[1], mPrevViewport[2], mPrevViewport[3]);
+}
+
+void GLRenderTexture::free(NVGcontext *ctx) {
+    if (mImage && ctx)
+        nvgDeleteImage(ctx, mImage);
+    if (mFramebuffer)
+        glDeleteFramebuffers(1, &mFramebuffer);
+    if (mTexture)
+        glDeleteTextures(1, &mTexture);
+    mFramebuffer = mTexture = 0;
+    mSize = Vector2i::Zero();
+    mImage = 0;
+}
+
+//  ----------------------------------------------------
+
 Eigen::Vector3f project(const Eigen::Vector3f &obj,
                         const Eigen::Matrix4f &model,
                         const Eigen::Matrix4f &proj,
@@ -11,22 +11,280 @@
 
 #include <nanogui/graph.h>
 #include <nanogui/theme.h>
+#include <nanogui/screen.h>
 #include <nanogui/opengl.h>
+#include <nanogui/glutil.h>
 #include <nanogui/serializer/core.h>
+#include <iostream>
 
 NAMESPACE_BEGIN(nanogui)
 
+GraphStream::GraphStream(size_t capacity)
+    : mCapacity(std::max(capacity, (size_t) 1)), mClaimed(0), mWritten(0),
+      mMirror(2 * mCapacity, 0.f), mWindowBegin(0), mWindowSize(0), mRead(0) {
+    size_t ringSize = 1;
+    while (ringSize < 2 * mCapacity)
+        ringSize *= 2;
+    mRing = std::vector<std::atomic<float>>(ringSize);
+    mMask = ringSize - 1;
+}
+
+void GraphStream::pushBatch(const float *samples, size_t count) {
+    uint64_t written = mWritten.load(std::memory_order_relaxed);
+    uint64_t end = written + count;
+
+    /* Only the most recent samples can end up in the ring */
+    if (count > mRing.size()) {
+        samples += count - mRing.size();
+        written = end - mRing.size();
+    }
+
+    /* Announce the slots being overwritten before touching them */
+    mClaimed.store(end, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    for (uint64_t i = written; i < end; ++i)
+        mRing[i & mMask].store(*samples++, std::memory_order_relaxed);
+
+    mWritten.store(end, std::memory_order_release);
+}
+
+bool GraphStream::update() {
+    uint64_t written = mWritten.load(std::memory_order_acquire);
+    if (written == mRead)
+        return false;
+
+    while (true) {
+        uint64_t begin = std::max(mRead, written > mCapacity ? written - mCapacity : 0);
+        for (uint64_t i = begin; i < written; ++i) {
+            float value = mRing[i & mMask].load(std::memory_order_relaxed);
+            size_t pos = (size_t) (i % mCapacity);
+            mMirror[pos] = mMirror[pos + mCapacity] = value;
+        }
+
+        /* Retry if the producer has overwritten any of the copied slots */
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t claimed = mClaimed.load(std::memory_order_relaxed);
+        if (claimed <= begin + mRing.size())
+            break;
+        written = mWritten.load(std::memory_order_acquire);
+    }
+
+    mRead = written;
+    mWindowSize = (size_t) std::min(written, (uint64_t) mCapacity);
+    mWindowBegin = (size_t) ((written - mWindowSize) % mCapacity);
+    return true;
+}
+
 Graph::Graph(Widget *parent, const std::string &caption)
-    : Widget(parent), mCaption(caption) {
+    : Widget(parent), mCaption(caption), mDecimation(Decimation::MinMax),
+      mDecimationDirty(true), mDecimationWidth(-1), mGpuRendering(false),
+      mGpuFailed(false), mGpuDirty(true), mShader(nullptr),
+      mTarget(new GLRenderTexture()), mGpuWritten(0), mGpuFirst(0), mGpuCount(0) {
     mBackgroundColor = Color(20, 128);
     mForegroundColor = Color(255, 192, 0, 128);
     mTextColor = Color(240, 192);
 }
 
+Graph::~Graph() {
+    Screen *screen = this->screen();
+    mTarget->free(screen ? screen->nvgContext() : nullptr);
+    delete mTarget;
+    if (mShader) {
+        mShader->free();
+        delete mShader;
+    }
+}
+
 Vector2i Graph::preferredSize(NVGcontext *) const {
     return Vector2i(180, 45);
 }
 
+void Graph::updateDecimation(const Eigen::Ref<const VectorXf> &values) {
+    if (!mDecimationDirty && mDecimationWidth == mSize.x())
+        return;
+    mDecimationDirty = false;
+    mDecimationWidth = mSize.x();
+    mPoints.clear();
+
+    size_t n = (size_t) values.size();
+    size_t columns = (size_t) std::max(mSize.x(), 2);
+    if (n <= 2 * columns)
+        return;
+    float scale = 1.f / (float) (n - 1);
+
+    if (mDecimation == Decimation::MinMax) {
+        /* Envelope: the extrema of every pixel column, in sample order */
+        mPoints.reserve(2 * columns + 2);
+        mPoints.push_back(Vector2f(0.f, values[0]));
+        for (size_t c = 0; c < columns; ++c) {
+            size_t begin = c * n / columns, end = (c + 1) * n / columns;
+            if (begin == end)
+                continue;
+            auto segment = values.segment(begin, end - begin);
+            VectorXf::Index iMin, iMax;
+            float vMin = segment.minCoeff(&iMin), vMax = segment.maxCoeff(&iMax);
+            if (iMin > iMax) {
+                std::swap(iMin, iMax);
+                std::swap(vMin, vMax);
+            }
+            mPoints.push_back(Vector2f((begin + iMin) * scale, vMin));
+            if (iMax != iMin)
+                mPoints.push_back(Vector2f((begin + iMax) * scale, vMax));
+        }
+        mPoints.push_back(Vector2f(1.f, values[n - 1]));
+    } else {
+        /* Largest-Triangle-Three-Buckets: from every bucket, keep the sample
+           forming the largest triangle with the previously selected sample
+           and the average of the next bucket */
+        size_t threshold = 2 * columns;
+        double bucketSize = (double) (n - 2) / (double) (threshold - 2);
+        mPoints.reserve(threshold);
+        mPoints.push_back(Vector2f(0.f, values[0]));
+
+        size_t selected = 0;
+        for (size_t b = 0; b < threshold - 2; ++b) {
+            size_t begin = (size_t) (b * bucketSize) + 1,
+                   end = std::min((size_t) ((b + 1) * bucketSize) + 1, n - 1);
+            size_t nextBegin = end,
+                   nextEnd = std::min((size_t) ((b + 2) * bucketSize) + 1, n);
+            if (nextBegin >= nextEnd)
+                nextBegin = nextEnd - 1;
+
+            float avgX = 0.5f * (float) (nextBegin + nextEnd - 1);
+            float avgY = values.segment(nextBegin, nextEnd - nextBegin).mean();
+            float ax = (float) selected, ay = values[selected];
+
+            /* Twice the triangle area for every candidate, as one vectorized expression */
+            auto candidates = values.segment(begin, end - begin).array();
+            Eigen::ArrayXf x = Eigen::ArrayXf::LinSpaced(end - begin, (float) begin, (float) (end - 1));
+            Eigen::ArrayXf area = ((ax - avgX) * (candidates - ay) - (ax - x) * (avgY - ay)).abs();
+
+            Eigen::ArrayXf::Index best;
+            area.maxCoeff(&best);
+            selected = begin + (size_t) best;
+            mPoints.push_back(Vector2f(selected * scale, values[selected]));
+        }
+        mPoints.push_back(Vector2f(1.f, values[n - 1]));
+    }
+}
+
+bool Graph::drawGpu(NVGcontext *ctx, const Eigen::Ref<const VectorXf> &values) {
+    Screen *screen = this->screen();
+    if (!mShader) {
+        /* All graphs of a screen draw with the same program */
+        const GLShader *program = screen ? screen->sharedShader(
+            "graph_shader",
+
+            /* Vertex shader: every sample is stored twice, the even copy
+               becomes the baseline of the filled area */
+            "#version 330\n"
+            "uniform int first;\n"
+            "uniform int count;\n"
+            "uniform int area;\n"
+            "in float value;\n"
+            "void main() {\n"
+            "    float x = float(gl_VertexID / 2 - first) / float(max(count - 1, 1));\n"
+            "    float y = (area == 1 && (gl_VertexID & 1) == 0) ? 0.0 : value;\n"
+            "    gl_Position = vec4(2.0 * x - 1.0, 2.0 * y - 1.0, 0.0, 1.0);\n"
+            "}",
+
+            /* Fragment shader */
+            "#version 330\n"
+            "uniform vec4 color;\n"
+            "out vec4 outColor;\n"
+            "void main() {\n"
+            "    outColor = vec4(color.rgb * color.a, color.a);\n"
+            "}"
+        ) : nullptr;
+        if (!program) {
+            mGpuFailed = true;
+            return false;
+        }
+        mShader = new GLShader();
+        mShader->initShared(*program);
+        mUniformFirst = mShader->uniformHandle("first");
+        mUniformCount = mShader->uniformHandle("count");
+        mUniformArea = mShader->uniformHandle("area");
+        mUniformColor = mShader->uniformHandle("color");
+        mGpuDirty = true;
+    }
+
+    if (mStream) {
+        /* The vertex buffer mirrors the window of the stream: sample i is
+           stored at positions i % capacity and i % capacity + capacity, so
+           that the window is always contiguous, and only samples that
+           arrived since the last frame are uploaded */
+        uint64_t capacity = (uint64_t) mStream->capacity();
+        uint64_t end = mStream->windowEnd(), windowBegin = end - (uint64_t) values.size();
+        mShader->bind();
+        if (mGpuDirty) {
+            MatrixXf ring = MatrixXf::Zero(1, 4 * capacity);
+            mShader->uploadAttrib("value", ring);
+            mGpuWritten = 0;
+            mGpuDirty = false;
+        }
+        for (uint64_t i = std::max(mGpuWritten, windowBegin); i < end; ) {
+            uint64_t pos = i % capacity, count = std::min(end - i, capacity - pos);
+            MatrixXf samples = values.segment(i - windowBegin, count).transpose().replicate(2, 1);
+            Eigen::Map<const MatrixXf> value(samples.data(), 1, samples.size());
+            mShader->uploadAttribRange("value", (uint32_t) (2 * pos), value);
+            mShader->uploadAttribRange("value", (uint32_t) (2 * (pos + capacity)), value);
+            i += count;
+        }
+        mGpuWritten = end;
+        mGpuFirst = (int) (windowBegin % capacity);
+        mGpuCount = (int) values.size();
+    } else if (mGpuDirty) {
+        MatrixXf samples = values.transpose().replicate(2, 1);
+        Eigen::Map<const MatrixXf> value(samples.data(), 1, samples.size());
+        mShader->bind();
+        mShader->uploadAttrib("value", value);
+        mGpuFirst = 0;
+        mGpuCount = (int) values.size();
+        mGpuDirty = false;
+    }
+    if (mGpuCount < 2)
+        return true;
+
+    float pixelRatio = screen ? screen->pixelRatio() : 1.f;
+    Vector2i size = (mSize.cast<float>() * pixelRatio).cast<int>();
+    if (size.minCoeff() <= 0)
+        return true;
+
+    mTarget->resize(ctx, size, NVG_IMAGE_FLIPY | NVG_IMAGE_PREMULTIPLIED);
+
+    /* NanoVG only issues its draw calls in nvgEndFrame(), so the texture
+       is complete by the time it is composited below */
+    mTarget->bind();
+    glClearColor(0.f, 0.f, 0.f, 0.f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_SCISSOR_TEST);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+    mShader->bind();
+    mShader->setUniform(mUniformFirst, mGpuFirst);
+    mShader->setUniform(mUniformCount, mGpuCount);
+    mShader->setUniform(mUniformArea, 1);
+    mShader->setUniform(mUniformColor, Vector4f(mForegroundColor));
+    mShader->drawArray(GL_TRIANGLE_STRIP, 2 * mGpuFirst, 2 * mGpuCount);
+    mShader->setUniform(mUniformArea, 0);
+    mShader->setUniform(mUniformColor, Vector4f(Color(100, 255)));
+    mShader->drawArray(GL_LINE_STRIP, 2 * mGpuFirst, 2 * mGpuCount);
+
+    mTarget->release();
+
+    NVGpaint paint = nvgImagePattern(ctx, mPos.x(), mPos.y(), mSize.x(),
+                                     mSize.y(), 0, mTarget->image(), 1.f);
+    nvgBeginPath(ctx);
+    nvgRect(ctx, mPos.x(), mPos.y(), mSize.x(), mSize.y());
+    nvgFillPaint(ctx, paint);
+    nvgFill(ctx);
+    return true;
+}
+
 void Graph::draw(NVGcontext *ctx) {
     Widget::draw(ctx);
 
@@ -35,24 +293,50 @@ void Graph::draw(NVGcontext *ctx) {
     nvgFillColor(ctx, mBackgroundColor);
     nvgFill(ctx);
 
-    if (mValues.size() < 2)
-        return;
+    Eigen::Ref<const VectorXf> values = mStream ? Eigen::Ref<const VectorXf>(mStream->window())
+                                                : Eigen::Ref<const VectorXf>(mValues);
+    size_t n = (size_t) values.size();
+    bool gpu = mGpuRendering && !mGpuFailed;
+    bool decimate = mDecimation != Decimation::None && n > 2 * (size_t) std::max(mSize.x(), 2);
 
-    nvgBeginPath(ctx);
-    nvgMoveTo(ctx, mPos.x(), mPos.y()+mSize.y());
-    for (size_t i = 0; i < (size_t) mValues.size(); i++) {
-        float value = mValues[i];
-        float vx = mPos.x() + i * mSize.x() / (float) (mValues.size() - 1);
-        float vy = mPos.y() + (1-value) * mSize.y();
-        nvgLineTo(ctx, vx, vy);
+    /* The GPU path keeps track of the stream on its own */
+    if (mStream && mStream->update())
+        mDecimationDirty = true;
+
+    if (!gpu || !drawGpu(ctx, values)) {
+        if (n < 2)
+            return;
+
+        nvgBeginPath(ctx);
+        nvgMoveTo(ctx, mPos.x(), mPos.y()+mSize.y());
+        if (decimate) {
+            updateDecimation(values);
+            for (const Vector2f &point : mPoints) {
+                float vx = mPos.x() + point.x() * mSize.x();
+                float vy = mPos.y() + (1-point.y()) * mSize.y();
+                nvgLineTo(ctx, vx, vy);
+            }
+        } else {
+            for (size_t i = 0; i < n; ++i) {
+                float vx = mPos.x() + i * mSize.x() / (float) (n - 1);
+                float vy = mPos.y() + (1-values[i]) * mSize.y();
+                nvgLineTo(ctx, vx, vy);
+            }
+        }
+
+        nvgLineTo(ctx, mPos.x() + mSize.x(), mPos.y() + mSize.y());
+        nvgStrokeColor(ctx, Color(100, 255));
+        nvgStroke(ctx);
+        nvgFillColor(ctx, mForegroundColor);
+        nvgFill(ctx);
+    } else if (mGpuCount < 2) {
+        return;
     }
 
-    nvgLineTo(ctx, mPos.x() + mSize.x(), mPos.y() + mSize.y());
-    nvgStrokeColor(ctx, Color(100, 255));
-    nvgStroke(ctx);
-    nvgFillColor(ctx, mForegroundColor);
-    nvgFill(ctx);
+    drawLabels(ctx);
+}
 
+void Graph::drawLabels(NVGcontext *ctx) {
     nvgFontFace(ctx, "sans");
 
     if (!mCaption.empty()) {
@@ -102,6 +386,7 @@ bool Graph::load(Serializer &s) {
     if (!s.get("foregroundColor", mForegroundColor)) return false;
     if (!s.get("textColor", mTextColor)) return false;
     if (!s.get("values", mValues)) return false;
+    mDecimationDirty = mGpuDirty = true;
     return true;
 }
 
@@ -0,0 +1,261 @@
+/*
+    src/heatmap.cpp -- Widget that displays a matrix of floating point
+    values through a colormap
+
+    NanoGUI was developed by Wenzel Jakob <wenzel.jakob@epfl.ch>.
+    The widget drawing code is based on the NanoVG demo application
+    by Mikko Mononen.
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+
+#include <nanogui/heatmap.h>
+#include <nanogui/screen.h>
+#include <nanogui/opengl.h>
+#include <nanogui/glutil.h>
+#include <limits>
+
+NAMESPACE_BEGIN(nanogui)
+
+Heatmap::Heatmap(Widget *parent)
+    : Widget(parent), mDataSize(Vector2i::Zero()), mRange(0.f, 1.f), mAutoRange(true),
+      mInterpolation(false), mColormapDirty(true), mDirty(true), mShaderFailed(false), mShader(nullptr),
+      mDataTexture(0), mColormapTexture(0), mTarget(new GLRenderTexture()) {
+    setColormap(Colormap::Viridis);
+}
+
+Heatmap::~Heatmap() {
+    Screen *screen = this->screen();
+    mTarget->free(screen ? screen->nvgContext() : nullptr);
+    delete mTarget;
+    if (mShader) {
+        mShader->free();
+        delete mShader;
+    }
+    uint32_t textures[2] = { mDataTexture, mColormapTexture };
+    for (uint32_t texture : textures)
+        if (texture)
+            glDeleteTextures(1, &texture);
+}
+
+void Heatmap::setColormap(Colormap colormap) {
+    switch (colormap) {
+        case Colormap::Viridis:
+            setColormap({ Color(68, 1, 84, 255), Color(59, 82, 139, 255), Color(33, 145, 140, 255),
+                          Color(94, 201, 98, 255), Color(253, 231, 37, 255) });
+            break;
+        case Colormap::Inferno:
+            setColormap({ Color(0, 0, 4, 255), Color(87, 16, 110, 255), Color(188, 55, 84, 255),
+                          Color(249, 142, 9, 255), Color(252, 255, 164, 255) });
+            break;
+        case Colormap::Grayscale:
+            setColormap({ Color(0, 255), Color(255, 255) });
+            break;
+        case Colormap::Coolwarm:
+            setColormap({ Color(59, 76, 192, 255), Color(221, 221, 221, 255), Color(180, 4, 38, 255) });
+            break;
+    }
+}
+
+void Heatmap::setColormap(const std::vector<Color> &colors) {
+    if (colors.empty())
+        throw std::runtime_error("Heatmap::setColormap(): at least one color is required!");
+    mColormap = colors;
+    mColormapDirty = mDirty = true;
+}
+
+void Heatmap::updateRange(const float *data, int width, int height, size_t stride, bool extend) {
+    typedef Eigen::Map<const Matrix, 0, Eigen::OuterStride<>> MatrixMap;
+    MatrixMap map(data, height, width, Eigen::OuterStride<>((Eigen::Index) stride));
+    /* NaN cells are skipped */
+    auto valid = (map.array() == map.array());
+    float vMin = valid.select(map.array(), std::numeric_limits<float>::infinity()).minCoeff();
+    float vMax = valid.select(map.array(), -std::numeric_limits<float>::infinity()).maxCoeff();
+    if (vMin > vMax)
+        return;
+    if (extend) {
+        vMin = std::min(vMin, mRange.x());
+        vMax = std::max(vMax, mRange.y());
+    }
+    mRange = Vector2f(vMin, vMax);
+}
+
+void Heatmap::setData(const float *data, int width, int height, size_t stride) {
+    if (stride == 0)
+        stride = (size_t) width;
+
+    if (!mDataTexture)
+        glGenTextures(1, &mDataTexture);
+    glBindTexture(GL_TEXTURE_2D, mDataTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, (GLint) stride);
+    if (Vector2i(width, height) != mDataSize) {
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, width, height, 0, GL_RED, GL_FLOAT, data);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        mDataSize = Vector2i(width, height);
+    } else {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RED, GL_FLOAT, data);
+    }
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+
+    if (mAutoRange && width > 0 && height > 0)
+        updateRange(data, width, height, stride, false);
+    mDirty = true;
+}
+
+void Heatmap::updateRows(const float *data, int firstRow, int rowCount, size_t stride) {
+    if (!mDataTexture || firstRow < 0 || firstRow + rowCount > mDataSize.y())
+        throw std::runtime_error("Heatmap::updateRows(): rows are out of range!");
+    if (stride == 0)
+        stride = (size_t) mDataSize.x();
+    if (rowCount <= 0)
+        return;
+
+    glBindTexture(GL_TEXTURE_2D, mDataTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, (GLint) stride);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, firstRow, mDataSize.x(), rowCount, GL_RED, GL_FLOAT, data);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+
+    if (mAutoRange)
+        updateRange(data, mDataSize.x(), rowCount, stride, true);
+    mDirty = true;
+}
+
+void Heatmap::uploadColormap() {
+    /* Resample the colors into a lookup table that the shader indexes */
+    const int size = 256;
+    std::vector<uint8_t> table(4 * size);
+    for (int i = 0; i < size; ++i) {
+        float t = (float) i / (size - 1) * (mColormap.size() - 1);
+        size_t index = std::min((size_t) t, mColormap.size() - 1);
+        size_t next = std::min(index + 1, mColormap.size() - 1);
+        Vector4f color = mColormap[index] * (1.f - (t - index)) + mColormap[next] * (t - index);
+        for (int c = 0; c < 4; ++c)
+            table[4 * i + c] = (uint8_t) std::round(std::min(std::max(color[c], 0.f), 1.f) * 255.f);
+    }
+
+    if (!mColormapTexture)
+        glGenTextures(1, &mColormapTexture);
+    glBindTexture(GL_TEXTURE_2D, mColormapTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, size, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, table.data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    mColormapDirty = false;
+}
+
+bool Heatmap::initShader() {
+    /* All heatmaps of a screen draw with the same program */
+    Screen *screen = this->screen();
+    const GLShader *program = screen ? screen->sharedShader(
+        "heatmap_shader",
+
+        /* Vertex shader: a quad covering the whole texture, with the
+           first row of the data at the top */
+        "#version 330\n"
+        "in vec2 position;\n"
+        "out vec2 uv;\n"
+        "void main() {\n"
+        "    uv = position;\n"
+        "    gl_Position = vec4(2.0 * position.x - 1.0, 1.0 - 2.0 * position.y, 0.0, 1.0);\n"
+        "}",
+
+        /* Fragment shader: normalize the value and look up its color */
+        "#version 330\n"
+        "uniform sampler2D data;\n"
+        "uniform sampler2D colormap;\n"
+        "uniform vec2 range;\n"
+        "in vec2 uv;\n"
+        "out vec4 outColor;\n"
+        "void main() {\n"
+        "    float value = texture(data, uv).r;\n"
+        "    if (isnan(value))\n"
+        "        discard;\n"
+        "    float t = clamp((value - range.x) / max(range.y - range.x, 1e-30), 0.0, 1.0);\n"
+        "    vec4 color = texture(colormap, vec2(t * (255.0 / 256.0) + 0.5 / 256.0, 0.5));\n"
+        "    outColor = vec4(color.rgb * color.a, color.a);\n"
+        "}"
+    ) : nullptr;
+    if (!program) {
+        mShaderFailed = true;
+        return false;
+    }
+    mShader = new GLShader();
+    mShader->initShared(*program);
+    mUniformData = mShader->uniformHandle("data");
+    mUniformColormap = mShader->uniformHandle("colormap");
+    mUniformRange = mShader->uniformHandle("range");
+
+    MatrixXf positions(2, 4);
+    positions << 0, 1, 0, 1,
+                 0, 0, 1, 1;
+    mShader->bind();
+    mShader->uploadAttrib("position", positions);
+    return true;
+}
+
+Vector2i Heatmap::preferredSize(NVGcontext *) const {
+    return Vector2i(256, 256);
+}
+
+void Heatmap::draw(NVGcontext *ctx) {
+    Widget::draw(ctx);
+    if (!mDataTexture || mDataSize.minCoeff() <= 0)
+        return;
+    if (!mShader && (mShaderFailed || !initShader()))
+        return;
+
+    Screen *screen = this->screen();
+    float pixelRatio = screen ? screen->pixelRatio() : 1.f;
+    Vector2i size = (mSize.cast<float>() * pixelRatio).cast<int>();
+    if (size.minCoeff() <= 0)
+        return;
+
+    if (mTarget->resize(ctx, size, NVG_IMAGE_FLIPY | NVG_IMAGE_PREMULTIPLIED))
+        mDirty = true;
+
+    /* Only render the color-mapped image again if something changed;
+       the texture is composited by NanoVG in either case */
+    if (mDirty) {
+        if (mColormapDirty)
+            uploadColormap();
+
+        mTarget->bind();
+        glClearColor(0.f, 0.f, 0.f, 0.f);
+        glClear(GL_COLOR_BUFFER_BIT);
+        glDisable(GL_DEPTH_TEST);
+        glDisable(GL_SCISSOR_TEST);
+        glDisable(GL_BLEND);
+
+        GLint filter = mInterpolation ? GL_LINEAR : GL_NEAREST;
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, mColormapTexture);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, mDataTexture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+
+        mShader->bind();
+        mShader->setUniform(mUniformData, 0);
+        mShader->setUniform(mUniformColormap, 1);
+        mShader->setUniform(mUniformRange, mRange);
+        mShader->drawArray(GL_TRIANGLE_STRIP, 0, 4);
+
+        mTarget->release();
+        mDirty = false;
+    }
+
+    NVGpaint paint = nvgImagePattern(ctx, mPos.x(), mPos.y(), mSize.x(),
+                                     mSize.y(), 0, mTarget->image(), 1.f);
+    nvgBeginPath(ctx);
+    nvgRect(ctx, mPos.x(), mPos.y(), mSize.x(), mSize.y());
+    nvgFillPaint(ctx, paint);
+    nvgFill(ctx);
+}
+
+NAMESPACE_END(nanogui)
@@ -0,0 +1,212 @@
+/*
+    src/histogram.cpp -- Histogram widget that bins large sample arrays
+    using all worker threads
+
+    NanoGUI was developed by Wenzel Jakob <wenzel.jakob@epfl.ch>.
+    The widget drawing code is based on the NanoVG demo application
+    by Mikko Mononen.
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+
+#include <nanogui/histogram.h>
+#include <nanogui/threadpool.h>
+#include <nanogui/opengl.h>
+#include <limits>
+#include <memory>
+
+NAMESPACE_BEGIN(nanogui)
+
+/* Number of samples that a thread processes at once */
+static const size_t HistogramChunkSize = 1 << 20;
+
+/**
+ * Process [0, count) in chunks on the calling thread and on the workers of
+ * the global pool. Every participating thread accumulates its chunks into a
+ * private copy of \c init using \c body, and hands it to \c merge once no
+ * chunks are left. Returns after all chunks have been merged.
+ *
+ * The caller takes part as well, so this never waits for a busy pool; jobs
+ * that only start afterwards find no chunks and return immediately.
+ */
+template <typename Partial, typename Body, typename Merge>
+static void parallelReduce(size_t count, const Partial &init, const Body &body, const Merge &merge) {
+    struct State {
+        std::atomic<size_t> next { 0 };
+        size_t chunks = 0, merged = 0;
+        std::mutex mutex;
+        std::condition_variable cond;
+    };
+
+    auto state = std::make_shared<State>();
+    state->chunks = (count + HistogramChunkSize - 1) / HistogramChunkSize;
+    if (state->chunks == 0)
+        return;
+
+    auto participant = [state, count, init, body, merge]() {
+        Partial partial(init);
+        size_t processed = 0;
+        for (size_t chunk; (chunk = state->next++) < state->chunks; ++processed) {
+            size_t begin = chunk * HistogramChunkSize;
+            body(partial, begin, std::min(begin + HistogramChunkSize, count));
+        }
+        if (processed == 0)
+            return;
+        std::lock_guard<std::mutex> guard(state->mutex);
+        merge(partial);
+        state->merged += processed;
+        if (state->merged == state->chunks)
+            state->cond.notify_all();
+    };
+
+    ThreadPool &pool = ThreadPool::global();
+    size_t helpers = std::min(pool.size(), state->chunks - 1);
+    for (size_t i = 0; i < helpers; ++i)
+        pool.enqueue(participant);
+    participant();
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->cond.wait(lock, [&state] { return state->merged == state->chunks; });
+}
+
+/**
+ * Binning kernel: bin indices are computed for a block of samples in a
+ * branch-free loop that the compiler vectorizes, and then scattered into
+ * four interleaved sub-histograms so that runs of equal bins do not
+ * serialize on the same counter. Each sub-histogram has an extra slot
+ * at index \c bins that collects NaN values.
+ */
+static void binSamples(const float *data, size_t count, float offset, float scale,
+                       int bins, uint32_t *counts) {
+    const size_t BlockSize = 256;
+    const size_t stride = (size_t) bins + 1;
+    const float lastBin = (float) (bins - 1);
+    int32_t index[BlockSize];
+
+    for (size_t start = 0; start < count; start += BlockSize) {
+        size_t n = std::min(BlockSize, count - start);
+        const float *x = data + start;
+
+        for (size_t i = 0; i < n; ++i) {
+            float t = (x[i] - offset) * scale;
+            t = t > 0.f ? t : 0.f; /* also maps NaN to zero */
+            t = t < lastBin ? t : lastBin;
+            index[i] = x[i] == x[i] ? (int32_t) t : bins;
+        }
+
+        for (size_t i = 0; i < n; ++i)
+            counts[(i & 3) * stride + index[i]]++;
+    }
+}
+
+Histogram::Histogram(Widget *parent, const std::string &caption, int binCount)
+    : Graph(parent, caption), mCounts((size_t) std::max(binCount, 1), 0), mTotal(0),
+      mRange(0.f, 1.f), mAutoRange(true) {
+    updateValues();
+}
+
+void Histogram::setBinCount(int binCount) {
+    mCounts.assign((size_t) std::max(binCount, 1), 0);
+    clear();
+}
+
+void Histogram::setRange(const Vector2f &range) {
+    mRange = range;
+    mAutoRange = false;
+    clear();
+}
+
+void Histogram::clear() {
+    std::fill(mCounts.begin(), mCounts.end(), 0);
+    mTotal = 0;
+    updateValues();
+}
+
+void Histogram::append(const float *data, size_t count) {
+    if (count == 0)
+        return;
+
+    if (mAutoRange && mTotal == 0) {
+        /* Parallel min/max pass over the first batch (NaN values are skipped) */
+        const float inf = std::numeric_limits<float>::infinity();
+        Vector2f range(inf, -inf);
+        parallelReduce(count, Vector2f(inf, -inf),
+            [data, inf](Vector2f &partial, size_t begin, size_t end) {
+                Eigen::Map<const Eigen::ArrayXf> x(data + begin, (Eigen::Index) (end - begin));
+                auto valid = x == x;
+                partial.x() = std::min(partial.x(), valid.select(x, inf).minCoeff());
+                partial.y() = std::max(partial.y(), valid.select(x, -inf).maxCoeff());
+            },
+            [&range](const Vector2f &partial) {
+                range.x() = std::min(range.x(), partial.x());
+                range.y() = std::max(range.y(), partial.y());
+            });
+        if (range.x() > range.y())
+            range = Vector2f(0.f, 1.f);
+        else if (range.x() == range.y())
+            range += Vector2f(-0.5f, 0.5f);
+        mRange = range;
+    }
+
+    int bins = (int) mCounts.size();
+    float offset = mRange.x();
+    float scale = mRange.y() > mRange.x() ? bins / (mRange.y() - mRange.x()) : 0.f;
+    std::vector<uint64_t> &counts = mCounts;
+    uint64_t nans = 0;
+
+    parallelReduce(count, std::vector<uint32_t>(4 * ((size_t) bins + 1), 0),
+        [data, offset, scale, bins](std::vector<uint32_t> &partial, size_t begin, size_t end) {
+            binSamples(data + begin, end - begin, offset, scale, bins, partial.data());
+        },
+        [&counts, &nans, bins](const std::vector<uint32_t> &partial) {
+            size_t stride = (size_t) bins + 1;
+            for (size_t i = 0; i < (size_t) bins; ++i)
+                counts[i] += (uint64_t) partial[i] + partial[stride + i] +
+                             partial[2 * stride + i] + partial[3 * stride + i];
+            for (size_t k = 0; k < 4; ++k)
+                nans += partial[k * stride + bins];
+        });
+
+    mTotal += count - nans;
+    updateValues();
+}
+
+void Histogram::updateValues() {
+    uint64_t maxCount = *std::max_element(mCounts.begin(), mCounts.end());
+    VectorXf &values = this->values();
+    values.resize((Eigen::Index) mCounts.size());
+    for (size_t i = 0; i < mCounts.size(); ++i)
+        values[(Eigen::Index) i] = maxCount > 0 ? (float) mCounts[i] / (float) maxCount : 0.f;
+}
+
+void Histogram::draw(NVGcontext *ctx) {
+    Widget::draw(ctx);
+
+    nvgBeginPath(ctx);
+    nvgRect(ctx, mPos.x(), mPos.y(), mSize.x(), mSize.y());
+    nvgFillColor(ctx, mBackgroundColor);
+    nvgFill(ctx);
+
+    Eigen::Index bins = mValues.size();
+    if (bins > 0) {
+        float barWidth = (float) mSize.x() / bins;
+        float gap = barWidth > 4.f ? 1.f : 0.f;
+        nvgBeginPath(ctx);
+        for (Eigen::Index i = 0; i < bins; ++i) {
+            float height = mValues[i] * mSize.y();
+            if (height <= 0.f)
+                continue;
+            nvgRect(ctx, mPos.x() + i * barWidth, mPos.y() + mSize.y() - height,
+                    barWidth - gap, height);
+        }
+        nvgFillColor(ctx, mForegroundColor);
+        nvgFill(ctx);
+        nvgStrokeColor(ctx, Color(100, 255));
+        nvgStroke(ctx);
+    }
+
+    drawLabels(ctx);
+}
+
+NAMESPACE_END(nanogui)
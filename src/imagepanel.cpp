@@ -11,14 +11,231 @@
 */
 
 #include <nanogui/imagepanel.h>
+#include <nanogui/screen.h>
+#include <nanogui/threadpool.h>
 #include <nanogui/opengl.h>
+#include <stb_image.h>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <cmath>
+#include <iostream>
+
+#define NANOVG_GL3
+#include <nanovg_gl.h>
 
 NAMESPACE_BEGIN(nanogui)
 
+NAMESPACE_BEGIN(detail)
+
+/// State shared between an \ref ImagePanel and the jobs loading its thumbnails
+struct ThumbnailQueue {
+    struct Thumbnail {
+        size_t index;
+        /// Width and height (0 if the image could not be loaded)
+        int size;
+        std::vector<uint8_t> pixels;
+    };
+
+    std::atomic<bool> cancelled { false };
+    std::mutex mutex;
+    bool scanned = false;
+    std::vector<std::string> files;
+    std::deque<Thumbnail> ready;
+    /// Number of images that have not been uploaded yet (UI thread only)
+    size_t remaining = 0;
+};
+
+NAMESPACE_END(detail)
+
+/// Reduce the centered square of an RGBA image to at most size x size pixels (box filter)
+static void makeThumbnail(const uint8_t *pixels, int width, int height, int size,
+                          detail::ThumbnailQueue::Thumbnail &thumb) {
+    int side = std::min(width, height);
+    int x0 = (width - side) / 2, y0 = (height - side) / 2;
+    size = std::min(size, side);
+    thumb.size = size;
+    thumb.pixels.resize((size_t) size * size * 4);
+
+    for (int y = 0; y < size; ++y) {
+        int sy0 = y0 + (int) ((int64_t) y * side / size);
+        int sy1 = std::max(y0 + (int) ((int64_t) (y + 1) * side / size), sy0 + 1);
+        for (int x = 0; x < size; ++x) {
+            int sx0 = x0 + (int) ((int64_t) x * side / size);
+            int sx1 = std::max(x0 + (int) ((int64_t) (x + 1) * side / size), sx0 + 1);
+            uint32_t sum[4] = { 0, 0, 0, 0 };
+            for (int sy = sy0; sy < sy1; ++sy) {
+                const uint8_t *row = pixels + ((size_t) sy * width + sx0) * 4;
+                for (int sx = sx0; sx < sx1; ++sx, row += 4)
+                    for (int c = 0; c < 4; ++c)
+                        sum[c] += row[c];
+            }
+            uint32_t count = (uint32_t) ((sy1 - sy0) * (sx1 - sx0));
+            uint8_t *out = thumb.pixels.data() + ((size_t) y * size + x) * 4;
+            for (int c = 0; c < 4; ++c)
+                out[c] = (uint8_t) ((sum[c] + count / 2) / count);
+        }
+    }
+}
+
 ImagePanel::ImagePanel(Widget *parent)
-    : Widget(parent), mThumbSize(64), mSpacing(10), mMargin(10),
+    : Widget(parent), mUploadBudget(0.002), mThumbSize(64), mSpacing(10), mMargin(10),
       mMouseIndex(-1) {}
 
+ImagePanel::~ImagePanel() {
+    if (mQueue)
+        mQueue->cancelled = true;
+    /* Release the NanoVG handles of thumbnails created by loadDirectory() */
+    Screen *screen = this->screen();
+    if (screen) {
+        NVGcontext *ctx = screen->nvgContext();
+        for (int image : mReleasedImages)
+            nvgDeleteImage(ctx, image);
+        if (!mTextures.empty())
+            for (const auto &image : mImages)
+                if (image.first)
+                    nvgDeleteImage(ctx, image.first);
+    }
+    if (!mTextures.empty())
+        glDeleteTextures((GLsizei) mTextures.size(), mTextures.data());
+}
+
+void ImagePanel::setImages(const Images &data) {
+    cancelLoading();
+    mImages = data;
+    mManagedImages.clear();
+    mImageSizes.clear();
+}
+
+void ImagePanel::setImages(const ManagedImages &images) {
+    cancelLoading();
+    mManagedImages = images;
+    mImages.clear();
+    for (const auto &image : images)
+        mImages.push_back(std::make_pair(0, image.second));
+    mImageSizes.clear();
+}
+
+void ImagePanel::cancelLoading() {
+    if (mQueue) {
+        mQueue->cancelled = true;
+        mQueue.reset();
+    }
+    /* Thumbnails created by loadDirectory() belong to this widget; their
+       NanoVG handles are released once a context is available again */
+    if (!mTextures.empty()) {
+        for (const auto &image : mImages)
+            if (image.first)
+                mReleasedImages.push_back(image.first);
+        glDeleteTextures((GLsizei) mTextures.size(), mTextures.data());
+        mTextures.clear();
+    }
+}
+
+void ImagePanel::loadDirectory(const std::string &path) {
+    cancelLoading();
+    mImages.clear();
+    mManagedImages.clear();
+    mImageSizes.clear();
+
+    Screen *screen = this->screen();
+    int size = (int) std::ceil(mThumbSize * (screen ? screen->pixelRatio() : 1.f));
+    std::shared_ptr<detail::ThumbnailQueue> queue = std::make_shared<detail::ThumbnailQueue>();
+    mQueue = queue;
+
+    ThreadPool::global().enqueue([queue, path, size] {
+        std::vector<std::string> files;
+        try {
+            files = listImageDirectory(path);
+        } catch (const std::exception &e) {
+            std::cerr << "ImagePanel: " << e.what() << std::endl;
+        }
+
+        {
+            std::lock_guard<std::mutex> guard(queue->mutex);
+            queue->files = files;
+            queue->scanned = true;
+        }
+        ThreadPool::wakeup();
+
+        /* One job per image, so that the whole pool decodes in parallel */
+        for (size_t i = 0; i < files.size(); ++i) {
+            std::string file = files[i];
+            ThreadPool::global().enqueue([queue, file, i, size] {
+                if (queue->cancelled)
+                    return;
+                detail::ThumbnailQueue::Thumbnail thumb;
+                thumb.index = i;
+                thumb.size = 0;
+                int width, height, channels;
+                uint8_t *pixels = stbi_load(file.c_str(), &width, &height, &channels, 4);
+                if (pixels) {
+                    makeThumbnail(pixels, width, height, size, thumb);
+                    stbi_image_free(pixels);
+                }
+                std::lock_guard<std::mutex> guard(queue->mutex);
+                queue->ready.push_back(std::move(thumb));
+                ThreadPool::wakeup();
+            });
+        }
+    });
+}
+
+void ImagePanel::uploadThumbnails(NVGcontext *ctx) {
+    for (int image : mReleasedImages)
+        nvgDeleteImage(ctx, image);
+    mReleasedImages.clear();
+    if (!mQueue)
+        return;
+
+    double start = glfwGetTime();
+    std::unique_lock<std::mutex> lock(mQueue->mutex);
+
+    if (mQueue->scanned && !mQueue->files.empty()) {
+        for (const std::string &file : mQueue->files) {
+            size_t dot = file.find_last_of('.');
+            mImages.push_back(std::make_pair(0, file.substr(0, dot)));
+        }
+        mQueue->remaining = mQueue->files.size();
+        mQueue->files.clear();
+        mImageSizes.resize(mImages.size(), Vector2i::Zero());
+    }
+
+    while (!mQueue->ready.empty() && glfwGetTime() - start < mUploadBudget) {
+        detail::ThumbnailQueue::Thumbnail thumb = std::move(mQueue->ready.front());
+        mQueue->ready.pop_front();
+        mQueue->remaining--;
+        if (thumb.size == 0)
+            continue;
+        lock.unlock();
+
+        GLuint texture;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, thumb.size, thumb.size, 0, GL_RGBA,
+                     GL_UNSIGNED_BYTE, thumb.pixels.data());
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        mTextures.push_back(texture);
+        mImages[thumb.index].first = nvglCreateImageFromHandleGL3(
+            ctx, texture, thumb.size, thumb.size, NVG_IMAGE_NODELETE);
+        mImageSizes[thumb.index] = Vector2i::Constant(thumb.size);
+
+        lock.lock();
+    }
+
+    if (mQueue->scanned && mQueue->remaining == 0) {
+        lock.unlock();
+        mQueue.reset();
+    } else if (!mQueue->ready.empty()) {
+        /* Continue in the next frame */
+        ThreadPool::wakeup();
+    }
+}
+
 Vector2i ImagePanel::gridSize() const {
     int nCols = 1 + std::max(0,
         (int) ((mSize.x() - 2 * mMargin - mThumbSize) /
@@ -61,36 +278,77 @@ Vector2i ImagePanel::preferredSize(NVGcontext *) const {
     );
 }
 
+Vector2i ImagePanel::visibleRows(NVGcontext *ctx, int rowCount) const {
+    Vector4f visible = visibleArea();
+    float clipTop = visible.y(), clipBottom = visible.w();
+
+    /* The current transform includes the offset of scroll panels, which
+       absolutePosition() does not; only translations are used in the UI */
+    float xform[6];
+    nvgCurrentTransform(ctx, xform);
+    float origin = xform[5] + mPos.y() + mMargin;
+    float pitch = (float) (mThumbSize + mSpacing);
+    const float shadow = 5.f;
+
+    float first = std::floor((clipTop - origin - mThumbSize - shadow) / pitch) + 1;
+    float last = std::floor((clipBottom - origin + shadow) / pitch) + 1;
+    first = std::max(0.f, std::min(first, (float) rowCount));
+    last = std::max(first, std::min(last, (float) rowCount));
+    return Vector2i((int) first, (int) last);
+}
+
 void ImagePanel::draw(NVGcontext* ctx) {
+    uploadThumbnails(ctx);
     Vector2i grid = gridSize();
+    if (mImageSizes.size() != mImages.size())
+        mImageSizes.assign(mImages.size(), Vector2i::Zero());
 
-    for (size_t i=0; i<mImages.size(); ++i) {
+    Vector2i rows = visibleRows(ctx, grid.y());
+    size_t begin = (size_t) rows.x() * grid.x(),
+           end = std::min(mImages.size(), (size_t) rows.y() * grid.x());
+
+    for (size_t i=begin; i<end; ++i) {
         Vector2i p = mPos + Vector2i::Constant(mMargin) +
             Vector2i((int) i % grid.x(), (int) i / grid.x()) * (mThumbSize + mSpacing);
-        int imgw, imgh;
-
-        nvgImageSize(ctx, mImages[i].first, &imgw, &imgh);
-        float iw, ih, ix, iy;
-        if (imgw < imgh) {
-            iw = mThumbSize;
-            ih = iw * (float)imgh / (float)imgw;
-            ix = 0;
-            iy = -(ih - mThumbSize) * 0.5f;
+
+        /* Managed images may have been evicted (and get a new handle when loaded again) */
+        if (!mManagedImages.empty() && mManagedImages[i].first)
+            mImages[i].first = mManagedImages[i].first->handle();
+
+        if (mImages[i].first == 0) {
+            /* Placeholder for a thumbnail that is still loading */
+            nvgBeginPath(ctx);
+            nvgRoundedRect(ctx, p.x(), p.y(), mThumbSize, mThumbSize, 5);
+            nvgFillColor(ctx, Color(255, mMouseIndex == (int) i ? 32 : 16));
+            nvgFill(ctx);
         } else {
-            ih = mThumbSize;
-            iw = ih * (float)imgw / (float)imgh;
-            ix = -(iw - mThumbSize) * 0.5f;
-            iy = 0;
-        }
+            Vector2i &imageSize = mImageSizes[i];
+            if (imageSize.x() == 0)
+                nvgImageSize(ctx, mImages[i].first, &imageSize.x(), &imageSize.y());
+            int imgw = std::max(imageSize.x(), 1), imgh = std::max(imageSize.y(), 1);
 
-        NVGpaint imgPaint = nvgImagePattern(
-            ctx, p.x() + ix, p.y()+ iy, iw, ih, 0, mImages[i].first,
-            mMouseIndex == (int)i ? 1.0 : 0.7);
+            float iw, ih, ix, iy;
+            if (imgw < imgh) {
+                iw = mThumbSize;
+                ih = iw * (float)imgh / (float)imgw;
+                ix = 0;
+                iy = -(ih - mThumbSize) * 0.5f;
+            } else {
+                ih = mThumbSize;
+                iw = ih * (float)imgw / (float)imgh;
+                ix = -(iw - mThumbSize) * 0.5f;
+                iy = 0;
+            }
 
-        nvgBeginPath(ctx);
-        nvgRoundedRect(ctx, p.x(), p.y(), mThumbSize, mThumbSize, 5);
-        nvgFillPaint(ctx, imgPaint);
-        nvgFill(ctx);
+            NVGpaint imgPaint = nvgImagePattern(
+                ctx, p.x() + ix, p.y()+ iy, iw, ih, 0, mImages[i].first,
+                mMouseIndex == (int)i ? 1.0 : 0.7);
+
+            nvgBeginPath(ctx);
+            nvgRoundedRect(ctx, p.x(), p.y(), mThumbSize, mThumbSize, 5);
+            nvgFillPaint(ctx, imgPaint);
+            nvgFill(ctx);
+        }
 
         NVGpaint shadowPaint =
             nvgBoxGradient(ctx, p.x() - 1, p.y(), mThumbSize + 2, mThumbSize + 2, 5, 3,
@@ -101,13 +359,18 @@ void ImagePanel::draw(NVGcontext* ctx) {
         nvgPathWinding(ctx, NVG_HOLE);
         nvgFillPaint(ctx, shadowPaint);
         nvgFill(ctx);
+    }
 
-        nvgBeginPath(ctx);
+    /* The borders of all visible thumbnails share a single path */
+    nvgBeginPath(ctx);
+    for (size_t i=begin; i<end; ++i) {
+        Vector2i p = mPos + Vector2i::Constant(mMargin) +
+            Vector2i((int) i % grid.x(), (int) i / grid.x()) * (mThumbSize + mSpacing);
         nvgRoundedRect(ctx, p.x()+0.5f,p.y()+0.5f, mThumbSize-1,mThumbSize-1, 4-0.5f);
-        nvgStrokeWidth(ctx, 1.0f);
-        nvgStrokeColor(ctx, nvgRGBA(255,255,255,80));
-        nvgStroke(ctx);
     }
+    nvgStrokeWidth(ctx, 1.0f);
+    nvgStrokeColor(ctx, nvgRGBA(255,255,255,80));
+    nvgStroke(ctx);
 }
 
 NAMESPACE_END(nanogui)
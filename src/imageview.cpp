@@ -11,14 +11,236 @@
 */
 
 #include <nanogui/imageview.h>
+#include <nanogui/threadpool.h>
+#include <nanogui/theme.h>
 #include <nanogui/opengl.h>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
 
 NAMESPACE_BEGIN(nanogui)
 
+NAMESPACE_BEGIN(detail)
+
+/// CPU copy of the pixels of an \ref ImageView (immutable once created)
+struct ImagePixels {
+    std::vector<float> data;
+    int width, height, channels;
+
+    const float *row(int y) const { return data.data() + (size_t) y * width * channels; }
+};
+
+/// State shared between an \ref ImageView and the job computing its statistics
+struct InspectionState {
+    /// Incremented whenever the job in progress becomes obsolete
+    std::atomic<int> generation { 0 };
+    std::mutex mutex;
+    ImageView::Statistics result;
+    bool updated = false;
+};
+
+NAMESPACE_END(detail)
+
+/* Rows processed between two intermediate results */
+static const int StatisticsBlockRows = 64;
+
+/**
+ * Accumulate the statistics of one row of interleaved pixels. The per-channel
+ * reductions and the bin indices are computed on whole rows with Eigen (which
+ * vectorizes them); only the histogram increments are scalar.
+ */
+static void accumulateRow(const float *row, int width, int channels, float offset, float scale,
+                          int bins, Eigen::ArrayXf &min, Eigen::ArrayXf &max,
+                          Eigen::ArrayXd &sum, Eigen::ArrayXd &count, uint32_t *histogram) {
+    const float inf = std::numeric_limits<float>::infinity();
+    Eigen::Map<const Eigen::ArrayXXf> px(row, channels, width);
+    auto valid = px == px;
+
+    min = min.min(valid.select(px, inf).rowwise().minCoeff());
+    max = max.max(valid.select(px, -inf).rowwise().maxCoeff());
+    sum += valid.select(px, 0.f).rowwise().sum().cast<double>();
+    count += valid.rowwise().count().cast<double>();
+
+    Eigen::ArrayXXi index = valid.select((px - offset) * scale, 0.f)
+        .max(0.f).min((float) (bins - 1)).cast<int>();
+    for (int x = 0; x < width; ++x)
+        for (int c = 0; c < channels; ++c)
+            if (valid(c, x))
+                histogram[c * bins + index(c, x)]++;
+}
+
+static void computeStatistics(const std::shared_ptr<detail::InspectionState> &state,
+                              const std::shared_ptr<const detail::ImagePixels> &pixels,
+                              const Vector4i &region, const Vector2f &range, int bins,
+                              int generation) {
+    const float inf = std::numeric_limits<float>::infinity();
+    int channels = pixels->channels, width = region.z() - region.x();
+    Eigen::ArrayXf min = Eigen::ArrayXf::Constant(channels, inf),
+                   max = Eigen::ArrayXf::Constant(channels, -inf);
+    Eigen::ArrayXd sum = Eigen::ArrayXd::Zero(channels), count = Eigen::ArrayXd::Zero(channels);
+    std::vector<uint32_t> histogram((size_t) bins * channels, 0);
+    float offset = range.x();
+    float scale = range.y() > range.x() ? bins / (range.y() - range.x()) : 0.f;
+
+    for (int y = region.y(); y < region.w(); ) {
+        int end = std::min(y + StatisticsBlockRows, region.w());
+        for (; y < end; ++y)
+            accumulateRow(pixels->row(y) + (size_t) region.x() * channels, width, channels,
+                          offset, scale, bins, min, max, sum, count, histogram.data());
+
+        ImageView::Statistics result;
+        result.region = region;
+        result.channels = channels;
+        result.count = (uint64_t) (y - region.y()) * width;
+        result.progress = (float) (y - region.y()) / (float) (region.w() - region.y());
+        for (int c = 0; c < channels; ++c) {
+            bool any = count[c] > 0;
+            result.min[c] = any ? min[c] : 0.f;
+            result.max[c] = any ? max[c] : 0.f;
+            result.mean[c] = any ? (float) (sum[c] / count[c]) : 0.f;
+        }
+        result.histogram = histogram;
+
+        {
+            std::lock_guard<std::mutex> guard(state->mutex);
+            if (state->generation != generation)
+                return;
+            state->result = std::move(result);
+            state->updated = true;
+        }
+        ThreadPool::wakeup();
+    }
+}
+
 ImageView::ImageView(Widget *parent, int img, SizePolicy policy)
-    : Widget(parent), mImage(img), mPolicy(policy) {}
+    : Widget(parent), mImage(img), mPolicy(policy), mDrawnSize(Vector2i::Zero()),
+      mInspection(false), mState(std::make_shared<detail::InspectionState>()),
+      mHistogramRange(0.f, 1.f), mHistogramBins(64), mRegion(Vector4i::Zero()),
+      mMousePos(Vector2i::Zero()), mDragStart(Vector2i::Zero()), mMouseInside(false),
+      mSelecting(false) {}
+
+ImageView::~ImageView() {
+    mState->generation++;
+}
+
+static void checkChannels(int channels) {
+    if (channels < 1 || channels > 4)
+        throw std::invalid_argument("ImageView::setPixels(): images must have 1 to 4 channels!");
+}
+
+void ImageView::setPixels(const float *data, int width, int height, int channels, size_t stride) {
+    checkChannels(channels);
+    std::shared_ptr<detail::ImagePixels> pixels = std::make_shared<detail::ImagePixels>();
+    pixels->width = width;
+    pixels->height = height;
+    pixels->channels = channels;
+    size_t rowSize = (size_t) width * channels;
+    if (stride == 0)
+        stride = rowSize;
+    pixels->data.resize(rowSize * height);
+    for (int y = 0; y < height; ++y)
+        std::copy(data + y * stride, data + y * stride + rowSize,
+                  pixels->data.begin() + y * rowSize);
+    mPixels = pixels;
+    mRegion = Vector4i::Zero();
+    mStatistics = Statistics();
+    updateStatistics();
+}
+
+void ImageView::setPixels(const uint8_t *data, int width, int height, int channels, size_t stride) {
+    checkChannels(channels);
+    size_t rowSize = (size_t) width * channels;
+    if (stride == 0)
+        stride = rowSize;
+    std::vector<float> values(rowSize * height);
+    for (int y = 0; y < height; ++y)
+        for (size_t i = 0; i < rowSize; ++i)
+            values[y * rowSize + i] = data[y * stride + i] * (1.f / 255.f);
+    setPixels(values.data(), width, height, channels);
+}
+
+void ImageView::setRegion(const Vector4i &region) {
+    mRegion = region;
+    updateStatistics();
+}
+
+void ImageView::updateStatistics() {
+    /* The previous statistics stay visible until the first results arrive */
+    int generation = ++mState->generation;
+    if (!mPixels)
+        return;
+
+    Vector4i region = mRegion;
+    Vector4i bounds(0, 0, mPixels->width, mPixels->height);
+    region.head<2>() = region.head<2>().cwiseMax(0);
+    region.tail<2>() = region.tail<2>().cwiseMin(bounds.tail<2>());
+    if (region.z() <= region.x() || region.w() <= region.y())
+        region = bounds;
+    if (region.z() <= region.x() || region.w() <= region.y())
+        return;
+
+    std::shared_ptr<detail::InspectionState> state = mState;
+    std::shared_ptr<const detail::ImagePixels> pixels = mPixels;
+    Vector2f range = mHistogramRange;
+    int bins = mHistogramBins;
+    ThreadPool::global().enqueue([state, pixels, region, range, bins, generation] {
+        if (state->generation == generation)
+            computeStatistics(state, pixels, region, range, bins, generation);
+    });
+}
+
+Vector2i ImageView::pixelForPosition(const Vector2i &p) const {
+    if (!mPixels || mDrawnSize.x() <= 0 || mDrawnSize.y() <= 0)
+        return Vector2i::Constant(-1);
+    Vector2f rel = (p - mPos).cast<float>().cwiseQuotient(mDrawnSize.cast<float>());
+    return Vector2i((int) std::floor(rel.x() * mPixels->width),
+                    (int) std::floor(rel.y() * mPixels->height));
+}
+
+bool ImageView::mouseButtonEvent(const Vector2i &p, int button, bool down, int modifiers) {
+    if (!mInspection || !mPixels || button != GLFW_MOUSE_BUTTON_1)
+        return Widget::mouseButtonEvent(p, button, down, modifiers);
+    if (down) {
+        mDragStart = pixelForPosition(p);
+        mSelecting = false;
+    } else if (!mSelecting) {
+        /* A click selects the whole image */
+        setRegion(Vector4i::Zero());
+    }
+    return true;
+}
+
+bool ImageView::mouseDragEvent(const Vector2i &p, const Vector2i &rel, int button, int modifiers) {
+    if (!mInspection || !mPixels)
+        return Widget::mouseDragEvent(p, rel, button, modifiers);
+    mMousePos = p;
+    Vector2i q = pixelForPosition(p);
+    mSelecting = true;
+    setRegion(Vector4i(std::min(mDragStart.x(), q.x()), std::min(mDragStart.y(), q.y()),
+                       std::max(mDragStart.x(), q.x()) + 1, std::max(mDragStart.y(), q.y()) + 1));
+    return true;
+}
+
+bool ImageView::mouseMotionEvent(const Vector2i &p, const Vector2i &rel, int button, int modifiers) {
+    mMousePos = p;
+    return Widget::mouseMotionEvent(p, rel, button, modifiers) || mInspection;
+}
+
+bool ImageView::mouseEnterEvent(const Vector2i &p, bool enter) {
+    mMouseInside = enter;
+    return Widget::mouseEnterEvent(p, enter);
+}
 
 Vector2i ImageView::preferredSize(NVGcontext *ctx) const {
+    if (mManagedImage) {
+        /* The size is known once the image was loaded for the first time */
+        if (mManagedImage->size() == Vector2i::Zero())
+            const_cast<TextureManager::Image *>(mManagedImage.get())->handle();
+        return mManagedImage->size();
+    }
     if (!mImage)
         return Vector2i(0, 0);
     int w,h;
@@ -27,6 +249,8 @@ Vector2i ImageView::preferredSize(NVGcontext *ctx) const {
 }
 
 void ImageView::draw(NVGcontext* ctx) {
+    if (mManagedImage)
+        mImage = mManagedImage->handle();
     if (!mImage)
         return;
     Vector2i p = mPos;
@@ -63,6 +287,108 @@ void ImageView::draw(NVGcontext* ctx) {
     nvgRect(ctx, p.x(), p.y(), w, h);
     nvgFillPaint(ctx, imgPaint);
     nvgFill(ctx);
+
+    mDrawnSize = Vector2i(w, h);
+    if (mInspection && mPixels)
+        drawInspection(ctx);
+}
+
+void ImageView::drawInspection(NVGcontext *ctx) {
+    {
+        std::lock_guard<std::mutex> guard(mState->mutex);
+        if (mState->updated) {
+            mStatistics = mState->result;
+            mState->updated = false;
+        }
+    }
+
+    const char *names[4] = { "R", "G", "B", "A" };
+    const Color colors[4] = { Color(255, 96, 96, 255), Color(96, 255, 96, 255),
+                              Color(96, 160, 255, 255), Color(200, 255) };
+    Vector2f scale = mDrawnSize.cast<float>().cwiseQuotient(
+        Vector2f((float) mPixels->width, (float) mPixels->height));
+    char text[128];
+
+    nvgSave(ctx);
+    nvgIntersectScissor(ctx, mPos.x(), mPos.y(), mSize.x(), mSize.y());
+    nvgFontFace(ctx, "sans");
+    nvgFontSize(ctx, 14.0f);
+
+    /* Selected region */
+    const Statistics &stats = mStatistics;
+    if (stats.channels > 0) {
+        Vector4i r = stats.region;
+        nvgBeginPath(ctx);
+        nvgRect(ctx, mPos.x() + r.x() * scale.x() + 0.5f, mPos.y() + r.y() * scale.y() + 0.5f,
+                (r.z() - r.x()) * scale.x() - 1.f, (r.w() - r.y()) * scale.y() - 1.f);
+        nvgStrokeWidth(ctx, 1.0f);
+        nvgStrokeColor(ctx, Color(255, 200));
+        nvgStroke(ctx);
+
+        /* Statistics and histograms, one line per channel */
+        const float lineHeight = 18.f, histWidth = 64.f, boxWidth = 300.f;
+        float boxHeight = stats.channels * lineHeight + 8.f;
+        float x = mPos.x() + 4.f, y = mPos.y() + 4.f;
+        nvgBeginPath(ctx);
+        nvgRoundedRect(ctx, x, y, boxWidth, boxHeight, 3.f);
+        nvgFillColor(ctx, Color(0, 160));
+        nvgFill(ctx);
+
+        nvgTextAlign(ctx, NVG_ALIGN_LEFT | NVG_ALIGN_MIDDLE);
+        int bins = stats.channels > 0 ? (int) stats.histogram.size() / stats.channels : 0;
+        for (int c = 0; c < stats.channels; ++c) {
+            float ly = y + 4.f + c * lineHeight;
+            snprintf(text, sizeof(text), "%s  min %.4g  max %.4g  mean %.4g",
+                     stats.channels == 1 ? "L" : names[c], stats.min[c], stats.max[c], stats.mean[c]);
+            nvgFillColor(ctx, mTheme->mTextColor);
+            nvgText(ctx, x + 4.f, ly + lineHeight * 0.5f, text, nullptr);
+
+            if (bins == 0)
+                continue;
+            const uint32_t *hist = stats.histogram.data() + (size_t) c * bins;
+            uint32_t peak = *std::max_element(hist, hist + bins);
+            if (peak == 0)
+                continue;
+            float hx = x + boxWidth - histWidth - 4.f, barWidth = histWidth / bins;
+            nvgBeginPath(ctx);
+            for (int b = 0; b < bins; ++b) {
+                float height = (lineHeight - 4.f) * hist[b] / (float) peak;
+                if (height > 0.f)
+                    nvgRect(ctx, hx + b * barWidth, ly + lineHeight - 2.f - height, barWidth, height);
+            }
+            nvgFillColor(ctx, colors[stats.channels == 1 ? 3 : c]);
+            nvgFill(ctx);
+        }
+
+        if (stats.progress < 1.f) {
+            snprintf(text, sizeof(text), "%i%%", (int) (stats.progress * 100));
+            nvgTextAlign(ctx, NVG_ALIGN_RIGHT | NVG_ALIGN_TOP);
+            nvgFillColor(ctx, mTheme->mTextColor);
+            nvgText(ctx, x + boxWidth, y + boxHeight + 2.f, text, nullptr);
+        }
+    }
+
+    /* Value of the pixel under the cursor */
+    Vector2i q = pixelForPosition(mMousePos);
+    if (mMouseInside && q.x() >= 0 && q.y() >= 0 && q.x() < mPixels->width && q.y() < mPixels->height) {
+        const float *value = mPixels->row(q.y()) + (size_t) q.x() * mPixels->channels;
+        int n = snprintf(text, sizeof(text), "(%i, %i) =", q.x(), q.y());
+        for (int c = 0; c < mPixels->channels && n < (int) sizeof(text); ++c)
+            n += snprintf(text + n, sizeof(text) - n, " %.4g", value[c]);
+
+        float bounds[4];
+        nvgTextAlign(ctx, NVG_ALIGN_LEFT | NVG_ALIGN_BOTTOM);
+        nvgTextBounds(ctx, mPos.x() + 6.f, mPos.y() + mDrawnSize.y() - 6.f, text, nullptr, bounds);
+        nvgBeginPath(ctx);
+        nvgRoundedRect(ctx, bounds[0] - 2.f, bounds[1] - 2.f, bounds[2] - bounds[0] + 4.f,
+                       bounds[3] - bounds[1] + 4.f, 3.f);
+        nvgFillColor(ctx, Color(0, 160));
+        nvgFill(ctx);
+        nvgFillColor(ctx, mTheme->mTextColor);
+        nvgText(ctx, mPos.x() + 6.f, mPos.y() + mDrawnSize.y() - 6.f, text, nullptr);
+    }
+
+    nvgRestore(ctx);
 }
 
 NAMESPACE_END(nanogui)
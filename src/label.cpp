@@ -11,6 +11,7 @@
 
 #include <nanogui/label.h>
 #include <nanogui/theme.h>
+#include <nanogui/screen.h>
 #include <nanogui/opengl.h>
 #include <nanogui/serializer/core.h>
 
@@ -56,6 +57,16 @@ Vector2i Label::preferredSize(NVGcontext *ctx) const {
 
 void Label::draw(NVGcontext *ctx) {
     Widget::draw(ctx);
+
+    SdfFont *sdfFont = mTheme->mSdfText ? mTheme->sdfFont(mFont) : nullptr;
+    Screen *screen = sdfFont ? this->screen() : nullptr;
+    if (screen && mFixedSize.x() <= 0) {
+        screen->sdfText()->text(ctx, sdfFont, mPos.x(), mPos.y() + mSize.y() * 0.5f,
+                                fontSize(), NVG_ALIGN_LEFT | NVG_ALIGN_MIDDLE,
+                                mColor, mCaption, visibleArea());
+        return;
+    }
+
     nvgFontFace(ctx, mFont.c_str());
     nvgFontSize(ctx, fontSize());
     nvgFillColor(ctx, mColor);
@@ -0,0 +1,115 @@
+/*
+    src/mappedfile.cpp -- Memory-mapped files for widgets that display
+    data sets larger than the available memory
+
+    NanoGUI was developed by Wenzel Jakob <wenzel.jakob@epfl.ch>.
+    The widget drawing code is based on the NanoVG demo application
+    by Mikko Mononen.
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+
+#include <nanogui/mappedfile.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <stdexcept>
+
+#if defined(_WIN32)
+#  if !defined(NOMINMAX)
+#    define NOMINMAX
+#  endif
+#  include <windows.h>
+#else
+#  include <fcntl.h>
+#  include <unistd.h>
+#  include <sys/mman.h>
+#endif
+
+NAMESPACE_BEGIN(nanogui)
+NAMESPACE_BEGIN(detail)
+
+MappedFile::MappedFile(const std::string &filename, uint64_t createSize)
+    : mData(nullptr), mSize(createSize) {
+    bool write = createSize > 0;
+#if defined(_WIN32)
+    mMapping = nullptr;
+    mFile = CreateFileA(filename.c_str(), GENERIC_READ | (write ? GENERIC_WRITE : 0),
+                        FILE_SHARE_READ, nullptr, write ? CREATE_ALWAYS : OPEN_EXISTING,
+                        FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (mFile == INVALID_HANDLE_VALUE)
+        throw std::runtime_error("Could not open \"" + filename + "\"!");
+    if (!write) {
+        LARGE_INTEGER size;
+        GetFileSizeEx(mFile, &size);
+        mSize = (uint64_t) size.QuadPart;
+    }
+    if (mSize > 0)
+        mMapping = CreateFileMappingA(mFile, nullptr, write ? PAGE_READWRITE : PAGE_READONLY,
+                                      (DWORD) (mSize >> 32), (DWORD) mSize, nullptr);
+    if (mMapping)
+        mData = (uint8_t *) MapViewOfFile(mMapping, write ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0);
+#else
+    mFile = open(filename.c_str(), write ? (O_RDWR | O_CREAT | O_TRUNC) : O_RDONLY, 0644);
+    if (mFile < 0)
+        throw std::runtime_error("Could not open \"" + filename + "\"!");
+    if (write) {
+        if (ftruncate(mFile, (off_t) mSize) != 0)
+            mSize = 0;
+    } else {
+        struct stat sb;
+        mSize = fstat(mFile, &sb) == 0 ? (uint64_t) sb.st_size : 0;
+    }
+    if (mSize > 0) {
+        void *data = mmap(nullptr, (size_t) mSize, PROT_READ | (write ? PROT_WRITE : 0),
+                          MAP_SHARED, mFile, 0);
+        mData = data != MAP_FAILED ? (uint8_t *) data : nullptr;
+    }
+#endif
+    if (!mData) {
+        close();
+        throw std::runtime_error("Could not map \"" + filename + "\"!");
+    }
+}
+
+MappedFile::~MappedFile() { close(); }
+
+void MappedFile::flush() {
+#if defined(_WIN32)
+    FlushViewOfFile(mData, 0);
+#else
+    msync(mData, (size_t) mSize, MS_SYNC);
+#endif
+}
+
+void MappedFile::close() {
+#if defined(_WIN32)
+    if (mData)
+        UnmapViewOfFile(mData);
+    if (mMapping)
+        CloseHandle(mMapping);
+    if (mFile != INVALID_HANDLE_VALUE)
+        CloseHandle(mFile);
+    mMapping = nullptr;
+    mFile = INVALID_HANDLE_VALUE;
+#else
+    if (mData)
+        munmap(mData, (size_t) mSize);
+    if (mFile >= 0)
+        ::close(mFile);
+    mFile = -1;
+#endif
+    mData = nullptr;
+}
+
+bool fileInfo(const std::string &filename, uint64_t &size, int64_t &timestamp) {
+    struct stat sb;
+    if (stat(filename.c_str(), &sb) != 0)
+        return false;
+    size = (uint64_t) sb.st_size;
+    timestamp = (int64_t) sb.st_mtime;
+    return true;
+}
+
+NAMESPACE_END(detail)
+NAMESPACE_END(nanogui)
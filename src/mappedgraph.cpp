@@ -0,0 +1,355 @@
+/*
+    src/mappedgraph.cpp -- Zoomable graph of memory-mapped sample files
+    that are too large to be loaded into memory
+
+    NanoGUI was developed by Wenzel Jakob <wenzel.jakob@epfl.ch>.
+    The widget drawing code is based on the NanoVG demo application
+    by Mikko Mononen.
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+
+#include <nanogui/mappedgraph.h>
+#include <nanogui/mappedfile.h>
+#include <nanogui/threadpool.h>
+#include <nanogui/theme.h>
+#include <nanogui/opengl.h>
+#include <cstring>
+#include <cstdio>
+#include <cmath>
+#include <iostream>
+
+NAMESPACE_BEGIN(nanogui)
+
+namespace {
+    /* Samples per block of the finest pyramid level, and blocks per block of the next level */
+    const uint64_t PyramidBlockSize = 64;
+    const uint64_t PyramidFanout = 8;
+    const int PyramidMaxLevels = 24;
+
+    /* Before the pyramid is ready, columns spanning more samples are approximated */
+    const uint64_t PreviewThreshold = 4096;
+    const uint64_t PreviewSamples = 64;
+
+    struct PyramidHeader {
+        char magic[8];
+        uint64_t samples;
+        uint64_t sourceSize;
+        int64_t sourceTime;
+        uint32_t levels, reserved;
+        /// Byte offset and number of (min, max) pairs of each level
+        uint64_t offset[PyramidMaxLevels];
+        uint64_t count[PyramidMaxLevels];
+    };
+
+    const char PyramidMagic[8] = { 'N', 'G', 'P', 'Y', 'R', 'M', 'D', '1' };
+
+    /// Fill in the level layout and return the size of the pyramid file
+    uint64_t pyramidLayout(uint64_t samples, PyramidHeader &header) {
+        uint64_t offset = sizeof(PyramidHeader);
+        uint64_t count = (samples + PyramidBlockSize - 1) / PyramidBlockSize;
+        header.levels = 0;
+        while (header.levels < (uint32_t) PyramidMaxLevels) {
+            header.offset[header.levels] = offset;
+            header.count[header.levels] = count;
+            header.levels++;
+            offset += count * 2 * sizeof(float);
+            if (count <= 1)
+                break;
+            count = (count + PyramidFanout - 1) / PyramidFanout;
+        }
+        return offset;
+    }
+}
+
+NAMESPACE_BEGIN(detail)
+
+/// State shared between a \ref MappedSeries and the job building its pyramid
+struct PyramidBuild {
+    std::atomic<float> progress { 0.f };
+    std::atomic<bool> cancel { false };
+    std::atomic<bool> done { false };
+};
+
+NAMESPACE_END(detail)
+
+static void buildPyramid(const std::string &filename, uint64_t samples,
+                         uint64_t sourceSize, int64_t sourceTime,
+                         const std::shared_ptr<detail::PyramidBuild> &build) {
+    std::string target = filename + ".pyramid", temp = target + ".tmp";
+    bool complete = false;
+
+    try {
+        detail::MappedFile source(filename);
+        const float *data = (const float *) source.data();
+
+        PyramidHeader header;
+        memset(&header, 0, sizeof(PyramidHeader));
+        uint64_t total = pyramidLayout(samples, header);
+        memcpy(header.magic, PyramidMagic, sizeof(PyramidMagic));
+        header.samples = samples;
+        header.sourceSize = sourceSize;
+        header.sourceTime = sourceTime;
+
+        detail::MappedFile output(temp, total);
+        uint8_t *base = output.data();
+
+        /* Finest level: one sequential pass over the samples. This dominates
+           the running time, so progress is reported relative to it. */
+        float *level = (float *) (base + header.offset[0]);
+        for (uint64_t i = 0; i < header.count[0]; ++i) {
+            uint64_t begin = i * PyramidBlockSize;
+            uint64_t end = std::min(begin + PyramidBlockSize, samples);
+            Eigen::Map<const VectorXf> block(data + begin, (Eigen::Index) (end - begin));
+            level[2 * i] = block.minCoeff();
+            level[2 * i + 1] = block.maxCoeff();
+
+            if ((i & 0xFFFF) == 0) {
+                if (build->cancel)
+                    break;
+                build->progress = 0.95f * (float) i / (float) header.count[0];
+            }
+        }
+
+        /* Coarser levels are reduced from the previous one */
+        for (uint32_t l = 1; l < header.levels && !build->cancel; ++l) {
+            typedef Eigen::Matrix<float, 2, Eigen::Dynamic> Matrix2Xf;
+            Eigen::Map<const Matrix2Xf> prev((const float *) (base + header.offset[l - 1]),
+                                             2, (Eigen::Index) header.count[l - 1]);
+            float *next = (float *) (base + header.offset[l]);
+            for (uint64_t i = 0; i < header.count[l]; ++i) {
+                uint64_t begin = i * PyramidFanout;
+                uint64_t end = std::min(begin + PyramidFanout, header.count[l - 1]);
+                auto blocks = prev.middleCols((Eigen::Index) begin, (Eigen::Index) (end - begin));
+                next[2 * i] = blocks.row(0).minCoeff();
+                next[2 * i + 1] = blocks.row(1).maxCoeff();
+            }
+        }
+
+        if (!build->cancel) {
+            /* The magic number is written last so that partial files are never accepted */
+            memcpy(base, &header, sizeof(PyramidHeader));
+            output.flush();
+            complete = true;
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "Could not build the pyramid of \"" << filename << "\": " << e.what() << std::endl;
+    }
+
+    if (complete) {
+        std::remove(target.c_str());
+        complete = std::rename(temp.c_str(), target.c_str()) == 0;
+    }
+    if (!complete)
+        std::remove(temp.c_str());
+
+    build->progress = 1.f;
+    build->done = true;
+    ThreadPool::wakeup();
+}
+
+MappedSeries::MappedSeries(const std::string &filename)
+    : mFilename(filename), mSize(0), mTimestamp(0) {
+    uint64_t fileSize;
+    if (!detail::fileInfo(filename, fileSize, mTimestamp))
+        throw std::runtime_error("Could not open \"" + filename + "\"!");
+    mData.reset(new detail::MappedFile(filename));
+    mSize = mData->size() / sizeof(float);
+    if (mSize == 0)
+        throw std::runtime_error("\"" + filename + "\" does not contain any samples!");
+
+    if (!loadPyramid()) {
+        mBuild = std::make_shared<detail::PyramidBuild>();
+        std::shared_ptr<detail::PyramidBuild> build = mBuild;
+        uint64_t samples = mSize, size = mData->size();
+        int64_t timestamp = mTimestamp;
+        ThreadPool::global().enqueue([filename, samples, size, timestamp, build] {
+            buildPyramid(filename, samples, size, timestamp, build);
+        });
+    }
+}
+
+MappedSeries::~MappedSeries() {
+    if (mBuild)
+        mBuild->cancel = true;
+}
+
+float MappedSeries::progress() const {
+    if (mPyramid)
+        return 1.f;
+    return mBuild ? mBuild->progress.load() : 0.f;
+}
+
+bool MappedSeries::loadPyramid() {
+    std::unique_ptr<detail::MappedFile> pyramid;
+    try {
+        pyramid.reset(new detail::MappedFile(mFilename + ".pyramid"));
+    } catch (const std::exception &) {
+        return false;
+    }
+
+    if (pyramid->size() < sizeof(PyramidHeader))
+        return false;
+
+    const PyramidHeader *header = (const PyramidHeader *) pyramid->data();
+    PyramidHeader expected;
+    if (memcmp(header->magic, PyramidMagic, sizeof(PyramidMagic)) != 0 ||
+        header->samples != mSize || header->sourceSize != mData->size() ||
+        header->sourceTime != mTimestamp ||
+        pyramidLayout(mSize, expected) != pyramid->size() ||
+        header->levels != expected.levels)
+        return false;
+
+    mPyramid = std::move(pyramid);
+    return true;
+}
+
+bool MappedSeries::update() {
+    if (!mBuild || !mBuild->done)
+        return false;
+    mBuild.reset();
+    return loadPyramid();
+}
+
+const float *MappedSeries::level(int index) const {
+    const PyramidHeader *header = (const PyramidHeader *) mPyramid->data();
+    return (const float *) (mPyramid->data() + header->offset[index]);
+}
+
+Vector2f MappedSeries::valueRange() const {
+    if (!mPyramid)
+        return Vector2f::Zero();
+    const PyramidHeader *header = (const PyramidHeader *) mPyramid->data();
+    const float *top = level((int) header->levels - 1);
+    return Vector2f(top[0], top[1]);
+}
+
+void MappedSeries::envelope(double begin, double end, int columns, float *out) const {
+    const float *samples = (const float *) mData->data();
+    double spc = std::max(end - begin, 0.0) / std::max(columns, 1);
+
+    /* Coarsest pyramid level whose blocks are no larger than a column */
+    int levelIndex = -1;
+    uint64_t blockSize = PyramidBlockSize;
+    const PyramidHeader *header = nullptr;
+    if (mPyramid) {
+        header = (const PyramidHeader *) mPyramid->data();
+        while (levelIndex + 1 < (int) header->levels && (double) blockSize <= spc) {
+            levelIndex++;
+            blockSize *= PyramidFanout;
+        }
+        blockSize /= PyramidFanout;
+    }
+    const float *pairs = levelIndex >= 0 ? level(levelIndex) : nullptr;
+
+    for (int c = 0; c < columns; ++c) {
+        double fb = std::max(begin + c * spc, 0.0), fe = begin + (c + 1) * spc;
+        uint64_t b = std::min((uint64_t) fb, mSize - 1);
+        uint64_t e = std::min(std::max((uint64_t) fe, b + 1), mSize);
+        float vMin, vMax;
+
+        if (pairs) {
+            /* Blocks overlapping the column (may extend past it by less than a block) */
+            uint64_t bb = b / blockSize, be = std::min((e + blockSize - 1) / blockSize,
+                                                       header->count[levelIndex]);
+            typedef Eigen::Matrix<float, 2, Eigen::Dynamic> Matrix2Xf;
+            Eigen::Map<const Matrix2Xf> blocks(pairs + 2 * bb, 2, (Eigen::Index) (be - bb));
+            vMin = blocks.row(0).minCoeff();
+            vMax = blocks.row(1).maxCoeff();
+        } else if (e - b > PreviewThreshold) {
+            /* No pyramid yet: only look at a few evenly spaced samples */
+            uint64_t stride = (e - b) / PreviewSamples;
+            vMin = vMax = samples[b];
+            for (uint64_t i = b + stride; i < e; i += stride) {
+                vMin = std::min(vMin, samples[i]);
+                vMax = std::max(vMax, samples[i]);
+            }
+        } else {
+            Eigen::Map<const VectorXf> range(samples + b, (Eigen::Index) (e - b));
+            vMin = range.minCoeff();
+            vMax = range.maxCoeff();
+        }
+
+        out[2 * c] = vMin;
+        out[2 * c + 1] = vMax;
+    }
+}
+
+MappedGraph::MappedGraph(Widget *parent, const std::string &caption)
+    : Graph(parent, caption), mViewBegin(0), mViewEnd(0), mValueRange(Vector2f::Zero()),
+      mViewDirty(true), mViewWidth(0) { }
+
+void MappedGraph::setSeries(MappedSeries *series) {
+    mSeries = series;
+    mViewBegin = 0;
+    mViewEnd = series ? (double) series->size() : 0.0;
+    mViewDirty = true;
+}
+
+void MappedGraph::setView(double begin, double end) {
+    double size = mSeries ? (double) mSeries->size() : 0.0;
+    double span = std::min(std::max(end - begin, std::min(size, 8.0)), size);
+    begin = std::min(std::max(begin, 0.0), size - span);
+    mViewBegin = begin;
+    mViewEnd = begin + span;
+    mViewDirty = true;
+}
+
+bool MappedGraph::mouseDragEvent(const Vector2i &, const Vector2i &rel, int, int) {
+    if (!mSeries || mSize.x() <= 0)
+        return false;
+    double shift = -rel.x() * (mViewEnd - mViewBegin) / mSize.x();
+    setView(mViewBegin + shift, mViewEnd + shift);
+    return true;
+}
+
+bool MappedGraph::scrollEvent(const Vector2i &p, const Vector2f &rel) {
+    if (!mSeries || mSize.x() <= 0)
+        return Graph::scrollEvent(p, rel);
+    /* Zoom around the sample under the cursor */
+    double factor = std::pow(1.2, (double) -rel.y());
+    double pivot = mViewBegin + (p.x() - mPos.x()) * (mViewEnd - mViewBegin) / mSize.x();
+    setView(pivot - (pivot - mViewBegin) * factor, pivot + (mViewEnd - pivot) * factor);
+    return true;
+}
+
+void MappedGraph::updateValues() {
+    mViewDirty = false;
+    mViewWidth = mSize.x();
+
+    int columns = std::max(mSize.x(), 1);
+    VectorXf &values = this->values();
+    values.resize(2 * columns);
+    mSeries->envelope(mViewBegin, mViewEnd, columns, values.data());
+
+    Vector2f range = mValueRange;
+    if (range.x() == range.y())
+        range = mSeries->ready() ? mSeries->valueRange()
+                                 : Vector2f(values.minCoeff(), values.maxCoeff());
+    float scale = range.y() != range.x() ? 1.f / (range.y() - range.x()) : 1.f;
+    values = (values.array() - range.x()) * scale;
+}
+
+void MappedGraph::draw(NVGcontext *ctx) {
+    if (mSeries) {
+        if (mSeries->update())
+            mViewDirty = true;
+        if (mViewDirty || mViewWidth != mSize.x())
+            updateValues();
+    }
+
+    Graph::draw(ctx);
+
+    if (mSeries && !mSeries->ready()) {
+        char text[32];
+        snprintf(text, sizeof(text), "Indexing %i%%", (int) (mSeries->progress() * 100));
+        nvgFontFace(ctx, "sans");
+        nvgFontSize(ctx, 14.0f);
+        nvgTextAlign(ctx, NVG_ALIGN_LEFT | NVG_ALIGN_BOTTOM);
+        nvgFillColor(ctx, mTextColor);
+        nvgText(ctx, mPos.x() + 3, mPos.y() + mSize.y() - 1, text, NULL);
+    }
+}
+
+NAMESPACE_END(nanogui)
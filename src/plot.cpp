@@ -0,0 +1,474 @@
+/*
+    src/plot.cpp -- Plot widget for several data series with axes,
+    zooming and panning
+
+    NanoGUI was developed by Wenzel Jakob <wenzel.jakob@epfl.ch>.
+    The widget drawing code is based on the NanoVG demo application
+    by Mikko Mononen.
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+
+#include <nanogui/plot.h>
+#include <nanogui/theme.h>
+#include <nanogui/opengl.h>
+#include <nanogui/serializer/core.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+NAMESPACE_BEGIN(nanogui)
+
+static const Color PlotPalette[] = {
+    Color(255, 192, 0, 255), Color(80, 170, 255, 255), Color(255, 90, 90, 255),
+    Color(100, 220, 100, 255), Color(200, 120, 255, 255), Color(240, 240, 240, 255)
+};
+
+/// Format a value with the given number of decimals, using scientific notation for extreme magnitudes
+static std::string formatValue(float value, int decimals) {
+    char buf[32];
+    float magnitude = std::abs(value);
+    if (magnitude >= 1e7f || (magnitude > 0 && magnitude < 1e-5f))
+        snprintf(buf, sizeof(buf), "%.3g", value);
+    else
+        snprintf(buf, sizeof(buf), "%.*f", decimals, value);
+    return buf;
+}
+
+Plot::Plot(Widget *parent, const std::string &caption)
+    : Widget(parent), mCaption(caption), mView(0, 0, 1, 1), mAutoRange(true),
+      mRangeDirty(true), mMarginLeft(0), mHover(false), mMousePos(Vector2i::Zero()) {
+    mBackgroundColor = Color(20, 128);
+    mGridColor = Color(255, 24);
+    mTextColor = Color(240, 192);
+}
+
+int Plot::addSeries(const std::string &name, const VectorXf &y, const Color &color) {
+    return addSeries(name, VectorXf(), y, color);
+}
+
+int Plot::addSeries(const std::string &name, const VectorXf &x, const VectorXf &y,
+                    const Color &color) {
+    int index = (int) mSeries.size();
+    Series series;
+    series.name = name;
+    series.color = color.w() == 0 ? PlotPalette[index % 6] : color;
+    series.visible = true;
+    mSeries.push_back(series);
+    setSeriesValues(index, x, y);
+    return index;
+}
+
+void Plot::setSeriesValues(int index, const VectorXf &x, const VectorXf &y) {
+    if (x.size() != 0 && x.size() != y.size())
+        throw std::runtime_error("Plot::setSeriesValues(): x and y must have the same size!");
+    Series &series = mSeries[index];
+    series.x = x;
+    series.y = y;
+    updateBounds(series);
+    mRangeDirty = true;
+}
+
+void Plot::removeSeries(int index) {
+    mSeries.erase(mSeries.begin() + index);
+    mRangeDirty = true;
+}
+
+void Plot::updateBounds(Series &series) {
+    Eigen::Index n = series.y.size();
+    series.sorted = true;
+    if (n == 0) {
+        series.bounds = Vector4f::Zero();
+        return;
+    }
+    if (series.x.size() == 0) {
+        series.bounds.x() = 0;
+        series.bounds.z() = (float) (n - 1);
+    } else {
+        series.bounds.x() = series.x.minCoeff();
+        series.bounds.z() = series.x.maxCoeff();
+        if (n > 1)
+            series.sorted = ((series.x.tail(n - 1) - series.x.head(n - 1)).array() >= 0).all();
+    }
+    series.bounds.y() = series.y.minCoeff();
+    series.bounds.w() = series.y.maxCoeff();
+}
+
+void Plot::setView(const Vector4f &view) {
+    mView = view;
+    /* Keep a minimum extent so that repeated zooming cannot collapse the view */
+    for (int i = 0; i < 2; ++i) {
+        float minSpan = std::max(std::abs(mView[i]), std::abs(mView[i + 2])) * 1e-5f + 1e-20f;
+        if (mView[i + 2] - mView[i] < minSpan) {
+            float center = 0.5f * (mView[i] + mView[i + 2]);
+            mView[i] = center - 0.5f * minSpan;
+            mView[i + 2] = center + 0.5f * minSpan;
+        }
+    }
+    mAutoRange = false;
+    mRangeDirty = false;
+}
+
+void Plot::updateRange() {
+    if (!mRangeDirty)
+        return;
+    mRangeDirty = false;
+    if (!mAutoRange)
+        return;
+
+    Vector4f bounds;
+    bool empty = true;
+    for (const Series &series : mSeries) {
+        if (!series.visible || series.y.size() == 0)
+            continue;
+        if (empty)
+            bounds = series.bounds;
+        bounds.head<2>() = bounds.head<2>().cwiseMin(series.bounds.head<2>());
+        bounds.tail<2>() = bounds.tail<2>().cwiseMax(series.bounds.tail<2>());
+        empty = false;
+    }
+    if (empty)
+        bounds = Vector4f(0, 0, 1, 1);
+
+    /* Leave some room above and below the data */
+    float pad = 0.05f * (bounds.w() - bounds.y());
+    bounds.y() -= pad;
+    bounds.w() += pad;
+    for (int i = 0; i < 2; ++i) {
+        if (bounds[i + 2] <= bounds[i]) {
+            float extent = std::max(std::abs(bounds[i]) * 0.1f, 0.5f);
+            bounds[i] -= extent;
+            bounds[i + 2] += extent;
+        }
+    }
+    mView = bounds;
+}
+
+void Plot::updateAxis(NVGcontext *ctx, Axis &axis, float min, float max, int pixels, int spacing) {
+    if (axis.min == min && axis.max == max && axis.pixels == pixels && !axis.labels.empty())
+        return;
+    axis.min = min;
+    axis.max = max;
+    axis.pixels = pixels;
+    axis.ticks.clear();
+    axis.labels.clear();
+    axis.labelWidth = 0;
+
+    /* Round the tick spacing to 1, 2 or 5 times a power of ten */
+    int count = std::max(pixels / spacing, 2);
+    double rough = ((double) max - (double) min) / count;
+    double magnitude = std::pow(10.0, std::floor(std::log10(rough)));
+    double normalized = rough / magnitude;
+    double step = (normalized < 1.5 ? 1 : normalized < 3.5 ? 2 : normalized < 7.5 ? 5 : 10) * magnitude;
+    int decimals = std::min(std::max(0, (int) -std::floor(std::log10(step) + 1e-6)), 9);
+
+    for (double tick = std::ceil(min / step) * step; tick <= max; tick += step) {
+        float value = std::abs(tick) < step * 1e-6 ? 0.f : (float) tick;
+        axis.ticks.push_back(value);
+        axis.labels.push_back(formatValue(value, decimals));
+        axis.labelWidth = std::max(axis.labelWidth,
+            nvgTextBounds(ctx, 0, 0, axis.labels.back().c_str(), nullptr, nullptr));
+    }
+}
+
+Vector4f Plot::plotArea() const {
+    float top = mPos.y() + (mCaption.empty() ? 8.f : 22.f);
+    float bottom = mPos.y() + mSize.y() - 20.f;
+    float left = mPos.x() + mMarginLeft;
+    float right = mPos.x() + mSize.x() - 10.f;
+    return Vector4f(left, top, std::max(right - left, 1.f), std::max(bottom - top, 1.f));
+}
+
+void Plot::drawSeries(NVGcontext *ctx, const Series &series, const Vector2f &origin, const Vector2f &scale) {
+    Eigen::Index n = series.y.size();
+    if (n == 0)
+        return;
+
+    nvgBeginPath(ctx);
+    if (series.x.size() == 0) {
+        /* Implicit coordinates: only the visible index range is drawn */
+        Eigen::Index begin = (Eigen::Index) std::max(std::floor(mView.x()), 0.f);
+        Eigen::Index end = (Eigen::Index) std::min(std::ceil(mView.z()), (float) (n - 1)) + 1;
+        if (begin >= end)
+            return;
+        Eigen::Index count = end - begin;
+        Eigen::Index columns = std::max((Eigen::Index) (scale.x() * (end - begin)), (Eigen::Index) 1);
+
+        if (count <= 2 * columns) {
+            for (Eigen::Index i = begin; i < end; ++i) {
+                float px = origin.x() + i * scale.x(), py = origin.y() + series.y[i] * scale.y();
+                if (i == begin)
+                    nvgMoveTo(ctx, px, py);
+                else
+                    nvgLineTo(ctx, px, py);
+            }
+        } else {
+            /* More samples than pixels: draw the extrema of each pixel column, in sample order */
+            for (Eigen::Index c = 0; c < columns; ++c) {
+                Eigen::Index b = begin + c * count / columns, e = begin + (c + 1) * count / columns;
+                if (b == e)
+                    continue;
+                auto segment = series.y.segment(b, e - b);
+                Eigen::Index iMin, iMax;
+                float vMin = segment.minCoeff(&iMin), vMax = segment.maxCoeff(&iMax);
+                float px = origin.x() + (b + e) * 0.5f * scale.x();
+                float first = iMin < iMax ? vMin : vMax, second = iMin < iMax ? vMax : vMin;
+                if (c == 0)
+                    nvgMoveTo(ctx, px, origin.y() + first * scale.y());
+                else
+                    nvgLineTo(ctx, px, origin.y() + first * scale.y());
+                nvgLineTo(ctx, px, origin.y() + second * scale.y());
+            }
+        }
+    } else {
+        Eigen::Index begin = 0, end = n;
+        if (series.sorted) {
+            const float *x = series.x.data();
+            begin = std::max((Eigen::Index) (std::lower_bound(x, x + n, mView.x()) - x) - 1, (Eigen::Index) 0);
+            end = std::min((Eigen::Index) (std::upper_bound(x, x + n, mView.z()) - x) + 1, n);
+        }
+        for (Eigen::Index i = begin; i < end; ++i) {
+            float px = origin.x() + series.x[i] * scale.x(), py = origin.y() + series.y[i] * scale.y();
+            if (i == begin)
+                nvgMoveTo(ctx, px, py);
+            else
+                nvgLineTo(ctx, px, py);
+        }
+    }
+
+    nvgStrokeColor(ctx, series.color);
+    nvgStrokeWidth(ctx, 1.5f);
+    nvgStroke(ctx);
+    nvgStrokeWidth(ctx, 1.0f);
+}
+
+void Plot::drawReadout(NVGcontext *ctx, const Vector2f &origin, const Vector2f &scale) {
+    Vector4f area = plotArea();
+    if (!mHover || mMousePos.x() < area.x() || mMousePos.x() > area.x() + area.z() ||
+        mMousePos.y() < area.y() || mMousePos.y() > area.y() + area.w())
+        return;
+
+    float xm = (mMousePos.x() - origin.x()) / scale.x();
+    nvgBeginPath(ctx);
+    nvgMoveTo(ctx, mMousePos.x() + 0.5f, area.y());
+    nvgLineTo(ctx, mMousePos.x() + 0.5f, area.y() + area.w());
+    nvgStrokeColor(ctx, Color(255, 64));
+    nvgStroke(ctx);
+
+    std::vector<std::string> lines;
+    std::vector<Color> colors;
+    lines.push_back("x = " + formatValue(xm, 4));
+    colors.push_back(mTextColor);
+
+    for (const Series &series : mSeries) {
+        Eigen::Index n = series.y.size();
+        if (!series.visible || n == 0)
+            continue;
+
+        /* Sample closest to the cursor */
+        Eigen::Index index;
+        if (series.x.size() == 0) {
+            index = (Eigen::Index) std::round(std::min(std::max(xm, 0.f), (float) (n - 1)));
+        } else if (series.sorted) {
+            const float *x = series.x.data();
+            index = std::min((Eigen::Index) (std::lower_bound(x, x + n, xm) - x), n - 1);
+            if (index > 0 && xm - x[index - 1] < x[index] - xm)
+                index--;
+        } else {
+            (series.x.array() - xm).abs().minCoeff(&index);
+        }
+
+        float x = series.x.size() == 0 ? (float) index : series.x[index];
+        nvgBeginPath(ctx);
+        nvgCircle(ctx, origin.x() + x * scale.x(), origin.y() + series.y[index] * scale.y(), 3.f);
+        nvgFillColor(ctx, series.color);
+        nvgFill(ctx);
+
+        lines.push_back((series.name.empty() ? std::string("y") : series.name) + ": " +
+                        formatValue(series.y[index], 4));
+        colors.push_back(series.color);
+    }
+
+    float lineHeight = 16.f, width = 0;
+    for (const std::string &line : lines)
+        width = std::max(width, nvgTextBounds(ctx, 0, 0, line.c_str(), nullptr, nullptr));
+    float height = lines.size() * lineHeight + 6.f;
+    width += 12.f;
+
+    float bx = mMousePos.x() + 12.f, by = mMousePos.y() + 12.f;
+    if (bx + width > area.x() + area.z())
+        bx = mMousePos.x() - 12.f - width;
+    if (by + height > area.y() + area.w())
+        by = std::max(area.y(), mMousePos.y() - 12.f - height);
+
+    nvgBeginPath(ctx);
+    nvgRoundedRect(ctx, bx, by, width, height, 3.f);
+    nvgFillColor(ctx, Color(0, 200));
+    nvgFill(ctx);
+
+    nvgTextAlign(ctx, NVG_ALIGN_LEFT | NVG_ALIGN_TOP);
+    for (size_t i = 0; i < lines.size(); ++i) {
+        nvgFillColor(ctx, colors[i]);
+        nvgText(ctx, bx + 6.f, by + 3.f + i * lineHeight, lines[i].c_str(), nullptr);
+    }
+}
+
+bool Plot::mouseButtonEvent(const Vector2i &p, int button, bool down, int modifiers) {
+    if (button == GLFW_MOUSE_BUTTON_2 && down) {
+        resetView();
+        return true;
+    }
+    if (button == GLFW_MOUSE_BUTTON_1)
+        return true;
+    return Widget::mouseButtonEvent(p, button, down, modifiers);
+}
+
+bool Plot::mouseMotionEvent(const Vector2i &p, const Vector2i &, int, int) {
+    mMousePos = p;
+    mHover = true;
+    return true;
+}
+
+bool Plot::mouseDragEvent(const Vector2i &p, const Vector2i &rel, int, int) {
+    Vector4f area = plotArea();
+    float dx = -rel.x() * (mView.z() - mView.x()) / area.z();
+    float dy = rel.y() * (mView.w() - mView.y()) / area.w();
+    setView(mView + Vector4f(dx, dy, dx, dy));
+    mMousePos = p;
+    return true;
+}
+
+bool Plot::mouseEnterEvent(const Vector2i &p, bool enter) {
+    Widget::mouseEnterEvent(p, enter);
+    mHover = enter;
+    return true;
+}
+
+bool Plot::scrollEvent(const Vector2i &p, const Vector2f &rel) {
+    Vector4f area = plotArea();
+    /* Zoom around the position under the cursor */
+    float factor = std::pow(1.2f, -rel.y());
+    float tx = std::min(std::max((p.x() - area.x()) / area.z(), 0.f), 1.f);
+    float ty = std::min(std::max(1.f - (p.y() - area.y()) / area.w(), 0.f), 1.f);
+    Vector2f pivot(mView.x() + tx * (mView.z() - mView.x()),
+                   mView.y() + ty * (mView.w() - mView.y()));
+    setView(Vector4f(pivot.x() - (pivot.x() - mView.x()) * factor,
+                     pivot.y() - (pivot.y() - mView.y()) * factor,
+                     pivot.x() + (mView.z() - pivot.x()) * factor,
+                     pivot.y() + (mView.w() - pivot.y()) * factor));
+    return true;
+}
+
+Vector2i Plot::preferredSize(NVGcontext *) const {
+    return Vector2i(320, 200);
+}
+
+void Plot::draw(NVGcontext *ctx) {
+    Widget::draw(ctx);
+    updateRange();
+
+    nvgBeginPath(ctx);
+    nvgRect(ctx, mPos.x(), mPos.y(), mSize.x(), mSize.y());
+    nvgFillColor(ctx, mBackgroundColor);
+    nvgFill(ctx);
+
+    nvgFontFace(ctx, "sans");
+    nvgFontSize(ctx, 13.0f);
+
+    /* The height of the plot area does not depend on the width of the labels */
+    Vector4f area = plotArea();
+    updateAxis(ctx, mAxes[1], mView.y(), mView.w(), (int) area.w(), 30);
+    mMarginLeft = mAxes[1].labelWidth + 10.f;
+    area = plotArea();
+    updateAxis(ctx, mAxes[0], mView.x(), mView.z(), (int) area.z(), 80);
+
+    Vector2f scale(area.z() / (mView.z() - mView.x()), -area.w() / (mView.w() - mView.y()));
+    Vector2f origin(area.x() - mView.x() * scale.x(), area.y() + area.w() - mView.y() * scale.y());
+
+    /* Grid and tick labels */
+    nvgBeginPath(ctx);
+    for (float tick : mAxes[0].ticks) {
+        float px = std::round(origin.x() + tick * scale.x()) + 0.5f;
+        nvgMoveTo(ctx, px, area.y());
+        nvgLineTo(ctx, px, area.y() + area.w());
+    }
+    for (float tick : mAxes[1].ticks) {
+        float py = std::round(origin.y() + tick * scale.y()) + 0.5f;
+        nvgMoveTo(ctx, area.x(), py);
+        nvgLineTo(ctx, area.x() + area.z(), py);
+    }
+    nvgStrokeColor(ctx, mGridColor);
+    nvgStroke(ctx);
+
+    nvgFillColor(ctx, mTextColor);
+    nvgTextAlign(ctx, NVG_ALIGN_CENTER | NVG_ALIGN_TOP);
+    for (size_t i = 0; i < mAxes[0].ticks.size(); ++i)
+        nvgText(ctx, origin.x() + mAxes[0].ticks[i] * scale.x(), area.y() + area.w() + 4.f,
+                mAxes[0].labels[i].c_str(), nullptr);
+    nvgTextAlign(ctx, NVG_ALIGN_RIGHT | NVG_ALIGN_MIDDLE);
+    for (size_t i = 0; i < mAxes[1].ticks.size(); ++i)
+        nvgText(ctx, area.x() - 5.f, origin.y() + mAxes[1].ticks[i] * scale.y(),
+                mAxes[1].labels[i].c_str(), nullptr);
+
+    /* Data */
+    nvgSave(ctx);
+    nvgIntersectScissor(ctx, area.x(), area.y(), area.z(), area.w());
+    for (const Series &series : mSeries)
+        if (series.visible)
+            drawSeries(ctx, series, origin, scale);
+
+    /* Legend */
+    float ly = area.y() + 6.f;
+    nvgTextAlign(ctx, NVG_ALIGN_RIGHT | NVG_ALIGN_MIDDLE);
+    for (const Series &series : mSeries) {
+        if (!series.visible || series.name.empty())
+            continue;
+        float lx = area.x() + area.z() - 6.f;
+        nvgFillColor(ctx, mTextColor);
+        nvgText(ctx, lx, ly + 6.f, series.name.c_str(), nullptr);
+        float textWidth = nvgTextBounds(ctx, 0, 0, series.name.c_str(), nullptr, nullptr);
+        nvgBeginPath(ctx);
+        nvgMoveTo(ctx, lx - textWidth - 22.f, ly + 6.5f);
+        nvgLineTo(ctx, lx - textWidth - 6.f, ly + 6.5f);
+        nvgStrokeColor(ctx, series.color);
+        nvgStrokeWidth(ctx, 2.0f);
+        nvgStroke(ctx);
+        nvgStrokeWidth(ctx, 1.0f);
+        ly += 16.f;
+    }
+    nvgRestore(ctx);
+
+    drawReadout(ctx, origin, scale);
+
+    if (!mCaption.empty()) {
+        nvgFontSize(ctx, 14.0f);
+        nvgTextAlign(ctx, NVG_ALIGN_LEFT | NVG_ALIGN_TOP);
+        nvgFillColor(ctx, mTextColor);
+        nvgText(ctx, mPos.x() + 3, mPos.y() + 3, mCaption.c_str(), nullptr);
+    }
+
+    nvgBeginPath(ctx);
+    nvgRect(ctx, area.x() + 0.5f, area.y() + 0.5f, area.z() - 1, area.w() - 1);
+    nvgStrokeColor(ctx, Color(100, 255));
+    nvgStroke(ctx);
+}
+
+void Plot::save(Serializer &s) const {
+    Widget::save(s);
+    s.set("caption", mCaption);
+    s.set("backgroundColor", mBackgroundColor);
+    s.set("gridColor", mGridColor);
+    s.set("textColor", mTextColor);
+}
+
+bool Plot::load(Serializer &s) {
+    if (!Widget::load(s)) return false;
+    if (!s.get("caption", mCaption)) return false;
+    if (!s.get("backgroundColor", mBackgroundColor)) return false;
+    if (!s.get("gridColor", mGridColor)) return false;
+    if (!s.get("textColor", mTextColor)) return false;
+    return true;
+}
+
+NAMESPACE_END(nanogui)
@@ -41,20 +41,17 @@ void PopupButton::draw(NVGcontext* ctx) {
     Button::draw(ctx);
 
     if (mChevronIcon) {
-        auto icon = utf8(mChevronIcon);
-        NVGcolor textColor =
+        Color textColor =
             mTextColor.w() == 0 ? mTheme->mTextColor : mTextColor;
+        float size = (mFontSize < 0 ? mTheme->mButtonFontSize : mFontSize) * 1.5f;
 
-        nvgFontSize(ctx, (mFontSize < 0 ? mTheme->mButtonFontSize : mFontSize) * 1.5f);
-        nvgFontFace(ctx, "icons");
-        nvgFillColor(ctx, mEnabled ? textColor : mTheme->mDisabledTextColor);
-        nvgTextAlign(ctx, NVG_ALIGN_LEFT | NVG_ALIGN_MIDDLE);
-
-        float iw = nvgTextBounds(ctx, 0, 0, icon.data(), nullptr, nullptr);
+        float iw = iconWidth(ctx, mChevronIcon, size);
         Vector2f iconPos(mPos.x() + mSize.x() - iw - 8,
                          mPos.y() + mSize.y() * 0.5f - 1);
 
-        nvgText(ctx, iconPos.x(), iconPos.y(), icon.data(), nullptr);
+        drawIcon(ctx, mChevronIcon, iconPos.x(), iconPos.y(), size,
+                 NVG_ALIGN_LEFT | NVG_ALIGN_MIDDLE,
+                 mEnabled ? textColor : mTheme->mDisabledTextColor);
     }
 }
 
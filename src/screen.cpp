@@ -16,6 +16,9 @@
 #include <nanogui/opengl.h>
 #include <nanogui/window.h>
 #include <nanogui/popup.h>
+#include <nanogui/sdftext.h>
+#include <nanogui/texturemanager.h>
+#include <nanogui/glutil.h>
 #include <map>
 #include <iostream>
 
@@ -290,12 +293,50 @@ Screen::~Screen() {
         if (mCursors[i])
             glfwDestroyCursor(mCursors[i]);
     }
+    delete mSdfText;
+    delete mTextureManager;
+    for (auto &kv : mSharedShaders) {
+        if (kv.second) {
+            kv.second->free();
+            delete kv.second;
+        }
+    }
     if (mNVGContext)
         nvgDeleteGL3(mNVGContext);
     if (mGLFWWindow && mShutdownGLFWOnDestruct)
         glfwDestroyWindow(mGLFWWindow);
 }
 
+SdfTextRenderer *Screen::sdfText() {
+    if (!mSdfText)
+        mSdfText = new SdfTextRenderer();
+    return mSdfText;
+}
+
+TextureManager *Screen::textureManager() {
+    if (!mTextureManager)
+        mTextureManager = new TextureManager(mNVGContext);
+    return mTextureManager;
+}
+
+const GLShader *Screen::sharedShader(const std::string &name, const std::string &vertex,
+                                     const std::string &fragment, const std::string &geometry) {
+    auto it = mSharedShaders.find(name);
+    if (it != mSharedShaders.end())
+        return it->second;
+
+    GLShader *shader = new GLShader();
+    try {
+        shader->init(name, vertex, fragment, geometry);
+    } catch (const std::exception &e) {
+        std::cerr << "Could not create shader \"" << name << "\": " << e.what() << std::endl;
+        delete shader;
+        shader = nullptr;
+    }
+    mSharedShaders[name] = shader;
+    return shader;
+}
+
 void Screen::setVisible(bool visible) {
     if (mVisible != visible) {
         mVisible = visible;
@@ -329,6 +370,27 @@ void Screen::drawAll() {
     glfwSwapBuffers(mGLFWWindow);
 }
 
+void Screen::draw(NVGcontext *ctx) {
+    if (!mTheme || !mTheme->mSdfText) {
+        Widget::draw(ctx);
+        return;
+    }
+
+    /* Distance field text is rendered by a separate shader after the
+       NanoVG frame has ended. Flush both after every top-level widget
+       so that text keeps the stacking order of windows and popups. */
+    for (auto child : mChildren) {
+        if (!child->visible())
+            continue;
+        child->draw(ctx);
+        if (mSdfText && !mSdfText->empty()) {
+            nvgEndFrame(ctx);
+            mSdfText->flush(mSize);
+            nvgBeginFrame(ctx, mSize[0], mSize[1], mPixelRatio);
+        }
+    }
+}
+
 void Screen::drawWidgets() {
     if (!mVisible)
         return;
@@ -355,6 +417,12 @@ void Screen::drawWidgets() {
     mPixelRatio = (float) mFBSize[0] / (float) mSize[0];
     nvgBeginFrame(mNVGContext, mSize[0], mSize[1], mPixelRatio);
 
+    if (mTextureManager)
+        mTextureManager->beginFrame();
+
+    if (mTheme && mTheme->glyphPrewarmPending())
+        mTheme->prewarmGlyphs(mNVGContext, mTheme->mGlyphPrewarmBudget);
+
     draw(mNVGContext);
 
     double elapsed = glfwGetTime() - mLastInteraction;
@@ -400,6 +468,10 @@ void Screen::drawWidgets() {
     }
 
     nvgEndFrame(mNVGContext);
+
+    /* Images drawn in this frame could not be evicted while it was recorded */
+    if (mTextureManager)
+        mTextureManager->enforceBudget();
 }
 
 bool Screen::keyboardEvent(int key, int scancode, int action, int modifiers) {
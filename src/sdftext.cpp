@@ -0,0 +1,416 @@
+/*
+    src/sdftext.cpp -- Resolution-independent text rendering based on
+    signed distance field glyph atlases
+
+    NanoGUI was developed by Wenzel Jakob <wenzel.jakob@epfl.ch>.
+    The widget drawing code is based on the NanoVG demo application
+    by Mikko Mononen.
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+
+#include <nanogui/sdftext.h>
+#include <nanogui/glutil.h>
+#include <cmath>
+
+/* Private copy of stb_truetype: the instance compiled into NanoVG routes its
+   allocations through the fontstash scratch buffer */
+#define STB_TRUETYPE_IMPLEMENTATION
+#define STBTT_STATIC
+#include <stb_truetype.h>
+
+NAMESPACE_BEGIN(nanogui)
+
+namespace {
+    const int maxAtlasSize = 4096;
+    const float infinity = 1e20f;
+
+    /// Decode the next codepoint of a UTF-8 string (invalid sequences yield U+FFFD)
+    int decodeUTF8(const std::string &str, size_t &pos) {
+        uint8_t c = (uint8_t) str[pos++];
+        int extra = c < 0x80 ? 0 : (c >> 5) == 0x6 ? 1 : (c >> 4) == 0xE ? 2 :
+                    (c >> 3) == 0x1E ? 3 : -1;
+        if (extra < 0)
+            return 0xFFFD;
+        int codepoint = extra == 0 ? c : (c & (0x3F >> extra));
+        for (int i = 0; i < extra; ++i) {
+            if (pos >= str.size() || ((uint8_t) str[pos] >> 6) != 0x2)
+                return 0xFFFD;
+            codepoint = (codepoint << 6) | ((uint8_t) str[pos++] & 0x3F);
+        }
+        return codepoint;
+    }
+
+    /// One-dimensional squared Euclidean distance transform (Felzenszwalb & Huttenlocher)
+    void distanceTransform1D(const float *f, float *d, int *v, float *z, int n) {
+        int k = 0;
+        v[0] = 0;
+        z[0] = -infinity;
+        z[1] = infinity;
+        for (int q = 1; q < n; ++q) {
+            float s;
+            while (true) {
+                int r = v[k];
+                s = ((f[q] + q * q) - (f[r] + r * r)) / (2 * q - 2 * r);
+                if (s > z[k] || k == 0)
+                    break;
+                --k;
+            }
+            ++k;
+            v[k] = q;
+            z[k] = s;
+            z[k + 1] = infinity;
+        }
+        k = 0;
+        for (int q = 0; q < n; ++q) {
+            while (z[k + 1] < q)
+                ++k;
+            d[q] = (q - v[k]) * (q - v[k]) + f[v[k]];
+        }
+    }
+
+    /// Two-dimensional squared distance to the nearest pixel where \c grid is zero
+    void distanceTransform2D(std::vector<float> &grid, int width, int height) {
+        int n = std::max(width, height);
+        std::vector<float> f(n), d(n), z(n + 1);
+        std::vector<int> v(n);
+
+        for (int x = 0; x < width; ++x) {
+            for (int y = 0; y < height; ++y)
+                f[y] = grid[y * width + x];
+            distanceTransform1D(f.data(), d.data(), v.data(), z.data(), height);
+            for (int y = 0; y < height; ++y)
+                grid[y * width + x] = d[y];
+        }
+        for (int y = 0; y < height; ++y) {
+            distanceTransform1D(&grid[y * width], d.data(), v.data(), z.data(), width);
+            std::copy(d.begin(), d.begin() + width, grid.begin() + y * width);
+        }
+    }
+}
+
+SdfFont::SdfFont(const uint8_t *data, float baseSize, int spread)
+    : mFont(new stbtt_fontinfo()), mBaseSize(baseSize), mSpread(spread),
+      mAtlasSize(512, 512), mShelfX(1), mShelfY(1), mShelfHeight(0),
+      mDirtyBegin(0), mDirtyEnd(0), mTexture(0), mTextureSize(Vector2i::Zero()) {
+    if (!stbtt_InitFont(mFont, data, stbtt_GetFontOffsetForIndex(data, 0)))
+        throw std::runtime_error("SdfFont: could not parse font data!");
+    mScale = stbtt_ScaleForPixelHeight(mFont, mBaseSize);
+
+    int ascent, descent, lineGap;
+    stbtt_GetFontVMetrics(mFont, &ascent, &descent, &lineGap);
+    float height = (float) (ascent - descent);
+    mAscender = ascent / height;
+    mDescender = descent / height;
+
+    mAtlas.resize(mAtlasSize.prod(), 0);
+}
+
+SdfFont::~SdfFont() {
+    if (mTexture)
+        glDeleteTextures(1, &mTexture);
+    delete mFont;
+}
+
+const SdfFont::Glyph *SdfFont::glyph(int codepoint) {
+    auto it = mGlyphs.find(codepoint);
+    if (it != mGlyphs.end())
+        return &it->second;
+
+    Glyph glyph;
+    if (!addGlyph(codepoint, glyph))
+        return nullptr;
+    return &(mGlyphs[codepoint] = glyph);
+}
+
+bool SdfFont::addGlyph(int codepoint, Glyph &glyph) {
+    int advance, bearing, x0, y0, x1, y1;
+    stbtt_GetCodepointHMetrics(mFont, codepoint, &advance, &bearing);
+    stbtt_GetCodepointBitmapBox(mFont, codepoint, mScale, mScale, &x0, &y0, &x1, &y1);
+
+    glyph.advance = advance * mScale;
+    glyph.xoff = (float) (x0 - mSpread);
+    glyph.yoff = (float) (y0 - mSpread);
+    glyph.x = glyph.y = glyph.width = glyph.height = 0;
+    if (x1 <= x0 || y1 <= y0)
+        return true; /* Whitespace */
+
+    int width = x1 - x0 + 2 * mSpread, height = y1 - y0 + 2 * mSpread;
+
+    /* Shelf packing, growing the atlas vertically when it runs out of space */
+    if (mShelfX + width + 1 > mAtlasSize.x()) {
+        mShelfX = 1;
+        mShelfY += mShelfHeight + 1;
+        mShelfHeight = 0;
+    }
+    while (mShelfY + height + 1 > mAtlasSize.y()) {
+        if (mAtlasSize.y() >= maxAtlasSize || width + 2 > mAtlasSize.x())
+            return false;
+        mAtlasSize.y() *= 2;
+        mAtlas.resize(mAtlasSize.prod(), 0);
+    }
+    glyph.x = mShelfX;
+    glyph.y = mShelfY;
+    glyph.width = width;
+    glyph.height = height;
+    mShelfX += width + 1;
+    mShelfHeight = std::max(mShelfHeight, height);
+
+    std::vector<uint8_t> coverage(width * height, 0);
+    stbtt_MakeCodepointBitmap(mFont, &coverage[mSpread * width + mSpread],
+                              x1 - x0, y1 - y0, width, mScale, mScale, codepoint);
+
+    /* Signed distance between pixel centers of the inside and outside regions */
+    std::vector<float> outside(width * height), inside(width * height);
+    for (int i = 0; i < width * height; ++i) {
+        bool in = coverage[i] >= 128;
+        outside[i] = in ? 0.f : infinity;
+        inside[i] = in ? infinity : 0.f;
+    }
+    distanceTransform2D(outside, width, height);
+    distanceTransform2D(inside, width, height);
+
+    for (int y = 0; y < height; ++y) {
+        uint8_t *row = &mAtlas[(glyph.y + y) * mAtlasSize.x() + glyph.x];
+        for (int x = 0; x < width; ++x) {
+            int i = y * width + x;
+            float dist = std::sqrt(outside[i]) - std::sqrt(inside[i]);
+            float value = 0.5f - dist / (2.f * mSpread);
+            row[x] = (uint8_t) (std::min(std::max(value, 0.f), 1.f) * 255.f + 0.5f);
+        }
+    }
+
+    if (mDirtyBegin == mDirtyEnd) {
+        mDirtyBegin = glyph.y;
+        mDirtyEnd = glyph.y + height;
+    } else {
+        mDirtyBegin = std::min(mDirtyBegin, glyph.y);
+        mDirtyEnd = std::max(mDirtyEnd, glyph.y + height);
+    }
+    return true;
+}
+
+float SdfFont::kerning(int codepoint1, int codepoint2) const {
+    return stbtt_GetCodepointKernAdvance(mFont, codepoint1, codepoint2) * mScale;
+}
+
+float SdfFont::textWidth(const std::string &text, float size) {
+    float width = 0.f;
+    int prev = -1;
+    for (size_t pos = 0; pos < text.size(); ) {
+        int codepoint = decodeUTF8(text, pos);
+        const Glyph *g = glyph(codepoint);
+        if (!g)
+            continue;
+        if (prev >= 0)
+            width += kerning(prev, codepoint);
+        width += g->advance;
+        prev = codepoint;
+    }
+    return width * size / mBaseSize;
+}
+
+void SdfFont::bindTexture() {
+    if (mTexture == 0)
+        glGenTextures(1, &mTexture);
+    glBindTexture(GL_TEXTURE_2D, mTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    if (mTextureSize != mAtlasSize) {
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, mAtlasSize.x(), mAtlasSize.y(),
+                     0, GL_RED, GL_UNSIGNED_BYTE, mAtlas.data());
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        mTextureSize = mAtlasSize;
+    } else if (mDirtyBegin != mDirtyEnd) {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, mDirtyBegin, mAtlasSize.x(),
+                        mDirtyEnd - mDirtyBegin, GL_RED, GL_UNSIGNED_BYTE,
+                        &mAtlas[mDirtyBegin * mAtlasSize.x()]);
+    }
+    mDirtyBegin = mDirtyEnd = 0;
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+SdfTextRenderer::SdfTextRenderer() : mShader(nullptr) { }
+
+SdfTextRenderer::~SdfTextRenderer() {
+    if (mShader) {
+        mShader->free();
+        delete mShader;
+    }
+}
+
+/// Move the pen position from the anchor given by NanoVG alignment flags to the baseline start
+static void alignPen(SdfFont *font, float size, int align, float width, float &x, float &y) {
+    if (align & NVG_ALIGN_CENTER)
+        x -= width * 0.5f;
+    else if (align & NVG_ALIGN_RIGHT)
+        x -= width;
+
+    if (align & NVG_ALIGN_TOP)
+        y += font->ascender() * size;
+    else if (align & NVG_ALIGN_MIDDLE)
+        y += (font->ascender() + font->descender()) * 0.5f * size;
+    else if (align & NVG_ALIGN_BOTTOM)
+        y += font->descender() * size;
+}
+
+SdfTextRenderer::Batch &SdfTextRenderer::batch(SdfFont *font) {
+    for (auto &b : mBatches)
+        if (b.font.get() == font)
+            return b;
+    mBatches.push_back(Batch());
+    mBatches.back().font = font;
+    return mBatches.back();
+}
+
+void SdfTextRenderer::addQuad(Batch &batch, const float *xform, const SdfFont::Glyph &g,
+                              float x, float y, float scale, const Color &color,
+                              const Vector4f &clip) {
+    if (g.width == 0)
+        return;
+    float qx[2] = { x + g.xoff * scale, x + (g.xoff + g.width) * scale };
+    float qy[2] = { y + g.yoff * scale, y + (g.yoff + g.height) * scale };
+    /* Texel coordinates: the atlas may still grow before the next flush */
+    float u[2] = { (float) g.x, (float) (g.x + g.width) };
+    float v[2] = { (float) g.y, (float) (g.y + g.height) };
+    const int corners[6][2] = { {0, 0}, {1, 0}, {1, 1}, {0, 0}, {1, 1}, {0, 1} };
+
+    for (auto &c : corners) {
+        float px = qx[c[0]], py = qy[c[1]];
+        batch.positions.push_back(xform[0] * px + xform[2] * py + xform[4]);
+        batch.positions.push_back(xform[1] * px + xform[3] * py + xform[5]);
+        batch.texcoords.push_back(u[c[0]]);
+        batch.texcoords.push_back(v[c[1]]);
+        for (int i = 0; i < 4; ++i) {
+            batch.colors.push_back(color[i]);
+            batch.clips.push_back(clip[i]);
+        }
+    }
+}
+
+float SdfTextRenderer::text(NVGcontext *ctx, SdfFont *font, float x, float y,
+                            float size, int align, const Color &color,
+                            const std::string &text, const Vector4f &clip) {
+    alignPen(font, size, align, font->textWidth(text, size), x, y);
+
+    Batch &batch = this->batch(font);
+    float xform[6];
+    nvgCurrentTransform(ctx, xform);
+    float scale = size / font->baseSize();
+
+    int prev = -1;
+    float penX = x;
+    for (size_t pos = 0; pos < text.size(); ) {
+        int codepoint = decodeUTF8(text, pos);
+        const SdfFont::Glyph *g = font->glyph(codepoint);
+        if (!g)
+            continue;
+        if (prev >= 0)
+            penX += font->kerning(prev, codepoint) * scale;
+        prev = codepoint;
+        addQuad(batch, xform, *g, penX, y, scale, color, clip);
+        penX += g->advance * scale;
+    }
+
+    return penX - x;
+}
+
+float SdfTextRenderer::glyph(NVGcontext *ctx, SdfFont *font, int codepoint, float x, float y,
+                             float size, int align, const Color &color, const Vector4f &clip) {
+    const SdfFont::Glyph *g = font->glyph(codepoint);
+    if (!g)
+        return 0.f;
+    float scale = size / font->baseSize();
+    alignPen(font, size, align, g->advance * scale, x, y);
+
+    float xform[6];
+    nvgCurrentTransform(ctx, xform);
+    addQuad(batch(font), xform, *g, x, y, scale, color, clip);
+    return g->advance * scale;
+}
+
+void SdfTextRenderer::flush(const Vector2i &size) {
+    if (mBatches.empty())
+        return;
+
+    if (!mShader) {
+        mShader = new GLShader();
+        mShader->init(
+            "sdf_text_shader",
+
+            /* Vertex shader */
+            "#version 330\n"
+            "uniform vec2 screenSize;\n"
+            "uniform vec2 atlasSize;\n"
+            "in vec2 position;\n"
+            "in vec2 texcoord;\n"
+            "in vec4 color;\n"
+            "in vec4 clip;\n"
+            "out vec2 uv;\n"
+            "out vec2 screenPos;\n"
+            "out vec4 textColor;\n"
+            "out vec4 clipRect;\n"
+            "void main() {\n"
+            "    uv = texcoord / atlasSize;\n"
+            "    screenPos = position;\n"
+            "    textColor = color;\n"
+            "    clipRect = clip;\n"
+            "    gl_Position = vec4(2.0 * position.x / screenSize.x - 1.0,\n"
+            "                       1.0 - 2.0 * position.y / screenSize.y, 0.0, 1.0);\n"
+            "}",
+
+            /* Fragment shader */
+            "#version 330\n"
+            "uniform sampler2D atlas;\n"
+            "in vec2 uv;\n"
+            "in vec2 screenPos;\n"
+            "in vec4 textColor;\n"
+            "in vec4 clipRect;\n"
+            "out vec4 outColor;\n"
+            "void main() {\n"
+            "    if (screenPos.x < clipRect.x || screenPos.y < clipRect.y ||\n"
+            "        screenPos.x > clipRect.z || screenPos.y > clipRect.w)\n"
+            "        discard;\n"
+            "    float dist = texture(atlas, uv).r;\n"
+            "    float width = max(fwidth(dist) * 0.7, 1e-4);\n"
+            "    float alpha = smoothstep(0.5 - width, 0.5 + width, dist) * textColor.a;\n"
+            "    outColor = vec4(textColor.rgb * alpha, alpha);\n"
+            "}"
+        );
+        mUniformScreenSize = mShader->uniformHandle("screenSize");
+        mUniformAtlas = mShader->uniformHandle("atlas");
+        mUniformAtlasSize = mShader->uniformHandle("atlasSize");
+    }
+
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_CULL_FACE);
+    glDisable(GL_SCISSOR_TEST);
+
+    mShader->bind();
+    mShader->setUniform(mUniformScreenSize, Vector2f(size.cast<float>()));
+    mShader->setUniform(mUniformAtlas, 0);
+    glActiveTexture(GL_TEXTURE0);
+
+    for (auto &batch : mBatches) {
+        int count = (int) batch.positions.size() / 2;
+        if (count == 0)
+            continue;
+        batch.font->bindTexture();
+        mShader->setUniform(mUniformAtlasSize, Vector2f(batch.font->atlasSize().cast<float>()));
+        mShader->streamAttrib("position", Eigen::Map<MatrixXf>(batch.positions.data(), 2, count));
+        mShader->streamAttrib("texcoord", Eigen::Map<MatrixXf>(batch.texcoords.data(), 2, count));
+        mShader->streamAttrib("color", Eigen::Map<MatrixXf>(batch.colors.data(), 4, count));
+        mShader->streamAttrib("clip", Eigen::Map<MatrixXf>(batch.clips.data(), 4, count));
+        mShader->drawArray(GL_TRIANGLES, 0, count);
+    }
+
+    mBatches.clear();
+}
+
+NAMESPACE_END(nanogui)
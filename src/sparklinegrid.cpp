@@ -0,0 +1,271 @@
+/*
+    src/sparklinegrid.cpp -- Grid of many small graphs that are drawn
+    with a constant number of draw calls
+
+    NanoGUI was developed by Wenzel Jakob <wenzel.jakob@epfl.ch>.
+    The widget drawing code is based on the NanoVG demo application
+    by Mikko Mononen.
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+
+#include <nanogui/sparklinegrid.h>
+#include <nanogui/screen.h>
+#include <nanogui/theme.h>
+#include <nanogui/opengl.h>
+#include <nanogui/glutil.h>
+
+NAMESPACE_BEGIN(nanogui)
+
+SparklineGrid::SparklineGrid(Widget *parent, int columns)
+    : Widget(parent), mColumns(std::max(columns, 1)), mCellSize(120, 36), mSpacing(4),
+      mGeometryDirty(true), mUploadDirty(true), mRenderDirty(true), mGpuFailed(false),
+      mShader(nullptr), mTarget(new GLRenderTexture()) {
+    mBackgroundColor = Color(20, 128);
+    mForegroundColor = Color(255, 192, 0, 255);
+    mTextColor = Color(240, 192);
+}
+
+SparklineGrid::~SparklineGrid() {
+    Screen *screen = this->screen();
+    mTarget->free(screen ? screen->nvgContext() : nullptr);
+    delete mTarget;
+    if (mShader) {
+        mShader->free();
+        delete mShader;
+    }
+}
+
+int SparklineGrid::addSparkline(const std::string &caption, const VectorXf &values) {
+    Cell cell;
+    cell.caption = caption;
+    cell.values = values;
+    mCells.push_back(cell);
+    mGeometryDirty = true;
+    return (int) mCells.size() - 1;
+}
+
+Vector2i SparklineGrid::preferredSize(NVGcontext *) const {
+    int rows = ((int) mCells.size() + mColumns - 1) / mColumns;
+    return Vector2i(mColumns * (mCellSize.x() + mSpacing) - mSpacing,
+                    std::max(rows * (mCellSize.y() + mSpacing) - mSpacing, 0));
+}
+
+void SparklineGrid::updateGeometry() {
+    Eigen::Index total = 0;
+    for (const Cell &cell : mCells)
+        total += cell.values.size() >= 2 ? cell.values.size() : 0;
+
+    mGeometry.resize(3, total);
+    mFirst.clear();
+    mCount.clear();
+
+    Eigen::Index offset = 0;
+    for (size_t i = 0; i < mCells.size(); ++i) {
+        const VectorXf &values = mCells[i].values;
+        Eigen::Index n = values.size();
+        if (n < 2)
+            continue;
+        float vMin = values.minCoeff(), vMax = values.maxCoeff();
+        float scale = vMax > vMin ? 1.f / (vMax - vMin) : 0.f;
+        auto block = mGeometry.middleCols(offset, n);
+        block.row(0) = VectorXf::LinSpaced(n, 0.f, 1.f).transpose();
+        if (vMax > vMin)
+            block.row(1) = ((values.array() - vMin) * scale).matrix().transpose();
+        else
+            block.row(1).setConstant(0.5f);
+        block.row(2).setConstant((float) i);
+        mFirst.push_back((int) offset);
+        mCount.push_back((int) n);
+        offset += n;
+    }
+
+    mGeometryDirty = false;
+    mUploadDirty = mRenderDirty = true;
+}
+
+bool SparklineGrid::drawLinesGpu(NVGcontext *ctx) {
+    Screen *screen = this->screen();
+    if (!mShader) {
+        /* All grids of a screen draw with the same program */
+        const GLShader *program = screen ? screen->sharedShader(
+            "sparkline_shader",
+
+            /* Vertex shader: the cell index selects the rectangle that
+               the normalized sample is mapped into */
+            "#version 330\n"
+            "uniform int columns;\n"
+            "uniform vec2 cellSize;\n"
+            "uniform float spacing;\n"
+            "uniform vec2 size;\n"
+            "in vec3 point;\n"
+            "void main() {\n"
+            "    int cell = int(point.z);\n"
+            "    vec2 origin = vec2(cell % columns, cell / columns) * (cellSize + spacing);\n"
+            "    vec2 p = origin + 2.0 + vec2(point.x, 1.0 - point.y) * (cellSize - 4.0);\n"
+            "    gl_Position = vec4(2.0 * p.x / size.x - 1.0, 1.0 - 2.0 * p.y / size.y, 0.0, 1.0);\n"
+            "}",
+
+            /* Fragment shader */
+            "#version 330\n"
+            "uniform vec4 color;\n"
+            "out vec4 outColor;\n"
+            "void main() {\n"
+            "    outColor = vec4(color.rgb * color.a, color.a);\n"
+            "}"
+        ) : nullptr;
+        if (!program) {
+            mGpuFailed = true;
+            return false;
+        }
+        mShader = new GLShader();
+        mShader->initShared(*program);
+        mUniformColumns = mShader->uniformHandle("columns");
+        mUniformCellSize = mShader->uniformHandle("cellSize");
+        mUniformSpacing = mShader->uniformHandle("spacing");
+        mUniformSize = mShader->uniformHandle("size");
+        mUniformColor = mShader->uniformHandle("color");
+        mUploadDirty = true;
+    }
+
+    if (mUploadDirty && mGeometry.cols() > 0) {
+        mShader->bind();
+        mShader->uploadAttrib("point", mGeometry);
+        mUploadDirty = false;
+    }
+
+    float pixelRatio = screen ? screen->pixelRatio() : 1.f;
+    Vector2i size = (mSize.cast<float>() * pixelRatio).cast<int>();
+    if (size.minCoeff() <= 0)
+        return true;
+
+    if (mTarget->resize(ctx, size, NVG_IMAGE_FLIPY | NVG_IMAGE_PREMULTIPLIED))
+        mRenderDirty = true;
+
+    if (mRenderDirty) {
+        mTarget->bind();
+        glClearColor(0.f, 0.f, 0.f, 0.f);
+        glClear(GL_COLOR_BUFFER_BIT);
+        glDisable(GL_DEPTH_TEST);
+        glDisable(GL_SCISSOR_TEST);
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+        if (!mFirst.empty()) {
+            mShader->bind();
+            mShader->setUniform(mUniformColumns, mColumns);
+            mShader->setUniform(mUniformCellSize, mCellSize.cast<float>().eval());
+            mShader->setUniform(mUniformSpacing, (float) mSpacing);
+            mShader->setUniform(mUniformSize, mSize.cast<float>().eval());
+            mShader->setUniform(mUniformColor, Vector4f(mForegroundColor));
+            /* All sparklines in a single call */
+            glMultiDrawArrays(GL_LINE_STRIP, mFirst.data(), mCount.data(), (GLsizei) mFirst.size());
+        }
+
+        mTarget->release();
+        mRenderDirty = false;
+    }
+
+    NVGpaint paint = nvgImagePattern(ctx, mPos.x(), mPos.y(), mSize.x(),
+                                     mSize.y(), 0, mTarget->image(), 1.f);
+    nvgBeginPath(ctx);
+    nvgRect(ctx, mPos.x(), mPos.y(), mSize.x(), mSize.y());
+    nvgFillPaint(ctx, paint);
+    nvgFill(ctx);
+    return true;
+}
+
+void SparklineGrid::drawLines(NVGcontext *ctx) {
+    /* Fallback: a single path with one subpath per cell */
+    Vector2f inner = mCellSize.cast<float>() - Vector2f::Constant(4.f);
+    nvgBeginPath(ctx);
+    for (size_t i = 0; i < mFirst.size(); ++i) {
+        for (int j = 0; j < mCount[i]; ++j) {
+            auto sample = mGeometry.col(mFirst[i] + j);
+            Vector2f origin = cellOrigin((int) sample.z());
+            float px = mPos.x() + origin.x() + 2.f + sample.x() * inner.x();
+            float py = mPos.y() + origin.y() + 2.f + (1.f - sample.y()) * inner.y();
+            if (j == 0)
+                nvgMoveTo(ctx, px, py);
+            else
+                nvgLineTo(ctx, px, py);
+        }
+    }
+    nvgStrokeColor(ctx, mForegroundColor);
+    nvgStroke(ctx);
+}
+
+void SparklineGrid::drawCaptions(NVGcontext *ctx) {
+    SdfFont *sdfFont = mTheme->mSdfText ? mTheme->sdfFont("sans") : nullptr;
+    Screen *screen = sdfFont ? this->screen() : nullptr;
+    const float fontSize = 13.f;
+
+    if (screen) {
+        /* Clip every caption against its cell and the visible area of all parent widgets */
+        Vector4f visible = visibleArea();
+        Vector2f base = absolutePosition().cast<float>();
+        SdfTextRenderer *renderer = screen->sdfText();
+        for (size_t i = 0; i < mCells.size(); ++i) {
+            if (mCells[i].caption.empty())
+                continue;
+            Vector2f origin = cellOrigin((int) i);
+            Vector2f cellMin = base + origin, cellMax = cellMin + mCellSize.cast<float>();
+            Vector4f clip(std::max(cellMin.x(), visible.x()), std::max(cellMin.y(), visible.y()),
+                          std::min(cellMax.x(), visible.z()), std::min(cellMax.y(), visible.w()));
+            renderer->text(ctx, sdfFont, mPos.x() + origin.x() + 3, mPos.y() + origin.y() + 1,
+                           fontSize, NVG_ALIGN_LEFT | NVG_ALIGN_TOP, mTextColor,
+                           mCells[i].caption, clip);
+        }
+        return;
+    }
+
+    /* Font state is set once for all captions */
+    nvgSave(ctx);
+    nvgIntersectScissor(ctx, mPos.x(), mPos.y(), mSize.x(), mSize.y());
+    nvgFontFace(ctx, "sans");
+    nvgFontSize(ctx, fontSize);
+    nvgTextAlign(ctx, NVG_ALIGN_LEFT | NVG_ALIGN_TOP);
+    nvgFillColor(ctx, mTextColor);
+    for (size_t i = 0; i < mCells.size(); ++i) {
+        if (mCells[i].caption.empty())
+            continue;
+        Vector2f origin = cellOrigin((int) i);
+        nvgText(ctx, mPos.x() + origin.x() + 3, mPos.y() + origin.y() + 1,
+                mCells[i].caption.c_str(), nullptr);
+    }
+    nvgRestore(ctx);
+}
+
+void SparklineGrid::draw(NVGcontext *ctx) {
+    Widget::draw(ctx);
+    if (mCells.empty())
+        return;
+    if (mGeometryDirty)
+        updateGeometry();
+
+    /* Backgrounds and borders of all cells, as one path each */
+    nvgBeginPath(ctx);
+    for (size_t i = 0; i < mCells.size(); ++i) {
+        Vector2f origin = cellOrigin((int) i);
+        nvgRect(ctx, mPos.x() + origin.x(), mPos.y() + origin.y(), mCellSize.x(), mCellSize.y());
+    }
+    nvgFillColor(ctx, mBackgroundColor);
+    nvgFill(ctx);
+
+    if (mGpuFailed || !drawLinesGpu(ctx))
+        drawLines(ctx);
+
+    nvgBeginPath(ctx);
+    for (size_t i = 0; i < mCells.size(); ++i) {
+        Vector2f origin = cellOrigin((int) i);
+        nvgRect(ctx, mPos.x() + origin.x() + 0.5f, mPos.y() + origin.y() + 0.5f,
+                mCellSize.x() - 1.f, mCellSize.y() - 1.f);
+    }
+    nvgStrokeColor(ctx, Color(100, 255));
+    nvgStroke(ctx);
+
+    drawCaptions(ctx);
+}
+
+NAMESPACE_END(nanogui)
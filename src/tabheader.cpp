@@ -404,47 +404,34 @@ void TabHeader::drawControls(NVGcontext* ctx) {
     bool active = mVisibleStart != 0;
 
     // Draw the arrow.
-    nvgBeginPath(ctx);
-    auto iconLeft = utf8(ENTYPO_ICON_LEFT_BOLD);
     int fontSize = mFontSize == -1 ? mTheme->mButtonFontSize : mFontSize;
     float ih = fontSize;
     ih *= 1.5f;
-    nvgFontSize(ctx, ih);
-    nvgFontFace(ctx, "icons");
-    NVGcolor arrowColor;
+    Color arrowColor;
     if (active)
         arrowColor = mTheme->mTextColor;
     else
         arrowColor = mTheme->mButtonGradientBotPushed;
-    nvgFillColor(ctx, arrowColor);
-    nvgTextAlign(ctx, NVG_ALIGN_LEFT | NVG_ALIGN_MIDDLE);
     float yScaleLeft = 0.5f;
     float xScaleLeft = 0.2f;
     Vector2f leftIconPos = mPos.cast<float>() + Vector2f(xScaleLeft*theme()->mTabControlWidth, yScaleLeft*mSize.cast<float>().y());
-    nvgText(ctx, leftIconPos.x(), leftIconPos.y() + 1, iconLeft.data(), nullptr);
+    drawIcon(ctx, ENTYPO_ICON_LEFT_BOLD, leftIconPos.x(), leftIconPos.y() + 1, ih,
+             NVG_ALIGN_LEFT | NVG_ALIGN_MIDDLE, arrowColor);
 
     // Right button.
     active = mVisibleEnd != tabCount();
     // Draw the arrow.
-    nvgBeginPath(ctx);
-    auto iconRight = utf8(ENTYPO_ICON_RIGHT_BOLD);
-    fontSize = mFontSize == -1 ? mTheme->mButtonFontSize : mFontSize;
-    ih = fontSize;
-    ih *= 1.5f;
-    nvgFontSize(ctx, ih);
-    nvgFontFace(ctx, "icons");
-    float rightWidth = nvgTextBounds(ctx, 0, 0, iconRight.data(), nullptr, nullptr);
+    float rightWidth = iconWidth(ctx, ENTYPO_ICON_RIGHT_BOLD, ih);
     if (active)
         arrowColor = mTheme->mTextColor;
     else
         arrowColor = mTheme->mButtonGradientBotPushed;
-    nvgFillColor(ctx, arrowColor);
-    nvgTextAlign(ctx, NVG_ALIGN_LEFT | NVG_ALIGN_MIDDLE);
     float yScaleRight = 0.5f;
     float xScaleRight = 1.0f - xScaleLeft - rightWidth / theme()->mTabControlWidth;
     auto leftControlsPos = mPos.cast<float>() + Vector2f(mSize.cast<float>().x() - theme()->mTabControlWidth, 0);
     Vector2f rightIconPos = leftControlsPos + Vector2f(xScaleRight*theme()->mTabControlWidth, yScaleRight*mSize.cast<float>().y());
-    nvgText(ctx, rightIconPos.x(), rightIconPos.y() + 1, iconRight.data(), nullptr);
+    drawIcon(ctx, ENTYPO_ICON_RIGHT_BOLD, rightIconPos.x(), rightIconPos.y() + 1, ih,
+             NVG_ALIGN_LEFT | NVG_ALIGN_MIDDLE, arrowColor);
 }
 
 TabHeader::ClickLocation TabHeader::locateClick(const Vector2i& p) {
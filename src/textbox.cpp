@@ -33,6 +33,7 @@ TextBox::TextBox(Widget *parent,const std::string &value)
       mAlignment(Alignment::Center),
       mUnits(""),
       mFormat(""),
+      mFormatCheck(FormatCheck::None),
       mUnitsImage(-1),
       mValidFormat(true),
       mValueTemp(value),
@@ -149,27 +150,24 @@ void TextBox::draw(NVGcontext* ctx) {
     if (mSpinnable && !focused()) {
         spinArrowsWidth = 14.f;
     
-        nvgFontFace(ctx, "icons");
-        nvgFontSize(ctx, ((mFontSize < 0) ? mTheme->mButtonFontSize : mFontSize) * 1.2f);
+        float iconSize = ((mFontSize < 0) ? mTheme->mButtonFontSize : mFontSize) * 1.2f;
 
         bool spinning = mMouseDownPos.x() != -1;
         {
             bool hover = mMouseFocus && spinArea(mMousePos) == SpinArea::Top;
-            nvgFillColor(ctx, (mEnabled && (hover || spinning)) ? mTheme->mTextColor : mTheme->mDisabledTextColor);
-            auto icon = utf8(ENTYPO_ICON_CHEVRON_UP);
-            nvgTextAlign(ctx, NVG_ALIGN_LEFT | NVG_ALIGN_MIDDLE);
             Vector2f iconPos(mPos.x() + 4.f,
                              mPos.y() + mSize.y()/2.f - xSpacing/2.f);
-            nvgText(ctx, iconPos.x(), iconPos.y(), icon.data(), nullptr);
+            drawIcon(ctx, ENTYPO_ICON_CHEVRON_UP, iconPos.x(), iconPos.y(), iconSize,
+                     NVG_ALIGN_LEFT | NVG_ALIGN_MIDDLE,
+                     (mEnabled && (hover || spinning)) ? mTheme->mTextColor : mTheme->mDisabledTextColor);
         }
         {
             bool hover = mMouseFocus && spinArea(mMousePos) == SpinArea::Bottom;
-            nvgFillColor(ctx, (mEnabled && (hover || spinning)) ? mTheme->mTextColor : mTheme->mDisabledTextColor);
-            auto icon = utf8(ENTYPO_ICON_CHEVRON_DOWN);
-            nvgTextAlign(ctx, NVG_ALIGN_LEFT | NVG_ALIGN_MIDDLE);
             Vector2f iconPos(mPos.x() + 4.f,
                              mPos.y() + mSize.y()/2.f + xSpacing/2.f + 1.5f);
-            nvgText(ctx, iconPos.x(), iconPos.y(), icon.data(), nullptr);
+            drawIcon(ctx, ENTYPO_ICON_CHEVRON_DOWN, iconPos.x(), iconPos.y(), iconSize,
+                     NVG_ALIGN_LEFT | NVG_ALIGN_MIDDLE,
+                     (mEnabled && (hover || spinning)) ? mTheme->mTextColor : mTheme->mDisabledTextColor);
         }
 
         nvgFontSize(ctx, fontSize());
@@ -490,11 +488,81 @@ bool TextBox::keyboardCharacterEvent(unsigned int codepoint) {
     return false;
 }
 
+/* Equivalent to the regular expression [-]?[0-9]* (or [0-9]*) */
+static bool isInteger(const std::string &input, bool allowSign) {
+    size_t i = 0;
+    if (allowSign && i < input.size() && input[i] == '-')
+        ++i;
+    for (; i < input.size(); ++i) {
+        if (input[i] < '0' || input[i] > '9')
+            return false;
+    }
+    return true;
+}
+
+/* Equivalent to the regular expression [-+]?[0-9]*\.?[0-9]+([eE][-+]?[0-9]+)? */
+static bool isFloat(const std::string &input) {
+    size_t i = 0, n = input.size();
+    auto digits = [&]() {
+        size_t start = i;
+        while (i < n && input[i] >= '0' && input[i] <= '9')
+            ++i;
+        return i - start;
+    };
+
+    if (i < n && (input[i] == '-' || input[i] == '+'))
+        ++i;
+    size_t mantissa = digits();
+    if (i < n && input[i] == '.') {
+        ++i;
+        mantissa = digits();
+    }
+    if (mantissa == 0)
+        return false;
+    if (i < n && (input[i] == 'e' || input[i] == 'E')) {
+        ++i;
+        if (i < n && (input[i] == '-' || input[i] == '+'))
+            ++i;
+        if (digits() == 0)
+            return false;
+    }
+    return i == n;
+}
+
+void TextBox::setFormat(const std::string &format) {
+    mFormat = format;
+    mFormatRegex = std::regex();
+    if (format.empty())
+        mFormatCheck = FormatCheck::None;
+    else if (format == "[-]?[0-9]*")
+        mFormatCheck = FormatCheck::Integer;
+    else if (format == "[0-9]*")
+        mFormatCheck = FormatCheck::UnsignedInteger;
+    else if (format == "[-+]?[0-9]*\\.?[0-9]+([eE][-+]?[0-9]+)?")
+        mFormatCheck = FormatCheck::Float;
+    else {
+        mFormatCheck = FormatCheck::Regex;
+        mFormatRegex = std::regex(format, std::regex::ECMAScript | std::regex::optimize);
+    }
+}
+
 bool TextBox::checkFormat(const std::string &input, const std::string &format) {
+    if (mValidator)
+        return mValidator(input);
     if (format.empty())
         return true;
-    std::regex regex(format);
-    return regex_match(input, regex);
+    if (format != mFormat) {
+        std::regex regex(format);
+        return regex_match(input, regex);
+    }
+
+    switch (mFormatCheck) {
+        case FormatCheck::Integer: return isInteger(input, true);
+        case FormatCheck::UnsignedInteger: return isInteger(input, false);
+        case FormatCheck::Float: return isFloat(input);
+        case FormatCheck::Regex: return regex_match(input, mFormatRegex);
+        default: return true;
+    }
 }
 
 bool TextBox::copySelection() {
@@ -638,6 +706,7 @@ bool TextBox::load(Serializer &s) {
     if (!s.get("alignment", mAlignment)) return false;
     if (!s.get("units", mUnits)) return false;
     if (!s.get("format", mFormat)) return false;
+    setFormat(mFormat);
     if (!s.get("unitsImage", mUnitsImage)) return false;
     if (!s.get("validFormat", mValidFormat)) return false;
     if (!s.get("valueTemp", mValueTemp)) return false;
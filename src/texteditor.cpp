@@ -0,0 +1,719 @@
+/*
+    src/texteditor.cpp -- Multi-line text editor backed by a piece table
+
+    NanoGUI was developed by Wenzel Jakob <wenzel.jakob@epfl.ch>.
+    The widget drawing code is based on the NanoVG demo application
+    by Mikko Mononen.
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+
+#include <nanogui/texteditor.h>
+#include <nanogui/theme.h>
+#include <nanogui/screen.h>
+#include <nanogui/opengl.h>
+#include <nanogui/serializer/core.h>
+#include <algorithm>
+
+NAMESPACE_BEGIN(nanogui)
+
+NAMESPACE_BEGIN(detail)
+
+void PieceTable::reset(const std::string &text) {
+    mBuffers[0] = text;
+    mBuffers[1].clear();
+    mNewlines[0].clear();
+    mNewlines[1].clear();
+    for (size_t i = text.find('\n'); i != std::string::npos; i = text.find('\n', i + 1))
+        mNewlines[0].push_back(i);
+
+    mNodes.clear();
+    mNodes.push_back(Node());
+    mFreeNodes.clear();
+    mRoot = 0;
+    mSeed = 0x9E3779B9u;
+    if (!text.empty())
+        mRoot = newNode(Piece{ 0, 0, text.size() });
+}
+
+size_t PieceTable::countNewlines(const Piece &piece) const {
+    const std::vector<size_t> &newlines = mNewlines[piece.buffer];
+    auto begin = std::lower_bound(newlines.begin(), newlines.end(), piece.start);
+    auto end = std::lower_bound(begin, newlines.end(), piece.start + piece.length);
+    return (size_t) (end - begin);
+}
+
+int PieceTable::newNode(const Piece &piece) {
+    int index;
+    if (!mFreeNodes.empty()) {
+        index = mFreeNodes.back();
+        mFreeNodes.pop_back();
+    } else {
+        index = (int) mNodes.size();
+        mNodes.push_back(Node());
+    }
+
+    /* xorshift32 */
+    mSeed ^= mSeed << 13;
+    mSeed ^= mSeed >> 17;
+    mSeed ^= mSeed << 5;
+
+    Node &node = mNodes[index];
+    node.piece = piece;
+    node.newlines = countNewlines(piece);
+    node.priority = mSeed;
+    node.left = node.right = 0;
+    update(index);
+    return index;
+}
+
+void PieceTable::freeNodes(int node, std::vector<Piece> *pieces) {
+    if (!node)
+        return;
+    freeNodes(mNodes[node].left, pieces);
+    if (pieces)
+        pieces->push_back(mNodes[node].piece);
+    mFreeNodes.push_back(node);
+    freeNodes(mNodes[node].right, pieces);
+}
+
+void PieceTable::update(int node) {
+    Node &n = mNodes[node];
+    const Node &left = mNodes[n.left], &right = mNodes[n.right];
+    n.totalLength = left.totalLength + n.piece.length + right.totalLength;
+    n.totalNewlines = left.totalNewlines + n.newlines + right.totalNewlines;
+}
+
+int PieceTable::merge(int left, int right) {
+    if (!left || !right)
+        return left ? left : right;
+    if (mNodes[left].priority > mNodes[right].priority) {
+        int merged = merge(mNodes[left].right, right);
+        mNodes[left].right = merged;
+        update(left);
+        return left;
+    } else {
+        int merged = merge(left, mNodes[right].left);
+        mNodes[right].left = merged;
+        update(right);
+        return right;
+    }
+}
+
+void PieceTable::split(int node, size_t pos, int &left, int &right) {
+    if (!node) {
+        left = right = 0;
+        return;
+    }
+
+    size_t leftLength = mNodes[mNodes[node].left].totalLength,
+           length = mNodes[node].piece.length;
+    int a, b;
+
+    if (pos <= leftLength) {
+        split(mNodes[node].left, pos, a, b);
+        mNodes[node].left = b;
+        update(node);
+        left = a;
+        right = node;
+    } else if (pos >= leftLength + length) {
+        split(mNodes[node].right, pos - leftLength - length, a, b);
+        mNodes[node].right = a;
+        update(node);
+        left = node;
+        right = b;
+    } else {
+        /* The split position lies within this node's piece */
+        size_t offset = pos - leftLength;
+        Piece tail = mNodes[node].piece;
+        tail.start += offset;
+        tail.length -= offset;
+        int tailNode = newNode(tail);
+
+        Node &n = mNodes[node];
+        n.piece.length = offset;
+        n.newlines = countNewlines(n.piece);
+        int rest = n.right;
+        n.right = 0;
+        update(node);
+        left = node;
+        right = merge(tailNode, rest);
+    }
+}
+
+bool PieceTable::extendLast(int node, const Piece &piece) {
+    if (!node)
+        return false;
+    Node &n = mNodes[node];
+    bool extended;
+    if (n.right) {
+        extended = extendLast(n.right, piece);
+    } else {
+        extended = n.piece.buffer == piece.buffer &&
+                   n.piece.start + n.piece.length == piece.start;
+        if (extended) {
+            n.piece.length += piece.length;
+            n.newlines += countNewlines(piece);
+        }
+    }
+    if (extended)
+        update(node);
+    return extended;
+}
+
+size_t PieceTable::lineStart(size_t line) const {
+    if (line == 0)
+        return 0;
+
+    size_t k = line - 1, offset = 0;
+    int node = mRoot;
+    while (node) {
+        const Node &n = mNodes[node], &left = mNodes[n.left];
+        if (k < left.totalNewlines) {
+            node = n.left;
+            continue;
+        }
+        k -= left.totalNewlines;
+        offset += left.totalLength;
+        if (k < n.newlines) {
+            const std::vector<size_t> &newlines = mNewlines[n.piece.buffer];
+            auto it = std::lower_bound(newlines.begin(), newlines.end(), n.piece.start);
+            return offset + it[k] - n.piece.start + 1;
+        }
+        k -= n.newlines;
+        offset += n.piece.length;
+        node = n.right;
+    }
+    return size();
+}
+
+size_t PieceTable::lineEnd(size_t line) const {
+    return line + 1 < lineCount() ? lineStart(line + 1) - 1 : size();
+}
+
+size_t PieceTable::lineOf(size_t offset) const {
+    size_t line = 0;
+    int node = mRoot;
+    while (node) {
+        const Node &n = mNodes[node], &left = mNodes[n.left];
+        if (offset < left.totalLength) {
+            node = n.left;
+            continue;
+        }
+        line += left.totalNewlines;
+        offset -= left.totalLength;
+        if (offset < n.piece.length)
+            return line + countNewlines(Piece{ n.piece.buffer, n.piece.start, offset });
+        line += n.newlines;
+        offset -= n.piece.length;
+        node = n.right;
+    }
+    return line;
+}
+
+void PieceTable::collect(int node, size_t begin, size_t end, std::string &out) const {
+    if (!node || begin >= end)
+        return;
+    const Node &n = mNodes[node];
+    size_t pieceBegin = mNodes[n.left].totalLength,
+           pieceEnd = pieceBegin + n.piece.length;
+
+    if (begin < pieceBegin)
+        collect(n.left, begin, std::min(end, pieceBegin), out);
+    size_t b = std::max(begin, pieceBegin), e = std::min(end, pieceEnd);
+    if (b < e)
+        out.append(mBuffers[n.piece.buffer], n.piece.start + b - pieceBegin, e - b);
+    if (end > pieceEnd)
+        collect(n.right, std::max(begin, pieceEnd) - pieceEnd, end - pieceEnd, out);
+}
+
+std::string PieceTable::text(size_t pos, size_t length) const {
+    std::string result;
+    pos = std::min(pos, size());
+    length = std::min(length, size() - pos);
+    result.reserve(length);
+    collect(mRoot, pos, pos + length, result);
+    return result;
+}
+
+PieceTable::Piece PieceTable::insert(size_t pos, const std::string &text) {
+    Piece piece{ 1, mBuffers[1].size(), text.size() };
+    if (text.empty())
+        return piece;
+
+    for (size_t i = text.find('\n'); i != std::string::npos; i = text.find('\n', i + 1))
+        mNewlines[1].push_back(piece.start + i);
+    mBuffers[1] += text;
+
+    int left, right;
+    split(mRoot, std::min(pos, size()), left, right);
+    /* Consecutive typing extends the previous piece instead of adding nodes */
+    if (!extendLast(left, piece))
+        left = merge(left, newNode(piece));
+    mRoot = merge(left, right);
+    return piece;
+}
+
+void PieceTable::insert(size_t pos, const std::vector<Piece> &pieces) {
+    int left, right, middle = 0;
+    split(mRoot, std::min(pos, size()), left, right);
+    for (const Piece &piece : pieces) {
+        if (piece.length > 0) {
+            int node = newNode(piece);
+            middle = merge(middle, node);
+        }
+    }
+    mRoot = merge(merge(left, middle), right);
+}
+
+std::vector<PieceTable::Piece> PieceTable::erase(size_t pos, size_t length) {
+    std::vector<Piece> pieces;
+    pos = std::min(pos, size());
+    length = std::min(length, size() - pos);
+    if (length == 0)
+        return pieces;
+
+    int left, middle, right, rest;
+    split(mRoot, pos, left, rest);
+    split(rest, length, middle, right);
+    freeNodes(middle, &pieces);
+    mRoot = merge(left, right);
+    return pieces;
+}
+
+NAMESPACE_END(detail)
+
+TextEditor::TextEditor(Widget *parent, const std::string &value)
+    : Widget(parent), mEditable(true), mCursor(0), mAnchor(0),
+      mPreferredColumn((size_t) -1), mScrollX(0.f), mScrollY(0.f),
+      mScrollToCursor(false), mMouseDownPos(Vector2i::Constant(-1)),
+      mMouseDragPos(Vector2i::Constant(-1)), mMouseDownModifier(0) {
+    mBuffer.reset(value);
+}
+
+void TextEditor::setValue(const std::string &value) {
+    mBuffer.reset(value);
+    mUndo.clear();
+    mRedo.clear();
+    mCursor = mAnchor = 0;
+    mScrollX = mScrollY = 0.f;
+}
+
+void TextEditor::setCursor(size_t cursor) {
+    mCursor = mAnchor = std::min(cursor, mBuffer.size());
+    mPreferredColumn = (size_t) -1;
+    mScrollToCursor = true;
+}
+
+void TextEditor::changed() {
+    mScrollToCursor = true;
+    mPreferredColumn = (size_t) -1;
+    if (mCallback)
+        mCallback();
+}
+
+void TextEditor::insertText(const std::string &text) {
+    if (text.empty())
+        return;
+    deleteSelection();
+
+    size_t pos = mCursor;
+    detail::PieceTable::Piece piece = mBuffer.insert(pos, text);
+    mRedo.clear();
+
+    /* Merge with the previous record while the user keeps typing */
+    if (!mUndo.empty() && mUndo.back().insert &&
+        mUndo.back().pos + mUndo.back().length == pos &&
+        text.find('\n') == std::string::npos) {
+        Edit &last = mUndo.back();
+        detail::PieceTable::Piece &lastPiece = last.pieces.back();
+        if (lastPiece.buffer == piece.buffer &&
+            lastPiece.start + lastPiece.length == piece.start) {
+            lastPiece.length += piece.length;
+            last.length += piece.length;
+            mCursor = mAnchor = pos + text.size();
+            changed();
+            return;
+        }
+    }
+
+    mUndo.push_back(Edit{ true, pos, text.size(), { piece } });
+    mCursor = mAnchor = pos + text.size();
+    changed();
+}
+
+void TextEditor::eraseRange(size_t begin, size_t end) {
+    if (begin >= end)
+        return;
+    std::vector<detail::PieceTable::Piece> pieces = mBuffer.erase(begin, end - begin);
+    mRedo.clear();
+    mUndo.push_back(Edit{ false, begin, end - begin, std::move(pieces) });
+    mCursor = mAnchor = begin;
+    changed();
+}
+
+bool TextEditor::deleteSelection() {
+    if (mCursor == mAnchor)
+        return false;
+    auto range = selection();
+    eraseRange(range.first, range.second);
+    return true;
+}
+
+void TextEditor::undo() {
+    if (mUndo.empty())
+        return;
+    Edit edit = std::move(mUndo.back());
+    mUndo.pop_back();
+    if (edit.insert) {
+        mBuffer.erase(edit.pos, edit.length);
+        mCursor = mAnchor = edit.pos;
+    } else {
+        mBuffer.insert(edit.pos, edit.pieces);
+        mCursor = mAnchor = edit.pos + edit.length;
+    }
+    mRedo.push_back(std::move(edit));
+    changed();
+}
+
+void TextEditor::redo() {
+    if (mRedo.empty())
+        return;
+    Edit edit = std::move(mRedo.back());
+    mRedo.pop_back();
+    if (edit.insert) {
+        mBuffer.insert(edit.pos, edit.pieces);
+        mCursor = mAnchor = edit.pos + edit.length;
+    } else {
+        mBuffer.erase(edit.pos, edit.length);
+        mCursor = mAnchor = edit.pos;
+    }
+    mUndo.push_back(std::move(edit));
+    changed();
+}
+
+void TextEditor::copySelection() {
+    if (mCursor == mAnchor)
+        return;
+    Screen *sc = screen();
+    if (!sc)
+        return;
+    auto range = selection();
+    glfwSetClipboardString(sc->glfwWindow(),
+                           mBuffer.text(range.first, range.second - range.first).c_str());
+}
+
+void TextEditor::pasteFromClipboard() {
+    Screen *sc = screen();
+    if (!sc)
+        return;
+    const char *str = glfwGetClipboardString(sc->glfwWindow());
+    if (str)
+        insertText(str);
+}
+
+void TextEditor::moveCursor(size_t pos, bool select) {
+    mCursor = std::min(pos, mBuffer.size());
+    if (!select)
+        mAnchor = mCursor;
+    mScrollToCursor = true;
+}
+
+size_t TextEditor::prevChar(size_t pos) const {
+    /* Step over UTF-8 continuation bytes */
+    size_t begin = pos >= 4 ? pos - 4 : 0;
+    std::string str = mBuffer.text(begin, pos - begin);
+    size_t i = str.size();
+    while (i > 0 && (((uint8_t) str[--i]) & 0xC0) == 0x80)
+        ;
+    return begin + i;
+}
+
+size_t TextEditor::nextChar(size_t pos) const {
+    std::string str = mBuffer.text(pos, 4);
+    size_t i = 0;
+    if (i < str.size())
+        ++i;
+    while (i < str.size() && (((uint8_t) str[i]) & 0xC0) == 0x80)
+        ++i;
+    return pos + i;
+}
+
+size_t TextEditor::column(size_t pos) const {
+    size_t start = mBuffer.lineStart(mBuffer.lineOf(pos));
+    std::string str = mBuffer.text(start, pos - start);
+    size_t column = 0;
+    for (char c : str)
+        column += (((uint8_t) c) & 0xC0) != 0x80;
+    return column;
+}
+
+size_t TextEditor::offsetAtColumn(size_t line, size_t column) const {
+    size_t start = mBuffer.lineStart(line), end = mBuffer.lineEnd(line);
+    std::string str = mBuffer.text(start, end - start);
+    size_t i = 0;
+    for (; i < str.size(); ++i) {
+        if ((((uint8_t) str[i]) & 0xC0) != 0x80) {
+            if (column == 0)
+                break;
+            --column;
+        }
+    }
+    return start + i;
+}
+
+size_t TextEditor::offsetAt(NVGcontext *ctx, const Vector2i &p, float textX, float textY) {
+    float lineh = lineHeight();
+    float row = std::floor((p.y() - textY) / lineh);
+    size_t line = (size_t) std::min(std::max(row, 0.f), (float) (mBuffer.lineCount() - 1));
+    size_t start = mBuffer.lineStart(line), end = mBuffer.lineEnd(line);
+    std::string str = mBuffer.text(start, end - start);
+
+    std::vector<NVGglyphPosition> glyphs(str.size() + 1);
+    int nglyphs = nvgTextGlyphPositions(ctx, textX, 0, str.c_str(), str.c_str() + str.size(),
+                                        glyphs.data(), (int) glyphs.size());
+    for (int i = 0; i < nglyphs; ++i) {
+        if (p.x() < (glyphs[i].minx + glyphs[i].maxx) * 0.5f)
+            return start + (glyphs[i].str - str.c_str());
+    }
+    return end;
+}
+
+bool TextEditor::mouseButtonEvent(const Vector2i &p, int button, bool down, int modifiers) {
+    if (button != GLFW_MOUSE_BUTTON_1)
+        return Widget::mouseButtonEvent(p, button, down, modifiers);
+
+    if (down) {
+        if (!mFocused)
+            requestFocus();
+        /* Converted into a text offset in draw(), where the font metrics are available */
+        mMouseDownPos = p;
+        mMouseDownModifier = modifiers;
+    }
+    return true;
+}
+
+bool TextEditor::mouseDragEvent(const Vector2i &p, const Vector2i &, int, int) {
+    mMouseDragPos = p;
+    return true;
+}
+
+bool TextEditor::scrollEvent(const Vector2i &, const Vector2f &rel) {
+    mScrollY -= rel.y() * lineHeight() * 3;
+    mScrollX -= rel.x() * lineHeight() * 3;
+    return true;
+}
+
+bool TextEditor::keyboardEvent(int key, int /* scancode */, int action, int modifiers) {
+    if (!focused())
+        return false;
+    if (action != GLFW_PRESS && action != GLFW_REPEAT)
+        return true;
+
+    bool shift = modifiers & GLFW_MOD_SHIFT;
+    bool command = modifiers & SYSTEM_COMMAND_MOD;
+    size_t line = mBuffer.lineOf(mCursor);
+    size_t pageLines = (size_t) std::max(1.f, (mSize.y() - 8) / lineHeight() - 1);
+    bool vertical = key == GLFW_KEY_UP || key == GLFW_KEY_DOWN ||
+                    key == GLFW_KEY_PAGE_UP || key == GLFW_KEY_PAGE_DOWN;
+
+    if (vertical) {
+        /* Keep the column while moving across lines of different lengths */
+        if (mPreferredColumn == (size_t) -1)
+            mPreferredColumn = column(mCursor);
+        size_t target = line;
+        if (key == GLFW_KEY_UP)
+            target = line > 0 ? line - 1 : 0;
+        else if (key == GLFW_KEY_DOWN)
+            target = std::min(line + 1, mBuffer.lineCount() - 1);
+        else if (key == GLFW_KEY_PAGE_UP)
+            target = line > pageLines ? line - pageLines : 0;
+        else
+            target = std::min(line + pageLines, mBuffer.lineCount() - 1);
+        moveCursor(offsetAtColumn(target, mPreferredColumn), shift);
+        return true;
+    }
+
+    mPreferredColumn = (size_t) -1;
+
+    if (key == GLFW_KEY_LEFT) {
+        if (!shift && mCursor != mAnchor)
+            moveCursor(selection().first, false);
+        else
+            moveCursor(prevChar(mCursor), shift);
+    } else if (key == GLFW_KEY_RIGHT) {
+        if (!shift && mCursor != mAnchor)
+            moveCursor(selection().second, false);
+        else
+            moveCursor(nextChar(mCursor), shift);
+    } else if (key == GLFW_KEY_HOME) {
+        moveCursor(command ? 0 : mBuffer.lineStart(line), shift);
+    } else if (key == GLFW_KEY_END) {
+        moveCursor(command ? mBuffer.size() : mBuffer.lineEnd(line), shift);
+    } else if (key == GLFW_KEY_A && command) {
+        mAnchor = 0;
+        mCursor = mBuffer.size();
+    } else if (key == GLFW_KEY_C && command) {
+        copySelection();
+    } else if (mEditable) {
+        if (key == GLFW_KEY_BACKSPACE) {
+            if (!deleteSelection())
+                eraseRange(prevChar(mCursor), mCursor);
+        } else if (key == GLFW_KEY_DELETE) {
+            if (!deleteSelection())
+                eraseRange(mCursor, nextChar(mCursor));
+        } else if (key == GLFW_KEY_ENTER || key == GLFW_KEY_KP_ENTER) {
+            insertText("\n");
+        } else if (key == GLFW_KEY_TAB) {
+            insertText("    ");
+        } else if (key == GLFW_KEY_X && command) {
+            copySelection();
+            deleteSelection();
+        } else if (key == GLFW_KEY_V && command) {
+            pasteFromClipboard();
+        } else if (key == GLFW_KEY_Z && command) {
+            if (shift)
+                redo();
+            else
+                undo();
+        } else if (key == GLFW_KEY_Y && command) {
+            redo();
+        }
+    }
+
+    return true;
+}
+
+bool TextEditor::keyboardCharacterEvent(unsigned int codepoint) {
+    if (!mEditable || !focused())
+        return false;
+    insertText(utf8((int) codepoint).data());
+    return true;
+}
+
+Vector2i TextEditor::preferredSize(NVGcontext *) const {
+    return Vector2i(320, (int) (lineHeight() * 12) + 8);
+}
+
+void TextEditor::draw(NVGcontext *ctx) {
+    Widget::draw(ctx);
+
+    NVGpaint bg = nvgBoxGradient(ctx,
+        mPos.x() + 1, mPos.y() + 1 + 1.0f, mSize.x() - 2, mSize.y() - 2,
+        3, 4, Color(focused() ? 150 : 255, 32), Color(32, 32));
+    nvgBeginPath(ctx);
+    nvgRoundedRect(ctx, mPos.x() + 1, mPos.y() + 1 + 1.0f, mSize.x() - 2,
+                   mSize.y() - 2, 3);
+    nvgFillPaint(ctx, bg);
+    nvgFill(ctx);
+
+    nvgBeginPath(ctx);
+    nvgRoundedRect(ctx, mPos.x() + 0.5f, mPos.y() + 0.5f, mSize.x() - 1,
+                   mSize.y() - 1, 2.5f);
+    nvgStrokeColor(ctx, Color(0, 48));
+    nvgStroke(ctx);
+
+    const float margin = 4.f;
+    float lineh = lineHeight();
+    float viewX = mPos.x() + margin, viewY = mPos.y() + margin;
+    float viewW = mSize.x() - 2 * margin, viewH = mSize.y() - 2 * margin;
+    size_t lineCount = mBuffer.lineCount();
+
+    nvgSave(ctx);
+    nvgIntersectScissor(ctx, viewX, viewY, viewW, viewH);
+    nvgFontSize(ctx, fontSize());
+    nvgFontFace(ctx, "sans");
+    nvgTextAlign(ctx, NVG_ALIGN_LEFT | NVG_ALIGN_TOP);
+
+    /* Resolve pending mouse interaction now that font metrics are available */
+    if (mMouseDownPos.x() != -1) {
+        size_t offset = offsetAt(ctx, mMouseDownPos, viewX - mScrollX, viewY - mScrollY);
+        moveCursor(offset, mMouseDownModifier & GLFW_MOD_SHIFT);
+        mPreferredColumn = (size_t) -1;
+        mMouseDownPos = Vector2i::Constant(-1);
+    }
+    if (mMouseDragPos.x() != -1) {
+        moveCursor(offsetAt(ctx, mMouseDragPos, viewX - mScrollX, viewY - mScrollY), true);
+        mPreferredColumn = (size_t) -1;
+        mMouseDragPos = Vector2i::Constant(-1);
+    }
+
+    size_t cursorLine = mBuffer.lineOf(mCursor);
+    if (mScrollToCursor) {
+        float cursorY = cursorLine * lineh;
+        if (cursorY < mScrollY)
+            mScrollY = cursorY;
+        else if (cursorY + lineh > mScrollY + viewH)
+            mScrollY = cursorY + lineh - viewH;
+    }
+    mScrollY = std::max(0.f, std::min(mScrollY, lineCount * lineh - viewH));
+    mScrollX = std::max(0.f, mScrollX);
+
+    /* Caret position within the cursor's line (relative to the line start) */
+    size_t cursorStart = mBuffer.lineStart(cursorLine);
+    std::string cursorText = mBuffer.text(cursorStart, mCursor - cursorStart);
+    float caretX = nvgTextBounds(ctx, 0, 0, cursorText.c_str(), nullptr, nullptr);
+    if (mScrollToCursor) {
+        if (caretX < mScrollX)
+            mScrollX = caretX;
+        else if (caretX > mScrollX + viewW - 2)
+            mScrollX = caretX - viewW + 2;
+        mScrollToCursor = false;
+    }
+
+    float textX = viewX - mScrollX, textY = viewY - mScrollY;
+    size_t first = (size_t) (mScrollY / lineh);
+    size_t last = std::min(lineCount, (size_t) ((mScrollY + viewH) / lineh) + 1);
+    auto range = selection();
+
+    for (size_t line = first; line < last; ++line) {
+        size_t start = mBuffer.lineStart(line), end = mBuffer.lineEnd(line);
+        std::string str = mBuffer.text(start, end - start);
+        float y = textY + line * lineh;
+
+        if (range.first < range.second && range.first <= end && range.second > start) {
+            size_t selBegin = std::max(range.first, start), selEnd = std::min(range.second, end);
+            float x0 = nvgTextBounds(ctx, 0, 0, str.c_str(), str.c_str() + (selBegin - start), nullptr);
+            float x1 = nvgTextBounds(ctx, 0, 0, str.c_str(), str.c_str() + (selEnd - start), nullptr);
+            if (range.second > end)
+                x1 += lineh * 0.3f; /* Selected newline */
+            nvgBeginPath(ctx);
+            nvgFillColor(ctx, nvgRGBA(255, 255, 255, 80));
+            nvgRect(ctx, textX + x0, y, x1 - x0, lineh);
+            nvgFill(ctx);
+        }
+
+        nvgFillColor(ctx, mEnabled ? mTheme->mTextColor : mTheme->mDisabledTextColor);
+        nvgText(ctx, textX, y + (lineh - fontSize()) * 0.5f, str.c_str(), str.c_str() + str.size());
+    }
+
+    if (focused()) {
+        float y = textY + cursorLine * lineh;
+        nvgBeginPath(ctx);
+        nvgMoveTo(ctx, textX + caretX, y);
+        nvgLineTo(ctx, textX + caretX, y + lineh);
+        nvgStrokeColor(ctx, nvgRGBA(255, 192, 0, 255));
+        nvgStrokeWidth(ctx, 1.0f);
+        nvgStroke(ctx);
+    }
+
+    nvgRestore(ctx);
+}
+
+void TextEditor::save(Serializer &s) const {
+    Widget::save(s);
+    s.set("editable", mEditable);
+    s.set("value", mBuffer.str());
+}
+
+bool TextEditor::load(Serializer &s) {
+    if (!Widget::load(s)) return false;
+    if (!s.get("editable", mEditable)) return false;
+    std::string value;
+    if (!s.get("value", value)) return false;
+    setValue(value);
+    return true;
+}
+
+NAMESPACE_END(nanogui)
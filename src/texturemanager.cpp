@@ -0,0 +1,164 @@
+/*
+    src/texturemanager.cpp -- Per-screen cache of NanoVG images with a
+    GPU memory budget
+
+    NanoGUI was developed by Wenzel Jakob <wenzel.jakob@epfl.ch>.
+    The widget drawing code is based on the NanoVG demo application
+    by Mikko Mononen.
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+
+#include <nanogui/texturemanager.h>
+#include <nanogui/opengl.h>
+#include <iostream>
+
+NAMESPACE_BEGIN(nanogui)
+
+TextureManager::Image::Image(TextureManager *manager, const std::string &key,
+                             const Loader &loader, int flags)
+    : mManager(manager), mKey(key), mLoader(loader), mFlags(flags) { }
+
+TextureManager::Image::~Image() { }
+
+int TextureManager::Image::handle() {
+    if (!mManager)
+        return 0;
+    if (mHandle == 0 && !mFailed)
+        mManager->createTexture(this);
+    if (mHandle != 0) {
+        mFrame = mManager->mFrame;
+        auto &recent = mManager->mRecent;
+        recent.splice(recent.begin(), recent, mPosition);
+    }
+    return mHandle;
+}
+
+TextureManager::TextureManager(NVGcontext *ctx, size_t budget)
+    : mContext(ctx), mBudget(budget) { }
+
+TextureManager::~TextureManager() {
+    for (auto &kv : mImages) {
+        Image *image = kv.second.get();
+        if (image->mHandle)
+            nvgDeleteImage(mContext, image->mHandle);
+        image->mHandle = 0;
+        image->mManager = nullptr;
+    }
+}
+
+ref<TextureManager::Image> TextureManager::image(const std::string &key, const Loader &loader,
+                                                 int flags) {
+    auto it = mImages.find(key);
+    if (it != mImages.end())
+        return it->second;
+    if (mImages.size() >= mSweepThreshold) {
+        sweep();
+        mSweepThreshold = std::max(mImages.size() * 2, (size_t) 64);
+    }
+    ref<Image> image = new Image(this, key, loader, flags);
+    mImages[key] = image;
+    return image;
+}
+
+ref<TextureManager::Image> TextureManager::load(const std::string &filename, int flags) {
+    return image(filename, [filename, flags](NVGcontext *ctx) {
+        return nvgCreateImage(ctx, filename.c_str(), flags);
+    }, flags);
+}
+
+ref<TextureManager::Image> TextureManager::loadMemory(const std::string &name, const uint8_t *data,
+                                                      size_t size, int flags) {
+    return image(name, [data, size, flags](NVGcontext *ctx) {
+        return nvgCreateImageMem(ctx, flags, const_cast<uint8_t *>(data), (int) size);
+    }, flags);
+}
+
+TextureManager::Statistics TextureManager::statistics() const {
+    Statistics stats;
+    stats.images = mImages.size();
+    stats.residentImages = mRecent.size();
+    stats.residentBytes = mResidentBytes;
+    stats.loads = mLoads;
+    stats.evictions = mEvictions;
+    return stats;
+}
+
+void TextureManager::createTexture(Image *image) {
+    int handle = image->mLoader(mContext);
+    if (handle == 0) {
+        std::cerr << "TextureManager: could not load image \"" << image->mKey << "\"" << std::endl;
+        image->mFailed = true;
+        return;
+    }
+
+    int width = 0, height = 0;
+    nvgImageSize(mContext, handle, &width, &height);
+    size_t bytes = (size_t) width * height * 4;
+    if (image->mFlags & NVG_IMAGE_GENERATE_MIPMAPS)
+        bytes += bytes / 3;
+
+    image->mHandle = handle;
+    image->mSize = Vector2i(width, height);
+    image->mBytes = bytes;
+    image->mFrame = mFrame;
+    mRecent.push_front(image);
+    image->mPosition = mRecent.begin();
+    mResidentBytes += bytes;
+    mLoads++;
+
+    enforceBudget();
+}
+
+void TextureManager::evict(Image *image) {
+    nvgDeleteImage(mContext, image->mHandle);
+    image->mHandle = 0;
+    mResidentBytes -= image->mBytes;
+    mRecent.erase(image->mPosition);
+    mEvictions++;
+
+    /* Nobody but the manager refers to the image: forget it entirely, the
+       next request for its key starts over */
+    if (image->getRefCount() == 1) {
+        std::string key = image->mKey;
+        mImages.erase(key);
+    }
+}
+
+void TextureManager::evictUntil(size_t bytes) {
+    /* Images drawn in this frame may still be referenced by pending NanoVG
+       draw calls, and persistent ones by handles that were handed out */
+    std::vector<Image *> victims;
+    size_t resident = mResidentBytes;
+    for (auto it = mRecent.rbegin(); it != mRecent.rend() && resident > bytes; ++it) {
+        Image *image = *it;
+        if (image->mPersistent || image->mFrame == mFrame)
+            continue;
+        victims.push_back(image);
+        resident -= image->mBytes;
+    }
+    for (Image *image : victims)
+        evict(image);
+}
+
+void TextureManager::enforceBudget() {
+    if (mResidentBytes > mBudget)
+        evictUntil(mBudget);
+}
+
+void TextureManager::trim() {
+    evictUntil(0);
+    sweep();
+}
+
+void TextureManager::sweep() {
+    for (auto it = mImages.begin(); it != mImages.end(); ) {
+        if (it->second->mHandle == 0 && it->second->getRefCount() == 1)
+            it = mImages.erase(it);
+        else
+            ++it;
+    }
+}
+
+NAMESPACE_END(nanogui)
@@ -32,6 +32,8 @@ Theme::Theme(NVGcontext *ctx) {
     mTabControlWidth                  = 20;
     mTabButtonHorizontalPadding       = 10;
     mTabButtonVerticalPadding         = 2;
+    mGlyphPrewarmBudget               = 0.004;
+    mSdfText                          = false;
 
     mDropShadow                       = Color(0, 128);
     mTransparent                      = Color(0, 0);
@@ -72,6 +74,81 @@ Theme::Theme(NVGcontext *ctx) {
                                   entypo_ttf_size, 0);
     if (mFontNormal == -1 || mFontBold == -1 || mFontIcons == -1)
         throw std::runtime_error("Could not load fonts!");
+
+    /* Printable ASCII at the sizes used by the built-in widgets */
+    GlyphPrewarm prewarm;
+    prewarm.fonts = { "sans", "sans-bold" };
+    prewarm.sizes = { 14.f, 15.f, (float) mStandardFontSize, 18.f,
+                      (float) mButtonFontSize };
+    prewarm.ranges = { { 32, 126 } };
+    setGlyphPrewarm(prewarm);
+}
+
+void Theme::setGlyphPrewarm(const GlyphPrewarm &prewarm) {
+    mGlyphPrewarm = prewarm;
+    mPrewarmFont = mPrewarmSize = mPrewarmRange = 0;
+    mPrewarmCodepoint = -1;
+    if (mGlyphPrewarm.sizes.empty() || mGlyphPrewarm.ranges.empty())
+        mGlyphPrewarm.fonts.clear();
+}
+
+SdfFont *Theme::sdfFont(const std::string &face) {
+    if (face == "sans") {
+        if (!mSdfFontNormal)
+            mSdfFontNormal = new SdfFont(roboto_regular_ttf);
+        return mSdfFontNormal;
+    } else if (face == "sans-bold") {
+        if (!mSdfFontBold)
+            mSdfFontBold = new SdfFont(roboto_bold_ttf);
+        return mSdfFontBold;
+    } else if (face == "icons") {
+        if (!mSdfFontIcons)
+            mSdfFontIcons = new SdfFont(entypo_ttf);
+        return mSdfFontIcons;
+    }
+    return nullptr;
+}
+
+bool Theme::prewarmGlyphs(NVGcontext *ctx, double budget) {
+    if (!glyphPrewarmPending())
+        return true;
+
+    const int batchSize = 64;
+    double start = glfwGetTime();
+
+    nvgSave(ctx);
+    nvgTextAlign(ctx, NVG_ALIGN_LEFT | NVG_ALIGN_TOP);
+    nvgFillColor(ctx, Color(0, 0));
+
+    while (glyphPrewarmPending() && glfwGetTime() - start < budget) {
+        const std::pair<int, int> &range = mGlyphPrewarm.ranges[mPrewarmRange];
+        if (mPrewarmCodepoint < range.first)
+            mPrewarmCodepoint = range.first;
+
+        /* Render a batch of codepoints outside of the visible area: this is
+           sufficient for NanoVG to rasterize them into its glyph atlas */
+        std::string text;
+        for (int i = 0; i < batchSize && mPrewarmCodepoint <= range.second; ++i)
+            text += utf8(mPrewarmCodepoint++).data();
+
+        nvgFontFace(ctx, mGlyphPrewarm.fonts[mPrewarmFont].c_str());
+        nvgFontSize(ctx, mGlyphPrewarm.sizes[mPrewarmSize]);
+        nvgText(ctx, -1e4f, -1e4f, text.c_str(), nullptr);
+
+        if (mPrewarmCodepoint > range.second) {
+            mPrewarmCodepoint = -1;
+            if (++mPrewarmRange == mGlyphPrewarm.ranges.size()) {
+                mPrewarmRange = 0;
+                if (++mPrewarmSize == mGlyphPrewarm.sizes.size()) {
+                    mPrewarmSize = 0;
+                    ++mPrewarmFont;
+                }
+            }
+        }
+    }
+
+    nvgRestore(ctx);
+    return !glyphPrewarmPending();
 }
 
 NAMESPACE_END(nanogui)
@@ -0,0 +1,78 @@
+/*
+    src/threadpool.cpp -- Simple pool of worker threads for running
+    background jobs outside of the UI thread
+
+    NanoGUI was developed by Wenzel Jakob <wenzel.jakob@epfl.ch>.
+    The widget drawing code is based on the NanoVG demo application
+    by Mikko Mononen.
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+
+#include <nanogui/threadpool.h>
+#include <nanogui/opengl.h>
+#include <iostream>
+
+NAMESPACE_BEGIN(nanogui)
+
+ThreadPool::ThreadPool(size_t threadCount) : mShutdown(false) {
+    if (threadCount == 0)
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    for (size_t i = 0; i < threadCount; ++i)
+        mThreads.emplace_back([this] { worker(); });
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> guard(mMutex);
+        mShutdown = true;
+        mJobs.clear();
+    }
+    mCond.notify_all();
+    for (auto &thread : mThreads)
+        thread.join();
+}
+
+void ThreadPool::enqueue(const std::function<void()> &job) {
+    {
+        std::lock_guard<std::mutex> guard(mMutex);
+        mJobs.push_back(job);
+    }
+    mCond.notify_one();
+}
+
+size_t ThreadPool::pending() const {
+    std::lock_guard<std::mutex> guard(mMutex);
+    return mJobs.size();
+}
+
+void ThreadPool::worker() {
+    while (true) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mCond.wait(lock, [this] { return mShutdown || !mJobs.empty(); });
+            if (mShutdown)
+                return;
+            job = std::move(mJobs.front());
+            mJobs.pop_front();
+        }
+        try {
+            job();
+        } catch (const std::exception &e) {
+            std::cerr << "Caught exception in worker thread: " << e.what() << std::endl;
+        }
+    }
+}
+
+ThreadPool &ThreadPool::global() {
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::wakeup() {
+    glfwPostEmptyEvent();
+}
+
+NAMESPACE_END(nanogui)
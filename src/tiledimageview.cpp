@@ -0,0 +1,727 @@
+/*
+    src/tiledimageview.cpp -- Zoomable view of images that are too large
+    to be loaded into memory, streamed as tiles of a resolution pyramid
+
+    NanoGUI was developed by Wenzel Jakob <wenzel.jakob@epfl.ch>.
+    The widget drawing code is based on the NanoVG demo application
+    by Mikko Mononen.
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+
+#include <nanogui/tiledimageview.h>
+#include <nanogui/mappedfile.h>
+#include <nanogui/threadpool.h>
+#include <nanogui/screen.h>
+#include <nanogui/theme.h>
+#include <nanogui/opengl.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <mutex>
+
+#define NANOVG_GL3
+#include <nanovg_gl.h>
+
+NAMESPACE_BEGIN(nanogui)
+
+namespace {
+    const int TileMaxLevels = 32;
+
+    struct TileHeader {
+        char magic[8];
+        uint64_t sourceSize;
+        int64_t sourceTime;
+        int32_t width, height, tileSize, levels;
+        /// Byte offset of each level (level 0 is read from the image file)
+        uint64_t offset[TileMaxLevels];
+    };
+
+    const char TileMagic[8] = { 'N', 'G', 'T', 'I', 'L', 'E', 'S', '1' };
+
+    /* Limits of the view */
+    const double MaxScale = 64.0;
+    /* Magnification (in physical pixels) above which pixels are not interpolated */
+    const double NearestThreshold = 2.0;
+    /* Time constant of the zoom animation (in seconds) */
+    const double ZoomTimeConstant = 0.05;
+    /* Levels that need more tiles to cover the widget are not drawn */
+    const int64_t MaxVisibleTiles = 1024;
+
+    Vector2i levelSize(const Vector2i &size, int level) {
+        return Vector2i(((size.x() - 1) >> level) + 1, ((size.y() - 1) >> level) + 1);
+    }
+
+    uint64_t tileBytes(int tileSize) {
+        return (uint64_t) tileSize * tileSize * 4;
+    }
+
+    /// Fill in the level layout and return the size of the pyramid file
+    uint64_t tileLayout(const Vector2i &size, int tileSize, int levels, TileHeader &header) {
+        uint64_t offset = sizeof(TileHeader);
+        header.levels = levels;
+        header.offset[0] = 0;
+        for (int l = 1; l < levels; ++l) {
+            Vector2i tiles = (levelSize(size, l).array() + tileSize - 1) / tileSize;
+            header.offset[l] = offset;
+            offset += (uint64_t) tiles.x() * tiles.y() * tileBytes(tileSize);
+        }
+        return offset;
+    }
+
+    /// Pixel access for the image file (row-major) and for the tiled levels of the pyramid
+    struct LevelData {
+        const uint8_t *data;
+        Vector2i size;
+        int tileSize, tilesX;
+        bool tiled;
+
+        const uint8_t *pixel(int x, int y) const {
+            if (!tiled)
+                return data + ((uint64_t) y * size.x() + x) * 4;
+            uint64_t tile = (uint64_t) (y / tileSize) * tilesX + x / tileSize;
+            return data + tile * tileBytes(tileSize) +
+                   ((uint64_t) (y % tileSize) * tileSize + x % tileSize) * 4;
+        }
+    };
+
+    /// Replicate the last valid column and row of a tile into the rest of it
+    void padTile(uint8_t *rgba, int tileSize, int width, int height) {
+        for (int y = 0; y < height; ++y) {
+            uint8_t *row = rgba + (size_t) y * tileSize * 4;
+            for (int x = width; x < tileSize; ++x)
+                memcpy(row + x * 4, row + (width - 1) * 4, 4);
+        }
+        for (int y = height; y < tileSize; ++y)
+            memcpy(rgba + (size_t) y * tileSize * 4, rgba + (size_t) (height - 1) * tileSize * 4,
+                   (size_t) tileSize * 4);
+    }
+}
+
+NAMESPACE_BEGIN(detail)
+
+/// State shared between a \ref RawTileSource and the job building its pyramid
+struct TilePyramidBuild {
+    std::atomic<float> progress { 0.f };
+    std::atomic<bool> cancel { false };
+    std::atomic<bool> done { false };
+};
+
+/// State shared between a \ref TiledImageView and the jobs decoding its tiles
+struct TileRequests {
+    struct LoadedTile {
+        uint64_t key;
+        bool valid;
+        std::vector<uint8_t> pixels;
+    };
+
+    ref<TileSource> source;
+    std::atomic<bool> cancelled { false };
+    std::mutex mutex;
+    /// Tiles that should be decoded, most important last
+    std::vector<uint64_t> wanted;
+    /// Tiles that are being decoded or waiting for their upload
+    std::unordered_set<uint64_t> pending;
+    std::deque<LoadedTile> ready;
+    int jobs = 0;
+};
+
+NAMESPACE_END(detail)
+
+TileSource::TileSource(const Vector2i &size, int tileSize)
+    : mSize(size.cwiseMax(1)), mTileSize(std::max(tileSize, 1)), mLevelCount(1) {
+    while (mLevelCount < TileMaxLevels &&
+           (levelSize(mLevelCount - 1).array() > mTileSize).any())
+        mLevelCount++;
+}
+
+static void buildTilePyramid(const std::string &filename, const Vector2i &size, int tileSize,
+                             int levels, uint64_t sourceSize, int64_t sourceTime,
+                             const std::shared_ptr<detail::TilePyramidBuild> &build) {
+    std::string target = filename + ".tiles", temp = target + ".tmp";
+    bool complete = false;
+
+    try {
+        detail::MappedFile source(filename);
+
+        TileHeader header;
+        memset(&header, 0, sizeof(TileHeader));
+        uint64_t total = tileLayout(size, tileSize, levels, header);
+        memcpy(header.magic, TileMagic, sizeof(TileMagic));
+        header.sourceSize = sourceSize;
+        header.sourceTime = sourceTime;
+        header.width = size.x();
+        header.height = size.y();
+        header.tileSize = tileSize;
+
+        detail::MappedFile output(temp, total);
+        uint8_t *base = output.data();
+
+        uint64_t work = 0, done = 0;
+        for (int l = 1; l < levels; ++l)
+            work += (uint64_t) levelSize(size, l).prod();
+
+        /* Every level is reduced from the previous one with a 2x2 box filter.
+           Coordinates are clamped, so padding pixels repeat the image edge. */
+        LevelData prev { source.data(), size, tileSize, 0, false };
+        for (int l = 1; l < levels && !build->cancel; ++l) {
+            Vector2i cur = levelSize(size, l);
+            Vector2i tiles = (cur.array() + tileSize - 1) / tileSize;
+            uint8_t *data = base + header.offset[l];
+
+            for (int ty = 0; ty < tiles.y() && !build->cancel; ++ty) {
+                for (int tx = 0; tx < tiles.x(); ++tx) {
+                    uint8_t *out = data + ((uint64_t) ty * tiles.x() + tx) * tileBytes(tileSize);
+                    for (int py = 0; py < tileSize; ++py) {
+                        int y = std::min(ty * tileSize + py, cur.y() - 1);
+                        int y0 = std::min(2 * y, prev.size.y() - 1), y1 = std::min(2 * y + 1, prev.size.y() - 1);
+                        for (int px = 0; px < tileSize; ++px, out += 4) {
+                            int x = std::min(tx * tileSize + px, cur.x() - 1);
+                            int x0 = std::min(2 * x, prev.size.x() - 1), x1 = std::min(2 * x + 1, prev.size.x() - 1);
+                            const uint8_t *p00 = prev.pixel(x0, y0), *p01 = prev.pixel(x1, y0),
+                                          *p10 = prev.pixel(x0, y1), *p11 = prev.pixel(x1, y1);
+                            for (int c = 0; c < 4; ++c)
+                                out[c] = (uint8_t) ((p00[c] + p01[c] + p10[c] + p11[c] + 2) / 4);
+                        }
+                    }
+                }
+                done += (uint64_t) std::min(tileSize, cur.y() - ty * tileSize) * cur.x();
+                build->progress = 0.99f * (float) ((double) done / (double) work);
+            }
+
+            prev = LevelData { data, cur, tileSize, tiles.x(), true };
+        }
+
+        if (!build->cancel) {
+            /* The magic number is written last so that partial files are never accepted */
+            memcpy(base, &header, sizeof(TileHeader));
+            output.flush();
+            complete = true;
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "Could not build the tiles of \"" << filename << "\": " << e.what() << std::endl;
+    }
+
+    if (complete) {
+        std::remove(target.c_str());
+        complete = std::rename(temp.c_str(), target.c_str()) == 0;
+    }
+    if (!complete)
+        std::remove(temp.c_str());
+
+    build->progress = 1.f;
+    build->done = true;
+    ThreadPool::wakeup();
+}
+
+RawTileSource::RawTileSource(const std::string &filename, const Vector2i &size, int tileSize)
+    : TileSource(size, tileSize), mFilename(filename), mTimestamp(0), mFailed(false) {
+    uint64_t fileSize;
+    if (!detail::fileInfo(filename, fileSize, mTimestamp))
+        throw std::runtime_error("Could not open \"" + filename + "\"!");
+    mData.reset(new detail::MappedFile(filename));
+    if (mData->size() < (uint64_t) mSize.x() * mSize.y() * 4)
+        throw std::runtime_error("\"" + filename + "\" is smaller than the given image size!");
+
+    if (mLevelCount > 1 && !loadPyramid()) {
+        mBuild = std::make_shared<detail::TilePyramidBuild>();
+        std::shared_ptr<detail::TilePyramidBuild> build = mBuild;
+        Vector2i imageSize = mSize;
+        int tiles = mTileSize, levels = mLevelCount;
+        uint64_t sourceSize = mData->size();
+        int64_t timestamp = mTimestamp;
+        ThreadPool::global().enqueue([filename, imageSize, tiles, levels, sourceSize, timestamp, build] {
+            buildTilePyramid(filename, imageSize, tiles, levels, sourceSize, timestamp, build);
+        });
+    }
+}
+
+RawTileSource::~RawTileSource() {
+    if (mBuild)
+        mBuild->cancel = true;
+}
+
+float RawTileSource::progress() const {
+    if (mPyramid || mLevelCount == 1)
+        return 1.f;
+    return mBuild ? mBuild->progress.load() : 0.f;
+}
+
+bool RawTileSource::loadPyramid() {
+    std::unique_ptr<detail::MappedFile> pyramid;
+    try {
+        pyramid.reset(new detail::MappedFile(mFilename + ".tiles"));
+    } catch (const std::exception &) {
+        return false;
+    }
+
+    if (pyramid->size() < sizeof(TileHeader))
+        return false;
+
+    const TileHeader *header = (const TileHeader *) pyramid->data();
+    TileHeader expected;
+    if (memcmp(header->magic, TileMagic, sizeof(TileMagic)) != 0 ||
+        header->sourceSize != mData->size() || header->sourceTime != mTimestamp ||
+        header->width != mSize.x() || header->height != mSize.y() ||
+        header->tileSize != mTileSize || header->levels != mLevelCount ||
+        tileLayout(mSize, mTileSize, mLevelCount, expected) != pyramid->size())
+        return false;
+
+    mPyramid = std::move(pyramid);
+    return true;
+}
+
+bool RawTileSource::update() {
+    if (!mBuild || !mBuild->done)
+        return false;
+    mBuild.reset();
+    if (loadPyramid())
+        return true;
+    mFailed = true;
+    return false;
+}
+
+bool RawTileSource::readTile(int level, int x, int y, uint8_t *rgba) const {
+    Vector2i tiles = tileCount(level);
+    if (level < 0 || level >= mLevelCount || x < 0 || y < 0 || x >= tiles.x() || y >= tiles.y())
+        return false;
+
+    if (level == 0) {
+        /* Gather the rows of the tile from the image file */
+        int x0 = x * mTileSize, y0 = y * mTileSize;
+        int width = std::min(mTileSize, mSize.x() - x0), height = std::min(mTileSize, mSize.y() - y0);
+        for (int row = 0; row < height; ++row)
+            memcpy(rgba + (size_t) row * mTileSize * 4,
+                   mData->data() + ((uint64_t) (y0 + row) * mSize.x() + x0) * 4,
+                   (size_t) width * 4);
+        return true;
+    }
+
+    if (!mPyramid)
+        return false;
+    const TileHeader *header = (const TileHeader *) mPyramid->data();
+    memcpy(rgba, mPyramid->data() + header->offset[level] +
+                 ((uint64_t) y * tiles.x() + x) * tileBytes(mTileSize),
+           (size_t) tileBytes(mTileSize));
+    return true;
+}
+
+/// Decode the most important tile that is still wanted (runs on a worker thread)
+static void loadTile(const std::shared_ptr<detail::TileRequests> &requests) {
+    uint64_t key;
+    {
+        std::lock_guard<std::mutex> guard(requests->mutex);
+        if (requests->cancelled || requests->wanted.empty()) {
+            requests->jobs--;
+            return;
+        }
+        key = requests->wanted.back();
+        requests->wanted.pop_back();
+        requests->pending.insert(key);
+    }
+
+    const TileSource *source = requests->source.get();
+    int level = (int) (key >> 56), x = (int) ((key >> 28) & 0xFFFFFFF), y = (int) (key & 0xFFFFFFF);
+    int tileSize = source->tileSize();
+
+    detail::TileRequests::LoadedTile tile;
+    tile.key = key;
+    tile.valid = false;
+    tile.pixels.resize((size_t) tileBytes(tileSize));
+    try {
+        tile.valid = source->readTile(level, x, y, tile.pixels.data());
+    } catch (const std::exception &e) {
+        std::cerr << "Could not read tile (" << level << ", " << x << ", " << y
+                  << "): " << e.what() << std::endl;
+    }
+    if (tile.valid) {
+        Vector2i valid = (source->levelSize(level) - Vector2i(x, y) * tileSize).cwiseMin(tileSize);
+        padTile(tile.pixels.data(), tileSize, valid.x(), valid.y());
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(requests->mutex);
+        requests->ready.push_back(std::move(tile));
+        requests->jobs--;
+    }
+    ThreadPool::wakeup();
+}
+
+TiledImageView::TiledImageView(Widget *parent)
+    : Widget(parent), mScale(1.0), mOffset(Eigen::Vector2d::Zero()), mFitPending(false),
+      mZoomTarget(1.0), mZoomPivot(Vector2f::Zero()), mZoomTime(0.0), mGridThreshold(16.0),
+      mGridColor(0, 96), mCacheSize(256), mUploadBudget(0.004), mFrame(0) { }
+
+TiledImageView::~TiledImageView() {
+    if (mRequests)
+        mRequests->cancelled = true;
+    /* The tile images live in the NanoVG context of the screen (if it still exists) */
+    Screen *screen = this->screen();
+    if (screen) {
+        for (int image : mReleasedImages)
+            nvgDeleteImage(screen->nvgContext(), image);
+        for (const Tile &tile : mTiles)
+            nvgDeleteImage(screen->nvgContext(), tile.image);
+    }
+    for (const Tile &tile : mTiles)
+        glDeleteTextures(1, &tile.texture);
+}
+
+void TiledImageView::setSource(TileSource *source) {
+    if (mRequests) {
+        mRequests->cancelled = true;
+        mRequests.reset();
+    }
+    releaseTiles();
+    mFailedTiles.clear();
+    mSource = source;
+    mFitPending = true;
+    if (mSize.x() > 0 && mSize.y() > 0)
+        fit();
+}
+
+void TiledImageView::releaseTiles() {
+    /* The NanoVG handles are deleted in the next draw() */
+    for (const Tile &tile : mTiles) {
+        mReleasedImages.push_back(tile.image);
+        glDeleteTextures(1, &tile.texture);
+    }
+    mTiles.clear();
+    mTileIndex.clear();
+}
+
+double TiledImageView::fitScale() const {
+    if (!mSource)
+        return 1.0;
+    Eigen::Vector2d ratio = mSize.cast<double>().cwiseQuotient(mSource->size().cast<double>());
+    return std::max(ratio.minCoeff(), 1e-6);
+}
+
+void TiledImageView::fit() {
+    mFitPending = false;
+    mScale = mZoomTarget = std::min(fitScale(), MaxScale);
+    setOffset(Eigen::Vector2d::Zero());
+}
+
+void TiledImageView::setScale(double scale, const Vector2f &pivot) {
+    applyScale(scale, pivot);
+    mZoomTarget = mScale;
+}
+
+void TiledImageView::applyScale(double scale, const Vector2f &pivot) {
+    Eigen::Vector2d anchor = imageCoordinate(pivot);
+    double minScale = std::min(fitScale(), 1.0) * 0.5;
+    mScale = std::min(std::max(scale, minScale), MaxScale);
+    setOffset(anchor - pivot.cast<double>() / mScale);
+}
+
+void TiledImageView::setOffset(const Eigen::Vector2d &offset) {
+    mOffset = offset;
+    if (!mSource)
+        return;
+    /* Center images that are smaller than the widget, and otherwise keep the widget covered */
+    Eigen::Vector2d view = mSize.cast<double>() / mScale, image = mSource->size().cast<double>();
+    for (int i = 0; i < 2; ++i)
+        mOffset[i] = view[i] >= image[i] ? (image[i] - view[i]) * 0.5
+                                         : std::min(std::max(mOffset[i], 0.0), image[i] - view[i]);
+}
+
+bool TiledImageView::mouseDragEvent(const Vector2i &, const Vector2i &rel, int, int) {
+    if (!mSource)
+        return false;
+    setOffset(mOffset - rel.cast<double>() / mScale);
+    return true;
+}
+
+bool TiledImageView::scrollEvent(const Vector2i &p, const Vector2f &rel) {
+    if (!mSource)
+        return Widget::scrollEvent(p, rel);
+    /* Zoom around the cursor; draw() animates towards the target */
+    if (mZoomTarget == mScale)
+        mZoomTime = glfwGetTime();
+    double minScale = std::min(fitScale(), 1.0) * 0.5;
+    mZoomTarget = std::min(std::max(mZoomTarget * std::pow(1.2, (double) rel.y()), minScale), MaxScale);
+    mZoomPivot = (p - mPos).cast<float>();
+    return true;
+}
+
+void TiledImageView::animateZoom() {
+    if (mZoomTarget == mScale)
+        return;
+    double time = glfwGetTime();
+    double t = 1.0 - std::exp(-(time - mZoomTime) / ZoomTimeConstant);
+    mZoomTime = time;
+
+    double scale = std::exp(std::log(mScale) + (std::log(mZoomTarget) - std::log(mScale)) * t);
+    if (std::abs(std::log(scale / mZoomTarget)) < 1e-3)
+        scale = mZoomTarget;
+    applyScale(scale, mZoomPivot);
+    if (mScale != scale)
+        mZoomTarget = mScale;
+    else if (mScale != mZoomTarget)
+        ThreadPool::wakeup(); /* Continue in the next frame */
+}
+
+Vector4i TiledImageView::visibleTiles(int level) const {
+    double extent = std::ldexp((double) mSource->tileSize(), level);
+    Eigen::Vector2d begin = mOffset / extent,
+                    end = imageCoordinate(mSize.cast<float>()) / extent;
+    Vector2i count = mSource->tileCount(level);
+    Vector4i range;
+    for (int i = 0; i < 2; ++i) {
+        range[i] = (int) std::min(std::max(std::floor(begin[i]), 0.0), (double) count[i]);
+        range[i + 2] = (int) std::min(std::max(std::ceil(end[i]), (double) range[i]), (double) count[i]);
+    }
+    return range;
+}
+
+int TiledImageView::drawLevel() {
+    const Screen *screen = this->screen();
+    double ratio = screen ? screen->pixelRatio() : 1.0;
+    int level = (int) std::floor(std::log2(1.0 / (mScale * ratio)));
+    level = std::min(std::max(level, 0), mSource->levelCount() - 1);
+    while (level > 0 && !mSource->levelReady(level))
+        level--;
+    Vector4i tiles = visibleTiles(level);
+    if ((int64_t) (tiles.z() - tiles.x()) * (tiles.w() - tiles.y()) > MaxVisibleTiles)
+        return -1;
+    return level;
+}
+
+TiledImageView::Tile *TiledImageView::findTile(uint64_t key) {
+    auto it = mTileIndex.find(key);
+    if (it == mTileIndex.end())
+        return nullptr;
+    mTiles.splice(mTiles.begin(), mTiles, it->second);
+    Tile &tile = *it->second;
+    tile.frame = mFrame;
+    return &tile;
+}
+
+void TiledImageView::drawTile(NVGcontext *ctx, Tile &tile, int tileLevel, int tileX, int tileY,
+                              int level, int x, int y) {
+    const Screen *screen = this->screen();
+    double ratio = screen ? screen->pixelRatio() : 1.0;
+    bool nearest = mScale * ratio * std::ldexp(1.0, tileLevel) >= NearestThreshold;
+    if (tile.nearest != nearest) {
+        GLint filter = nearest ? GL_NEAREST : GL_LINEAR;
+        glBindTexture(GL_TEXTURE_2D, tile.texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+        tile.nearest = nearest;
+    }
+
+    double tileExtent = std::ldexp((double) mSource->tileSize(), tileLevel);
+    Vector2f origin = mPos.cast<float>() +
+        positionForCoordinate(Eigen::Vector2d(tileX, tileY) * tileExtent);
+    float size = (float) (tileExtent * mScale);
+
+    /* Area of the requested tile, clipped to the image */
+    double extent = std::ldexp((double) mSource->tileSize(), level);
+    Eigen::Vector2d a0 = Eigen::Vector2d(x, y) * extent,
+                    a1 = (a0.array() + extent).matrix().cwiseMin(mSource->size().cast<double>());
+    Vector2f p0 = mPos.cast<float>() + positionForCoordinate(a0),
+             p1 = mPos.cast<float>() + positionForCoordinate(a1);
+
+    NVGpaint paint = nvgImagePattern(ctx, origin.x(), origin.y(), size, size, 0, tile.image, 1.f);
+    nvgBeginPath(ctx);
+    nvgRect(ctx, p0.x(), p0.y(), p1.x() - p0.x(), p1.y() - p0.y());
+    nvgFillPaint(ctx, paint);
+    nvgFill(ctx);
+}
+
+void TiledImageView::drawGrid(NVGcontext *ctx) {
+    Eigen::Vector2d begin = mOffset.cwiseMax(0.0),
+                    end = imageCoordinate(mSize.cast<float>()).cwiseMin(mSource->size().cast<double>());
+    Vector2f p0 = mPos.cast<float>() + positionForCoordinate(begin),
+             p1 = mPos.cast<float>() + positionForCoordinate(end);
+
+    nvgBeginPath(ctx);
+    for (double x = std::ceil(begin.x()); x <= end.x(); x += 1.0) {
+        float px = mPos.x() + (float) ((x - mOffset.x()) * mScale);
+        nvgMoveTo(ctx, px, p0.y());
+        nvgLineTo(ctx, px, p1.y());
+    }
+    for (double y = std::ceil(begin.y()); y <= end.y(); y += 1.0) {
+        float py = mPos.y() + (float) ((y - mOffset.y()) * mScale);
+        nvgMoveTo(ctx, p0.x(), py);
+        nvgLineTo(ctx, p1.x(), py);
+    }
+    nvgStrokeWidth(ctx, 1.0f);
+    nvgStrokeColor(ctx, mGridColor);
+    nvgStroke(ctx);
+}
+
+void TiledImageView::requestTiles(const std::vector<uint64_t> &missing) {
+    if (!mRequests) {
+        mRequests = std::make_shared<detail::TileRequests>();
+        mRequests->source = mSource;
+    }
+
+    std::lock_guard<std::mutex> guard(mRequests->mutex);
+    /* Replace the previous requests, so that tiles which scrolled out of view are skipped */
+    std::vector<uint64_t> &wanted = mRequests->wanted;
+    wanted.clear();
+    for (auto it = missing.rbegin(); it != missing.rend(); ++it)
+        if (mRequests->pending.count(*it) == 0)
+            wanted.push_back(*it);
+
+    ThreadPool &pool = ThreadPool::global();
+    int maxJobs = (int) std::max(pool.size(), (size_t) 1) * 2;
+    std::shared_ptr<detail::TileRequests> requests = mRequests;
+    while (mRequests->jobs < std::min((int) wanted.size(), maxJobs)) {
+        mRequests->jobs++;
+        pool.enqueue([requests] { loadTile(requests); });
+    }
+}
+
+void TiledImageView::uploadTiles(NVGcontext *ctx) {
+    if (!mRequests)
+        return;
+
+    double start = glfwGetTime();
+    int tileSize = mSource->tileSize();
+    std::unique_lock<std::mutex> lock(mRequests->mutex);
+
+    while (!mRequests->ready.empty() && glfwGetTime() - start < mUploadBudget) {
+        detail::TileRequests::LoadedTile loaded = std::move(mRequests->ready.front());
+        mRequests->ready.pop_front();
+        mRequests->pending.erase(loaded.key);
+        if (!loaded.valid) {
+            mFailedTiles.insert(loaded.key);
+            continue;
+        }
+        if (mTileIndex.count(loaded.key))
+            continue;
+        lock.unlock();
+
+        GLuint texture;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, tileSize, tileSize, 0, GL_RGBA,
+                     GL_UNSIGNED_BYTE, loaded.pixels.data());
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+        Tile tile;
+        tile.key = loaded.key;
+        tile.texture = texture;
+        tile.image = nvglCreateImageFromHandleGL3(ctx, texture, tileSize, tileSize, NVG_IMAGE_NODELETE);
+        tile.nearest = false;
+        tile.frame = mFrame;
+        mTiles.push_front(tile);
+        mTileIndex[tile.key] = mTiles.begin();
+
+        lock.lock();
+    }
+
+    if (!mRequests->ready.empty())
+        ThreadPool::wakeup(); /* Continue in the next frame */
+}
+
+void TiledImageView::evictTiles(NVGcontext *ctx) {
+    /* Tiles drawn in this frame are kept even if the cache is too small */
+    while ((int) mTiles.size() > mCacheSize && mTiles.back().frame != mFrame) {
+        Tile &tile = mTiles.back();
+        nvgDeleteImage(ctx, tile.image);
+        glDeleteTextures(1, &tile.texture);
+        mTileIndex.erase(tile.key);
+        mTiles.pop_back();
+    }
+}
+
+void TiledImageView::draw(NVGcontext *ctx) {
+    for (int image : mReleasedImages)
+        nvgDeleteImage(ctx, image);
+    mReleasedImages.clear();
+    if (!mSource)
+        return;
+
+    mSource->update();
+    mFrame++;
+    if (mFitPending && mSize.x() > 0 && mSize.y() > 0)
+        fit();
+    animateZoom();
+    uploadTiles(ctx);
+
+    nvgSave(ctx);
+    nvgIntersectScissor(ctx, mPos.x(), mPos.y(), mSize.x(), mSize.y());
+
+    std::vector<uint64_t> missing;
+
+    /* The coarsest tiles are always kept, so that something can be shown immediately */
+    int coarsest = mSource->levelCount() - 1;
+    if (mSource->levelReady(coarsest)) {
+        Vector4i tiles = visibleTiles(coarsest);
+        for (int y = tiles.y(); y < tiles.w(); ++y)
+            for (int x = tiles.x(); x < tiles.z(); ++x) {
+                uint64_t key = tileKey(coarsest, x, y);
+                if (!findTile(key) && !mFailedTiles.count(key))
+                    missing.push_back(key);
+            }
+    }
+
+    int level = drawLevel();
+    if (level >= 0) {
+        Vector4i tiles = visibleTiles(level);
+        Eigen::Vector2d center = imageCoordinate(mSize.cast<float>() * 0.5f) /
+                                 std::ldexp((double) mSource->tileSize(), level);
+        std::vector<std::pair<double, uint64_t>> absent;
+
+        for (int y = tiles.y(); y < tiles.w(); ++y) {
+            for (int x = tiles.x(); x < tiles.z(); ++x) {
+                uint64_t key = tileKey(level, x, y);
+                if (Tile *tile = findTile(key)) {
+                    drawTile(ctx, *tile, level, x, y, level, x, y);
+                    continue;
+                }
+                if (!mFailedTiles.count(key))
+                    absent.push_back(std::make_pair(
+                        (Eigen::Vector2d(x + 0.5, y + 0.5) - center).squaredNorm(), key));
+
+                /* Show the matching part of the finest cached ancestor in the meantime */
+                for (int l = level + 1; l <= coarsest; ++l) {
+                    int d = l - level;
+                    if (Tile *parent = findTile(tileKey(l, x >> d, y >> d))) {
+                        drawTile(ctx, *parent, l, x >> d, y >> d, level, x, y);
+                        break;
+                    }
+                }
+            }
+        }
+
+        std::sort(absent.begin(), absent.end());
+        for (const auto &item : absent)
+            missing.push_back(item.second);
+    }
+
+    if (mGridThreshold > 0 && mScale >= mGridThreshold)
+        drawGrid(ctx);
+    nvgRestore(ctx);
+
+    requestTiles(missing);
+    evictTiles(ctx);
+
+    if (!mSource->levelReady(coarsest)) {
+        char text[32];
+        if (mSource->failed())
+            snprintf(text, sizeof(text), "Could not build tiles");
+        else
+            snprintf(text, sizeof(text), "Building tiles %i%%", (int) (mSource->progress() * 100));
+        nvgFontFace(ctx, "sans");
+        nvgFontSize(ctx, 14.0f);
+        nvgTextAlign(ctx, NVG_ALIGN_LEFT | NVG_ALIGN_BOTTOM);
+        nvgFillColor(ctx, mTheme->mTextColor);
+        nvgText(ctx, mPos.x() + 3, mPos.y() + mSize.y() - 1, text, NULL);
+    }
+}
+
+NAMESPACE_END(nanogui)
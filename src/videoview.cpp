@@ -0,0 +1,325 @@
+/*
+    src/videoview.cpp -- Widget that shows a stream of video frames
+    produced by another thread
+
+    NanoGUI was developed by Wenzel Jakob <wenzel.jakob@epfl.ch>.
+    The widget drawing code is based on the NanoVG demo application
+    by Mikko Mononen.
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+
+#include <nanogui/videoview.h>
+#include <nanogui/threadpool.h>
+#include <nanogui/opengl.h>
+#include <nanogui/glutil.h>
+#include <nanogui/screen.h>
+#include <cstring>
+
+NAMESPACE_BEGIN(nanogui)
+
+int VideoFrame::planeCount(Format format) {
+    switch (format) {
+        case Format::I420: return 3;
+        case Format::NV12: return 2;
+        default: return 1;
+    }
+}
+
+int VideoFrame::planeChannels(Format format, int plane) {
+    switch (format) {
+        case Format::I420: return 1;
+        case Format::NV12: return plane == 0 ? 1 : 2;
+        case Format::RGB: return 3;
+        default: return 4;
+    }
+}
+
+Vector2i VideoFrame::planeSize(Format format, const Vector2i &size, int plane) {
+    bool subsampled = plane > 0 && (format == Format::I420 || format == Format::NV12);
+    return subsampled ? Vector2i((size.array() + 1) / 2) : size;
+}
+
+size_t VideoFrame::frameBytes(Format format, const Vector2i &size) {
+    size_t bytes = 0;
+    for (int i = 0; i < planeCount(format); ++i)
+        bytes += (size_t) planeSize(format, size, i).prod() * planeChannels(format, i);
+    return bytes;
+}
+
+size_t VideoFrame::planeOffset(int plane) const {
+    size_t offset = 0;
+    for (int i = 0; i < plane; ++i)
+        offset += (size_t) planeSize(format, size, i).prod() * planeChannels(format, i);
+    return offset;
+}
+
+VideoFrameBuffer::VideoFrameBuffer()
+    : mBack(0), mReady(1), mFront(2), mFresh(false), mSubmitted(0), mDropped(0) { }
+
+VideoFrame &VideoFrameBuffer::acquire(VideoFrame::Format format, const Vector2i &size,
+                                      double timestamp) {
+    /* Only the producer changes mBack, so it can be read without locking */
+    VideoFrame &frame = mFrames[mBack];
+    frame.format = format;
+    frame.size = size;
+    frame.timestamp = timestamp;
+    frame.data.resize(VideoFrame::frameBytes(format, size));
+    return frame;
+}
+
+void VideoFrameBuffer::submit() {
+    {
+        std::lock_guard<std::mutex> guard(mMutex);
+        std::swap(mBack, mReady);
+        if (mFresh)
+            mDropped++;
+        mFresh = true;
+        mSubmitted++;
+    }
+    ThreadPool::wakeup();
+}
+
+void VideoFrameBuffer::push(VideoFrame::Format format, const Vector2i &size,
+                            const uint8_t *const *planes, const int *strides, double timestamp) {
+    VideoFrame &frame = acquire(format, size, timestamp);
+    for (int i = 0; i < VideoFrame::planeCount(format); ++i) {
+        Vector2i planeSize = VideoFrame::planeSize(format, size, i);
+        size_t rowBytes = (size_t) planeSize.x() * VideoFrame::planeChannels(format, i);
+        size_t stride = strides && strides[i] ? (size_t) strides[i] : rowBytes;
+        uint8_t *target = frame.plane(i);
+        if (stride == rowBytes) {
+            memcpy(target, planes[i], rowBytes * planeSize.y());
+            continue;
+        }
+        for (int y = 0; y < planeSize.y(); ++y)
+            memcpy(target + y * rowBytes, planes[i] + y * stride, rowBytes);
+    }
+    submit();
+}
+
+const VideoFrame *VideoFrameBuffer::consume() {
+    std::lock_guard<std::mutex> guard(mMutex);
+    if (!mFresh)
+        return nullptr;
+    std::swap(mFront, mReady);
+    mFresh = false;
+    return &mFrames[mFront];
+}
+
+VideoView::VideoView(Widget *parent)
+    : Widget(parent), mFrames(new VideoFrameBuffer()), mColorSpace(ColorSpace::BT709),
+      mFullRange(false), mBackgroundColor(0, 255), mTimestamp(0), mGpuFailed(false),
+      mConvertDirty(false), mShader(nullptr), mPlaneTextures { 0, 0, 0 }, mPixelBuffer(0),
+      mTarget(new GLRenderTexture()), mTextureFormat(VideoFrame::Format::RGBA),
+      mTextureSize(Vector2i::Zero()) { }
+
+VideoView::~VideoView() {
+    Screen *screen = this->screen();
+    mTarget->free(screen ? screen->nvgContext() : nullptr);
+    delete mTarget;
+    if (mShader) {
+        mShader->free();
+        delete mShader;
+    }
+    glDeleteTextures(3, mPlaneTextures);
+    if (mPixelBuffer)
+        glDeleteBuffers(1, &mPixelBuffer);
+}
+
+Vector2i VideoView::preferredSize(NVGcontext *) const {
+    return mTextureSize.prod() > 0 ? mTextureSize : Vector2i(320, 240);
+}
+
+bool VideoView::initShader() {
+    if (mShader)
+        return true;
+    if (mGpuFailed)
+        return false;
+
+    /* All video views of a screen convert with the same program */
+    Screen *screen = this->screen();
+    const GLShader *program = screen ? screen->sharedShader(
+        "video_shader",
+
+        /* Vertex shader: a single triangle covering the viewport. Row 0
+           of the target receives row 0 of the frame, so the result is
+           drawn by NanoVG without flipping. */
+        "#version 330\n"
+        "out vec2 uv;\n"
+        "void main() {\n"
+        "    uv = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);\n"
+        "    gl_Position = vec4(2.0 * uv - 1.0, 0.0, 1.0);\n"
+        "}",
+
+        /* Fragment shader */
+        "#version 330\n"
+        "uniform int format;\n"
+        "uniform sampler2D plane0, plane1, plane2;\n"
+        "uniform mat4 conversion;\n"
+        "in vec2 uv;\n"
+        "out vec4 outColor;\n"
+        "void main() {\n"
+        "    if (format >= 2) {\n"
+        "        outColor = texture(plane0, uv);\n"
+        "        return;\n"
+        "    }\n"
+        "    vec3 ycc = vec3(texture(plane0, uv).r, 0.0, 0.0);\n"
+        "    if (format == 0)\n"
+        "        ycc.yz = vec2(texture(plane1, uv).r, texture(plane2, uv).r);\n"
+        "    else\n"
+        "        ycc.yz = texture(plane1, uv).rg;\n"
+        "    outColor = vec4(clamp((conversion * vec4(ycc, 1.0)).rgb, 0.0, 1.0), 1.0);\n"
+        "}"
+    ) : nullptr;
+    if (!program) {
+        mGpuFailed = true;
+        return false;
+    }
+    mShader = new GLShader();
+    mShader->initShared(*program);
+    mUniformFormat = mShader->uniformHandle("format");
+    mUniformConversion = mShader->uniformHandle("conversion", false);
+    for (int i = 0; i < 3; ++i)
+        mUniformPlanes[i] = mShader->uniformHandle("plane" + std::to_string(i), false);
+    return true;
+}
+
+Matrix4f VideoView::conversionMatrix() const {
+    float kr = 0.2126f, kb = 0.0722f;
+    if (mColorSpace == ColorSpace::BT601) {
+        kr = 0.299f;
+        kb = 0.114f;
+    }
+    float kg = 1.f - kr - kb;
+
+    Matrix3f toRgb;
+    toRgb << 1.f, 0.f, 2.f * (1.f - kr),
+             1.f, -2.f * kb * (1.f - kb) / kg, -2.f * kr * (1.f - kr) / kg,
+             1.f, 2.f * (1.f - kb), 0.f;
+
+    Vector3f scale = Vector3f::Ones(), offset(0.f, 128.f / 255.f, 128.f / 255.f);
+    if (!mFullRange) {
+        scale = Vector3f(255.f / 219.f, 255.f / 224.f, 255.f / 224.f);
+        offset.x() = 16.f / 255.f;
+    }
+
+    Matrix3f linear = toRgb * scale.asDiagonal();
+    Matrix4f result = Matrix4f::Identity();
+    result.topLeftCorner<3, 3>() = linear;
+    result.topRightCorner<3, 1>() = -linear * offset;
+    return result;
+}
+
+void VideoView::uploadFrame(NVGcontext *ctx, const VideoFrame &frame) {
+    static const GLenum formats[] = { GL_RED, GL_RG, GL_RGB, GL_RGBA };
+    static const GLenum internalFormats[] = { GL_R8, GL_RG8, GL_RGB8, GL_RGBA8 };
+    int planes = VideoFrame::planeCount(frame.format);
+
+    if (frame.format != mTextureFormat || frame.size != mTextureSize) {
+        for (int i = 0; i < planes; ++i) {
+            Vector2i size = VideoFrame::planeSize(frame.format, frame.size, i);
+            int channels = VideoFrame::planeChannels(frame.format, i);
+            if (!mPlaneTextures[i])
+                glGenTextures(1, &mPlaneTextures[i]);
+            glBindTexture(GL_TEXTURE_2D, mPlaneTextures[i]);
+            glTexImage2D(GL_TEXTURE_2D, 0, internalFormats[channels - 1], size.x(), size.y(), 0,
+                         formats[channels - 1], GL_UNSIGNED_BYTE, nullptr);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        }
+
+        mTarget->resize(ctx, frame.size, 0);
+        mTextureFormat = frame.format;
+        mTextureSize = frame.size;
+    }
+
+    /* Reallocating the storage of the pixel buffer ("orphaning") lets the
+       driver hand out fresh memory while transfers of the previous frame
+       may still read from the old one, and the plane uploads below become
+       asynchronous copies out of the buffer */
+    size_t bytes = frame.data.size();
+    if (!mPixelBuffer)
+        glGenBuffers(1, &mPixelBuffer);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, mPixelBuffer);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, (GLsizeiptr) bytes, nullptr, GL_STREAM_DRAW);
+    void *target = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, (GLsizeiptr) bytes,
+                                    GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (target) {
+        memcpy(target, frame.data.data(), bytes);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    } else {
+        glBufferSubData(GL_PIXEL_UNPACK_BUFFER, 0, (GLsizeiptr) bytes, frame.data.data());
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (int i = 0; i < planes; ++i) {
+        Vector2i size = VideoFrame::planeSize(frame.format, frame.size, i);
+        int channels = VideoFrame::planeChannels(frame.format, i);
+        glBindTexture(GL_TEXTURE_2D, mPlaneTextures[i]);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, size.x(), size.y(), formats[channels - 1],
+                        GL_UNSIGNED_BYTE, (const void *) frame.planeOffset(i));
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    /* NanoVG uploads from client memory, which requires the buffer to be unbound */
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    mTimestamp = frame.timestamp;
+    mConvertDirty = true;
+}
+
+void VideoView::convertFrame() {
+    mTarget->bind();
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_SCISSOR_TEST);
+    glDisable(GL_BLEND);
+
+    int planes = VideoFrame::planeCount(mTextureFormat);
+    mShader->bind();
+    mShader->setUniform(mUniformFormat, (int) mTextureFormat);
+    mShader->setUniform(mUniformConversion, conversionMatrix());
+    for (int i = 0; i < planes; ++i) {
+        glActiveTexture(GL_TEXTURE0 + i);
+        glBindTexture(GL_TEXTURE_2D, mPlaneTextures[i]);
+        mShader->setUniform(mUniformPlanes[i], i);
+    }
+    mShader->drawArray(GL_TRIANGLES, 0, 3);
+    glActiveTexture(GL_TEXTURE0);
+
+    mTarget->release();
+    mConvertDirty = false;
+}
+
+void VideoView::draw(NVGcontext *ctx) {
+    /* Only the most recent frame is uploaded, older ones were dropped by the buffer */
+    const VideoFrame *frame = mFrames->consume();
+    if (frame && frame->size.minCoeff() > 0 && initShader())
+        uploadFrame(ctx, *frame);
+    int image = mTarget->image();
+    if (mConvertDirty && image)
+        convertFrame();
+
+    nvgBeginPath(ctx);
+    nvgRect(ctx, mPos.x(), mPos.y(), mSize.x(), mSize.y());
+    nvgFillColor(ctx, mBackgroundColor);
+    nvgFill(ctx);
+
+    if (image) {
+        /* Fit the frame into the widget, preserving the aspect ratio */
+        float scale = (mSize.cast<float>().array() / mTextureSize.cast<float>().array()).minCoeff();
+        Vector2f size = mTextureSize.cast<float>() * scale;
+        Vector2f pos = mPos.cast<float>() + (mSize.cast<float>() - size) * 0.5f;
+        NVGpaint paint = nvgImagePattern(ctx, pos.x(), pos.y(), size.x(), size.y(), 0, image, 1.f);
+        nvgBeginPath(ctx);
+        nvgRect(ctx, pos.x(), pos.y(), size.x(), size.y());
+        nvgFillPaint(ctx, paint);
+        nvgFill(ctx);
+    }
+
+    Widget::draw(ctx);
+}
+
+NAMESPACE_END(nanogui)
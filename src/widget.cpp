@@ -16,6 +16,9 @@
 #include <nanogui/opengl.h>
 #include <nanogui/screen.h>
 #include <nanogui/serializer/core.h>
+#include <cstring>
+#include <limits>
+#include <unordered_map>
 
 NAMESPACE_BEGIN(nanogui)
 
@@ -48,6 +51,60 @@ int Widget::fontSize() const {
     return (mFontSize < 0 && mTheme) ? mTheme->mStandardFontSize : mFontSize;
 }
 
+Vector4f Widget::visibleArea() const {
+    Vector2i clipMin = Vector2i::Constant(std::numeric_limits<int>::min()),
+             clipMax = Vector2i::Constant(std::numeric_limits<int>::max());
+    for (const Widget *w = parent(); w; w = w->parent()) {
+        Vector2i pos = w->absolutePosition();
+        clipMin = clipMin.cwiseMax(pos);
+        clipMax = clipMax.cwiseMin(pos + w->size());
+    }
+    return Vector4f(clipMin.x(), clipMin.y(), clipMax.x(), clipMax.y());
+}
+
+/* UTF-8 encoding and length of an icon, computed once per code point (widgets
+   are only drawn from the main thread) */
+typedef std::pair<std::array<char, 8>, size_t> IconString;
+
+static const IconString &iconString(int icon) {
+    static std::unordered_map<int, IconString> cache;
+    auto it = cache.find(icon);
+    if (it == cache.end()) {
+        std::array<char, 8> seq = utf8(icon);
+        it = cache.emplace(icon, IconString(seq, std::strlen(seq.data()))).first;
+    }
+    return it->second;
+}
+
+float Widget::drawIcon(NVGcontext *ctx, int icon, float x, float y, float size,
+                       int align, const Color &color) {
+    SdfFont *font = mTheme->mSdfText ? mTheme->sdfFont("icons") : nullptr;
+    Screen *screen = font ? this->screen() : nullptr;
+    if (screen)
+        return screen->sdfText()->glyph(ctx, font, icon, x, y, size, align,
+                                        color, visibleArea());
+
+    const IconString &str = iconString(icon);
+    nvgFontFaceId(ctx, mTheme->mFontIcons);
+    nvgFontSize(ctx, size);
+    nvgTextAlign(ctx, align);
+    nvgFillColor(ctx, color);
+    return nvgText(ctx, x, y, str.first.data(), str.first.data() + str.second) - x;
+}
+
+float Widget::iconWidth(NVGcontext *ctx, int icon, float size) {
+    SdfFont *font = mTheme->mSdfText ? mTheme->sdfFont("icons") : nullptr;
+    if (font) {
+        const SdfFont::Glyph *g = font->glyph(icon);
+        return g ? g->advance * size / font->baseSize() : 0.f;
+    }
+
+    const IconString &str = iconString(icon);
+    nvgFontFaceId(ctx, mTheme->mFontIcons);
+    nvgFontSize(ctx, size);
+    return nvgTextBounds(ctx, 0, 0, str.first.data(), str.first.data() + str.second, nullptr);
+}
+
 Vector2i Widget::preferredSize(NVGcontext *ctx) const {
     if (mLayout)
         return mLayout->preferredSize(ctx, this);
@@ -189,6 +246,17 @@ void Widget::requestFocus() {
     ((Screen *) widget)->updateFocus(this);
 }
 
+Screen *Widget::screen() {
+    Widget *widget = this;
+    while (widget) {
+        Screen *screen = dynamic_cast<Screen *>(widget);
+        if (screen)
+            return screen;
+        widget = widget->parent();
+    }
+    return nullptr;
+}
+
 void Widget::draw(NVGcontext *ctx) {
     #if NANOGUI_SHOW_WIDGET_BOUNDS
         nvgStrokeWidth(ctx, 1.0f);